@@ -0,0 +1,116 @@
+// Multi-threaded read throughput of the published clock state.
+//
+// Compares the mutex-guarded state the clock used to read on every call with
+// the sequence-locked PublishedClock, while a writer republishes once per
+// millisecond. Usage: clock_read_bench [max_threads] [millis_per_run]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/clock_state.h"
+#include "core/monotonic.h"
+
+using clockcore::ClockSample;
+
+namespace {
+
+struct MutexClock {
+    mutable std::mutex mutex;
+    ClockSample sample;
+
+    void Publish(const ClockSample& next) {
+        std::lock_guard<std::mutex> lock(mutex);
+        sample = next;
+    }
+    bool TryNow(uint64_t monoNow, uint64_t& utcOut) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!sample.valid) {
+            return false;
+        }
+        utcOut = clockcore::ExtrapolateUtc(sample, monoNow);
+        return true;
+    }
+};
+
+template <typename Clock>
+double RunReaders(Clock& clock, int threads, int millis) {
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> counts(static_cast<size_t>(threads) * 8, 0); // padded per thread
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            while (!start.load(std::memory_order_acquire)) {
+            }
+            uint64_t reads = 0;
+            uint64_t sink = 0;
+            uint64_t mono = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 256; ++i) {
+                    uint64_t utc = 0;
+                    clock.TryNow(++mono, utc);
+                    sink += utc;
+                }
+                reads += 256;
+            }
+            counts[static_cast<size_t>(t) * 8] = reads + (sink == 1 ? 1 : 0);
+        });
+    }
+
+    std::thread writer([&]() {
+        while (!start.load(std::memory_order_acquire)) {
+        }
+        ClockSample sample;
+        sample.valid = true;
+        while (!stop.load(std::memory_order_relaxed)) {
+            sample.baseUtc += 10000;
+            sample.baseMono = clockcore::MonotonicTicks();
+            clock.Publish(sample);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    writer.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    uint64_t total = 0;
+    for (int t = 0; t < threads; ++t) {
+        total += counts[static_cast<size_t>(t) * 8];
+    }
+    return static_cast<double>(total) / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : static_cast<int>(std::thread::hardware_concurrency());
+    int millis = argc > 2 ? std::atoi(argv[2]) : 300;
+    if (maxThreads < 1) {
+        maxThreads = 1;
+    }
+
+    std::printf("%8s %18s %18s %10s\n", "threads", "mutex Mreads/s", "seqlock Mreads/s", "speedup");
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        MutexClock mutexClock;
+        clockcore::PublishedClock seqClock;
+        double mutexRate = RunReaders(mutexClock, threads, millis);
+        double seqRate = RunReaders(seqClock, threads, millis);
+        std::printf("%8d %18.1f %18.1f %9.1fx\n", threads, mutexRate / 1e6, seqRate / 1e6, seqRate / mutexRate);
+        if (threads < maxThreads && threads * 2 > maxThreads) {
+            threads = maxThreads / 2; // make sure maxThreads itself is measured
+        }
+    }
+    return 0;
+}
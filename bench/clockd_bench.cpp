@@ -0,0 +1,267 @@
+// Throughput and latency of the clock service under a local load generator.
+//
+// By default starts a ClockServer in-process on an ephemeral loopback UDP
+// port; --port or --unix target a running clockd instead. Each client thread
+// runs a closed loop of Convert requests and records every round trip.
+//
+//   clockd_bench [--clients N] [--server-threads N] [--seconds 3]
+//                [--cities K] [--port P | --unix PATH]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/city.h"
+#include "core/clock_protocol.h"
+#include "core/clock_server.h"
+#include "core/monotonic.h"
+#include "core/net.h"
+
+#ifndef _WIN32
+#include <sys/un.h>
+#endif
+
+using namespace clockcore;
+
+namespace {
+
+struct ClientStats {
+    std::vector<uint32_t> latencyNs;
+    uint64_t timeouts = 0;
+    uint64_t errors = 0;
+};
+
+// Sample cities: zone-backed where tzdata is available, fixed offsets otherwise.
+std::vector<CityInfo> BenchCities() {
+    static const struct {
+        const wchar_t* name;
+        int offset;
+        const char* zone;
+    } kCities[] = {
+        {L"London", 0, "Europe/London"},         {L"Berlin", 60, "Europe/Berlin"},
+        {L"New York", -300, "America/New_York"}, {L"Los Angeles", -480, "America/Los_Angeles"},
+        {L"Sydney", 600, "Australia/Sydney"},    {L"Auckland", 720, "Pacific/Auckland"},
+        {L"Shanghai", 480, "Asia/Shanghai"},     {L"Tokyo", 540, "Asia/Tokyo"},
+        {L"Kolkata", 330, "Asia/Kolkata"},       {L"Sao Paulo", -180, "America/Sao_Paulo"},
+        {L"Cairo", 120, "Africa/Cairo"},         {L"Chicago", -360, "America/Chicago"},
+        {L"Toronto", -300, "America/Toronto"},   {L"Mexico City", -360, "America/Mexico_City"},
+        {L"Paris", 60, "Europe/Paris"},          {L"Dubai", 240, "Asia/Dubai"},
+    };
+    std::vector<CityInfo> cities;
+    uint64_t now = SystemFileTime();
+    for (const auto& entry : kCities) {
+        CityInfo city;
+        city.name = entry.name;
+        city.offsetMinutes = entry.offset;
+        city.zoneId = entry.zone;
+        PrimeCityCache(city, now);
+        cities.push_back(std::move(city));
+    }
+    return cities;
+}
+
+SocketHandle ConnectClient(const std::string& unixPath, const std::string& port) {
+#ifndef _WIN32
+    if (!unixPath.empty()) {
+        SocketHandle sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+        sockaddr_un self = {};
+        self.sun_family = AF_UNIX;
+        // Linux autobind: an abstract reply address the server can answer.
+        bind(sock, reinterpret_cast<const sockaddr*>(&self), sizeof(sa_family_t));
+        sockaddr_un server = {};
+        server.sun_family = AF_UNIX;
+        std::memcpy(server.sun_path, unixPath.data(), std::min(unixPath.size(), sizeof(server.sun_path) - 1));
+        SockLen length = static_cast<SockLen>(offsetof(sockaddr_un, sun_path) + unixPath.size());
+        if (unixPath[0] == '@') {
+            server.sun_path[0] = '\0';
+        } else {
+            length += 1;
+        }
+        if (connect(sock, reinterpret_cast<const sockaddr*>(&server), length) != 0) {
+            CloseSocket(sock);
+            return kInvalidSocket;
+        }
+        return sock;
+    }
+#endif
+    sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_port = htons(static_cast<uint16_t>(std::atoi(port.c_str())));
+    inet_pton(AF_INET, "127.0.0.1", &server.sin_addr);
+    SocketHandle sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock != kInvalidSocket && connect(sock, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) != 0) {
+        CloseSocket(sock);
+        return kInvalidSocket;
+    }
+    return sock;
+}
+
+// Number of cities the server knows, or 0 if it does not answer.
+size_t QueryCityCount(SocketHandle sock) {
+    uint8_t buffer[kMaxDatagramSize];
+    size_t length = EncodeListCitiesRequest(1, buffer, sizeof(buffer));
+    send(sock, reinterpret_cast<const char*>(buffer), static_cast<int>(length), 0);
+    if (WaitReadable(sock, 1000) <= 0) {
+        return 0;
+    }
+    int received = static_cast<int>(recv(sock, reinterpret_cast<char*>(buffer), static_cast<int>(sizeof(buffer)), 0));
+    ClockResponse response;
+    if (received <= 0 || !DecodeClockResponse(buffer, static_cast<size_t>(received), response) || response.status != ClockStatus::Ok) {
+        return 0;
+    }
+    return response.names.size();
+}
+
+void RunClient(SocketHandle sock, int cities, size_t available, const std::atomic<bool>& stop, uint32_t idBase, ClientStats& stats) {
+    std::vector<uint16_t> indices(static_cast<size_t>(cities));
+    for (size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = static_cast<uint16_t>(i % available);
+    }
+    uint8_t request[kMaxDatagramSize];
+    uint8_t response[kMaxDatagramSize];
+    uint32_t id = idBase;
+    while (!stop.load(std::memory_order_relaxed)) {
+        ++id;
+        size_t length = EncodeConvertRequest(id, kConvertUtcNow, indices.data(), indices.size(), request, sizeof(request));
+        auto start = std::chrono::steady_clock::now();
+        if (send(sock, reinterpret_cast<const char*>(request), static_cast<int>(length), 0) != static_cast<int>(length)) {
+            ++stats.errors;
+            continue;
+        }
+        // Skip late replies to earlier, timed-out requests.
+        for (;;) {
+            if (WaitReadable(sock, 1000) <= 0) {
+                ++stats.timeouts;
+                break;
+            }
+            int received = static_cast<int>(recv(sock, reinterpret_cast<char*>(response), static_cast<int>(sizeof(response)), 0));
+            ClockResponse decoded;
+            if (received <= 0 || !DecodeClockResponse(response, static_cast<size_t>(received), decoded)) {
+                ++stats.errors;
+                break;
+            }
+            if (decoded.requestId != id) {
+                continue;
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            if (decoded.status != ClockStatus::Ok || decoded.offsets.size() != indices.size()) {
+                ++stats.errors;
+            }
+            stats.latencyNs.push_back(static_cast<uint32_t>(std::min<long long>(elapsed, 0xFFFFFFFFll)));
+            break;
+        }
+    }
+}
+
+double PercentileUs(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return static_cast<double>(sorted[index]) / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int clients = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    unsigned serverThreads = 0;
+    double seconds = 3;
+    int cities = 4;
+    std::string port;
+    std::string unixPath;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--clients") == 0) {
+            clients = std::max(1, std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--server-threads") == 0) {
+            serverThreads = static_cast<unsigned>(std::atoi(argv[i + 1]));
+        } else if (std::strcmp(argv[i], "--seconds") == 0) {
+            seconds = std::atof(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--cities") == 0) {
+            cities = std::clamp(std::atoi(argv[i + 1]), 1, static_cast<int>(kMaxConvertCities));
+        } else if (std::strcmp(argv[i], "--port") == 0) {
+            port = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--unix") == 0) {
+            unixPath = argv[i + 1];
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    InitializeNetworking();
+
+    ClockServer server;
+    bool inProcess = port.empty() && unixPath.empty();
+    if (inProcess) {
+        ClockServerOptions options;
+        options.port = "0";
+        options.threads = serverThreads;
+        std::string error;
+        if (!server.Start(BenchCities(), nullptr, options, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        port = server.boundPort();
+        std::printf("in-process server on 127.0.0.1:%s, %u threads\n", port.c_str(), server.threadCount());
+    }
+
+    std::vector<SocketHandle> sockets;
+    for (int c = 0; c < clients; ++c) {
+        SocketHandle sock = ConnectClient(unixPath, port);
+        if (sock == kInvalidSocket) {
+            std::fprintf(stderr, "cannot connect client %d\n", c);
+            return 1;
+        }
+        sockets.push_back(sock);
+    }
+
+    size_t available = QueryCityCount(sockets.front());
+    if (available == 0) {
+        std::fprintf(stderr, "server did not answer ListCities\n");
+        return 1;
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<ClientStats> stats(static_cast<size_t>(clients));
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back(RunClient, sockets[static_cast<size_t>(c)], cities, available, std::cref(stop),
+                             static_cast<uint32_t>(c) << 24, std::ref(stats[static_cast<size_t>(c)]));
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint32_t> all;
+    uint64_t timeouts = 0;
+    uint64_t errors = 0;
+    for (const auto& s : stats) {
+        all.insert(all.end(), s.latencyNs.begin(), s.latencyNs.end());
+        timeouts += s.timeouts;
+        errors += s.errors;
+    }
+    std::sort(all.begin(), all.end());
+    std::printf("clients %d, %d cities/request: %.0f req/s (%.0f city conversions/s)\n", clients, cities,
+                static_cast<double>(all.size()) / elapsed, static_cast<double>(all.size()) * cities / elapsed);
+    std::printf("latency us: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", PercentileUs(all, 0.5), PercentileUs(all, 0.9),
+                PercentileUs(all, 0.99), PercentileUs(all, 0.999), all.empty() ? 0.0 : static_cast<double>(all.back()) / 1000.0);
+    std::printf("timeouts %llu, errors %llu\n", static_cast<unsigned long long>(timeouts), static_cast<unsigned long long>(errors));
+
+    for (SocketHandle sock : sockets) {
+        CloseSocket(sock);
+    }
+    server.Stop();
+    ShutdownNetworking();
+    return errors == 0 ? 0 : 1;
+}
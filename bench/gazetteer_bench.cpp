@@ -0,0 +1,193 @@
+// Per-keystroke latency of the city search.
+//
+// Types names one character at a time, as the Add City dialog sees them, and
+// times each Search for the top 8; then repeats with one typo (substitution,
+// deletion, insertion or transposition) per name. The baseline is the linear
+// scan the dialog used to do: compare every normalized name, then rank the
+// hits by population. Without --index a synthetic gazetteer is generated.
+//
+//   gazetteer_bench [--index gazetteer.idx] [--cities 150000] [--queries 2000]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/gazetteer.h"
+#include "core/metrics.h"
+
+using namespace clockcore;
+
+namespace {
+
+constexpr size_t kMaxResults = 8;
+
+std::vector<GazetteerRecord> SyntheticCities(size_t count, std::mt19937& rng) {
+    static const char* const kSyllables[] = {"ba", "ber", "ca", "chi", "dan", "del", "es", "fa", "gor", "ha", "in", "jo",
+                                             "ka", "kov", "la", "lin", "ma", "mon", "na", "no", "or", "pa", "pol", "qu",
+                                             "ra", "ros", "sa", "san", "ta", "ton", "u", "va", "vil", "wa", "yo", "zu"};
+    static const char* const kZones[] = {"Europe/Berlin", "America/New_York", "Asia/Tokyo", "Australia/Sydney",
+                                         "America/Sao_Paulo", "Africa/Cairo", "Asia/Kolkata", "Europe/London"};
+    std::uniform_int_distribution<int> syllable(0, static_cast<int>(std::size(kSyllables)) - 1);
+    std::uniform_int_distribution<int> length(2, 4);
+    std::uniform_int_distribution<int> zone(0, static_cast<int>(std::size(kZones)) - 1);
+    std::vector<GazetteerRecord> records(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string name;
+        for (int n = length(rng); n > 0; --n) {
+            name += kSyllables[syllable(rng)];
+        }
+        name[0] = static_cast<char>(name[0] - 'a' + 'A');
+        if (rng() % 8 == 0) {
+            name += rng() % 2 ? " Springs" : "-sur-Mer";
+        }
+        records[i].name = name;
+        records[i].country = "XX";
+        records[i].zoneId = kZones[zone(rng)];
+        records[i].population = static_cast<uint32_t>(20000000.0 / static_cast<double>(i + 1)); // Zipf-like
+    }
+    return records;
+}
+
+// What the dialog did before the index, minus the UTF-16 conversions.
+class LinearSearch {
+public:
+    explicit LinearSearch(const Gazetteer& gazetteer) : gazetteer_(gazetteer) {
+        for (uint32_t i = 0; i < gazetteer.size(); ++i) {
+            keys_.push_back(NormalizeSearchKey(gazetteer.entry(i).name));
+        }
+    }
+
+    size_t Search(const std::string& query) const {
+        std::string key = NormalizeSearchKey(query);
+        std::vector<uint32_t> hits;
+        for (uint32_t i = 0; i < keys_.size(); ++i) {
+            if (keys_[i].compare(0, key.size(), key) == 0) {
+                hits.push_back(i);
+            }
+        }
+        size_t keep = std::min(hits.size(), kMaxResults);
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(keep), hits.end(), [&](uint32_t a, uint32_t b) {
+            return gazetteer_.entry(a).population > gazetteer_.entry(b).population;
+        });
+        return keep;
+    }
+
+private:
+    const Gazetteer& gazetteer_;
+    std::vector<std::string> keys_;
+};
+
+std::string WithTypo(std::string name, std::mt19937& rng) {
+    if (name.size() < 4) {
+        return name;
+    }
+    size_t at = 1 + rng() % (name.size() - 2);
+    switch (rng() % 4) {
+    case 0:
+        name[at] = name[at] == 'x' ? 'q' : 'x';
+        break;
+    case 1:
+        name.erase(at, 1);
+        break;
+    case 2:
+        name.insert(at, 1, 'e');
+        break;
+    default:
+        std::swap(name[at], name[at + 1]);
+        break;
+    }
+    return name;
+}
+
+template <typename F>
+void TimeKeystrokes(Histogram& nanos, const std::string& name, size_t minLength, F&& search) {
+    for (size_t n = minLength; n <= name.size(); ++n) {
+        std::string typed = name.substr(0, n);
+        auto begin = std::chrono::steady_clock::now();
+        search(typed);
+        nanos.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+    }
+}
+
+void Print(const char* label, const Histogram& nanos) {
+    auto us = [&](double q) { return static_cast<double>(nanos.ValueAtQuantile(q)) / 1000.0; };
+    std::printf("%-22s %8llu searches  us p50 %8.2f  p99 %8.2f  max %8.2f\n", label, static_cast<unsigned long long>(nanos.count()),
+                us(0.5), us(0.99), static_cast<double>(nanos.max()) / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string indexPath;
+    size_t cityCount = 150000;
+    size_t queryCount = 2000;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--index") == 0 && hasValue) {
+            indexPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--cities") == 0 && hasValue) {
+            cityCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--queries") == 0 && hasValue) {
+            queryCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(12345);
+    Gazetteer gazetteer;
+    auto loadBegin = std::chrono::steady_clock::now();
+    if (!indexPath.empty()) {
+        if (!gazetteer.Open(indexPath)) {
+            std::fprintf(stderr, "cannot open index %s\n", indexPath.c_str());
+            return 1;
+        }
+    } else {
+        std::vector<unsigned char> bytes = BuildGazetteerIndex(SyntheticCities(cityCount, rng));
+        std::printf("synthetic index: %.1f MB\n", static_cast<double>(bytes.size()) / (1 << 20));
+        gazetteer.Load(std::move(bytes));
+    }
+    std::printf("%zu cities, build/open %.1f ms\n", gazetteer.size(),
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadBegin).count());
+    if (gazetteer.size() == 0) {
+        return 1;
+    }
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < queryCount; ++i) {
+        names.push_back(gazetteer.entry(static_cast<uint32_t>(rng() % gazetteer.size())).name);
+    }
+
+    size_t sink = 0;
+    Histogram prefix, typo, linear;
+    for (const auto& name : names) {
+        TimeKeystrokes(prefix, name, 1, [&](const std::string& q) { sink += gazetteer.Search(q, kMaxResults).size(); });
+    }
+    size_t found = 0;
+    for (const auto& name : names) {
+        std::string typed = WithTypo(name, rng);
+        TimeKeystrokes(typo, typed, 3, [&](const std::string& q) { sink += gazetteer.Search(q, kMaxResults).size(); });
+        auto matches = gazetteer.Search(typed, kMaxResults);
+        found += std::any_of(matches.begin(), matches.end(),
+                             [&](const GazetteerMatch& m) { return std::strcmp(gazetteer.entry(m.entry).name, name.c_str()) == 0; });
+    }
+    LinearSearch baseline(gazetteer);
+    for (size_t i = 0; i < std::min<size_t>(names.size(), 100); ++i) {
+        TimeKeystrokes(linear, names[i], 1, [&](const std::string& q) { sink += baseline.Search(q); });
+    }
+
+    Print("trie, as typed", prefix);
+    Print("trie, one typo", typo);
+    Print("linear scan, as typed", linear);
+    std::printf("%.1f results per search; typo'd names whose city was in the top %zu: %.1f%%\n",
+                static_cast<double>(sink) / static_cast<double>(prefix.count() + typo.count() + linear.count()), kMaxResults,
+                100.0 * static_cast<double>(found) / static_cast<double>(names.size()));
+    return 0;
+}
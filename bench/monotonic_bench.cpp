@@ -0,0 +1,80 @@
+// Cost and resolution of each monotonic clock source.
+//
+// For every source this platform offers: the mean cost of one read in
+// 100-ns ticks (as MonotonicTicks() pays it), the smallest step seen between
+// consecutive native readings, how many of --reads back-to-back reads went
+// backwards, and the source's rate against steady_clock over --millis
+// (which for the TSC is the calibration error). Ends with the source
+// MonotonicTicks() reads. Usage: monotonic_bench [--reads 2000000] [--millis 500]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "core/monotonic.h"
+
+using namespace clockcore;
+
+namespace {
+
+constexpr MonotonicSource kSources[] = {MonotonicSource::Steady, MonotonicSource::MonotonicRaw, MonotonicSource::Qpc,
+                                        MonotonicSource::Tsc};
+
+uint64_t CountBackwardSteps(MonotonicSource source, int reads) {
+    uint64_t backwards = 0;
+    uint64_t last = ReadMonotonicSource(source);
+    for (int i = 0; i < reads; ++i) {
+        uint64_t now = ReadMonotonicSource(source);
+        backwards += now < last ? 1 : 0;
+        last = now;
+    }
+    return backwards;
+}
+
+// Parts per million the source runs fast against steady_clock.
+double RateAgainstSteady(MonotonicSource source, int millis) {
+    uint64_t steadyBegin = ReadMonotonicSource(MonotonicSource::Steady);
+    uint64_t begin = ReadMonotonicSource(source);
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    uint64_t steadyEnd = ReadMonotonicSource(MonotonicSource::Steady);
+    uint64_t end = ReadMonotonicSource(source);
+    double elapsed = static_cast<double>(steadyEnd - steadyBegin);
+    return (static_cast<double>(end - begin) - elapsed) / elapsed * 1e6;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int reads = 2000000;
+    int millis = 500;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--reads") == 0 && hasValue) {
+            reads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--millis") == 0 && hasValue) {
+            millis = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::printf("%-8s %12s %16s %10s %14s\n", "source", "ns/read", "resolution ns", "backwards", "ppm vs steady");
+    for (MonotonicSource source : kSources) {
+        if (!IsMonotonicSourceAvailable(source)) {
+            std::printf("%-8s %12s\n", MonotonicSourceName(source), "unavailable");
+            continue;
+        }
+        MonotonicSourceReport report = MeasureMonotonicSource(source, reads);
+        uint64_t backwards = CountBackwardSteps(source, reads);
+        double ppm = RateAgainstSteady(source, millis);
+        std::printf("%-8s %12.2f %16.2f %10llu %14.2f\n", MonotonicSourceName(source), report.readNanos, report.resolutionNanos,
+                    static_cast<unsigned long long>(backwards), ppm);
+    }
+
+    std::printf("MonotonicTicks() reads %s\n", MonotonicSourceName(ActiveMonotonicSource()));
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Throughput of bulk UTC-to-local conversion for one city.
+//
+// Converts --instants FILETIME values per city, once spread at random over
+// 1970-2100 and once as a sorted log-like stream (steps of up to a few
+// seconds), through the per-instant GetCityOffsetMinutes path and through an
+// OffsetTable with each kernel this CPU supports. Reports the best of
+// --repeat runs in nanoseconds and millions of instants per second; every
+// kernel's output is compared with the per-instant result first.
+//
+//   offset_bench [--instants 4000000] [--repeat 5] [--zone America/New_York]...
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/calendar.h"
+#include "core/city.h"
+#include "core/offset_table.h"
+
+using namespace clockcore;
+
+namespace {
+
+constexpr OffsetKernel kKernels[] = {OffsetKernel::Scalar, OffsetKernel::Sse2, OffsetKernel::Avx2};
+
+uint64_t Utc(int year) {
+    CivilTime civil;
+    civil.year = year;
+    return FileTimeFromCivil(civil);
+}
+
+template <typename F>
+double BestNanosPerInstant(int repeat, size_t count, F&& run) {
+    double best = 1e300;
+    for (int r = 0; r < repeat; ++r) {
+        auto begin = std::chrono::steady_clock::now();
+        run();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        best = std::min(best, ns / static_cast<double>(count));
+    }
+    return best;
+}
+
+void Print(const char* label, double nanos, double baseline) {
+    std::printf("  %-26s %7.2f ns/instant %8.1f M/s %7.1fx\n", label, nanos, 1000.0 / nanos, baseline / nanos);
+}
+
+bool RunCity(const char* label, const CityInfo& prototype, size_t count, int repeat) {
+    const uint64_t from = Utc(1970);
+    const uint64_t until = Utc(2101);
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> randomInstants(count);
+    std::uniform_int_distribution<uint64_t> pick(from, until - 1);
+    for (auto& t : randomInstants) {
+        t = pick(rng);
+    }
+    std::vector<uint64_t> sortedInstants(count);
+    std::uniform_int_distribution<uint64_t> step(0, 3 * kTicksPerSecond);
+    uint64_t t = Utc(2024);
+    for (auto& s : sortedInstants) {
+        s = t += step(rng);
+    }
+
+    OffsetTable table;
+    auto buildBegin = std::chrono::steady_clock::now();
+    if (!table.Build(prototype, TimeUnit::FileTime, static_cast<int64_t>(from), static_cast<int64_t>(until))) {
+        std::printf("%s: transitions too dense for a table\n", label);
+        return true;
+    }
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildBegin).count();
+    std::printf("%s: %zu transitions, %zu buckets of 2^%d ticks (%.1f KB), built in %.2f ms\n", label, table.transitionCount(),
+                table.bucketCount(), table.shift(), static_cast<double>(table.bucketCount() * 16) / 1024.0, buildMs);
+
+    bool ok = true;
+    std::vector<uint64_t> expected(count);
+    std::vector<uint64_t> local(count);
+    const struct {
+        const char* name;
+        const std::vector<uint64_t>& instants;
+    } kInputs[] = {{"random", randomInstants}, {"sorted", sortedInstants}};
+    for (const auto& input : kInputs) {
+        CityInfo city = prototype;
+        PrimeCityCache(city, input.instants[0]);
+        double perInstant = BestNanosPerInstant(repeat, count, [&] {
+            for (size_t i = 0; i < count; ++i) {
+                int64_t offsetMinutes = GetCityOffsetMinutes(city, input.instants[i]);
+                expected[i] = input.instants[i] + static_cast<uint64_t>(offsetMinutes * kTicksPerMinute);
+            }
+        });
+        std::printf(" %s instants\n", input.name);
+        Print("GetCityOffsetMinutes", perInstant, perInstant);
+        for (OffsetKernel kernel : kKernels) {
+            if (!IsOffsetKernelSupported(kernel)) {
+                continue;
+            }
+            const int64_t* in = reinterpret_cast<const int64_t*>(input.instants.data());
+            int64_t* out = reinterpret_cast<int64_t*>(local.data());
+            table.ToLocal(in, out, count, kernel);
+            if (local != expected) {
+                std::printf("  %s: output differs from GetCityOffsetMinutes\n", OffsetKernelName(kernel));
+                ok = false;
+                continue;
+            }
+            std::string name = std::string("table, ") + OffsetKernelName(kernel);
+            Print(name.c_str(), BestNanosPerInstant(repeat, count, [&] { table.ToLocal(in, out, count, kernel); }), perInstant);
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = 4000000;
+    int repeat = 5;
+    std::vector<std::string> zones;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--instants") == 0 && hasValue) {
+            count = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && hasValue) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--zone") == 0 && hasValue) {
+            zones.push_back(argv[++i]);
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (zones.empty()) {
+        zones = {"America/New_York", "Australia/Lord_Howe"};
+    }
+    std::printf("best kernel: %s\n", OffsetKernelName(BestOffsetKernel()));
+
+    bool ok = true;
+    CityInfo rules;
+    rules.name = L"Berlin";
+    rules.offsetMinutes = 60;
+    ok &= RunCity("Berlin (rules)", rules, count, repeat);
+    for (const auto& zoneId : zones) {
+        CityInfo city;
+        city.name = L"Zone";
+        city.offsetMinutes = 0;
+        city.zoneId = zoneId;
+        if (!LoadTimeZone(zoneId)) {
+            std::fprintf(stderr, "cannot load zone %s\n", zoneId.c_str());
+            return 2;
+        }
+        ok &= RunCity(zoneId.c_str(), city, count, repeat);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Boundary-to-wakeup latency of the tick scheduler.
+//
+// Runs a TickScheduler for --seconds and reports how long after each UTC
+// period boundary it woke. --naive instead measures a fixed-interval sleep
+// loop (what a plain 1000 ms window timer does): its updates land anywhere
+// within the period and drift. Shorter --period-ms values collect more
+// samples per second of runtime.
+//
+//   tick_bench [--seconds 10] [--period-ms 1000] [--naive]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "core/calendar.h"
+#include "core/monotonic.h"
+#include "core/tick_scheduler.h"
+
+using namespace clockcore;
+
+namespace {
+
+void Print(const char* label, const Histogram& latency) {
+    auto us = [&](double q) { return static_cast<unsigned long long>(latency.ValueAtQuantile(q)); };
+    std::printf("%s: %llu ticks, latency us p50 %llu  p90 %llu  p99 %llu  max %llu\n", label,
+                static_cast<unsigned long long>(latency.count()), us(0.5), us(0.9), us(0.99),
+                static_cast<unsigned long long>(latency.max()));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = 10;
+    int periodMs = 1000;
+    bool naive = false;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            seconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--period-ms") == 0 && hasValue) {
+            periodMs = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--naive") == 0) {
+            naive = true;
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    const int64_t period = static_cast<int64_t>(periodMs) * 10000;
+
+    if (naive) {
+        Histogram lag;
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(periodMs));
+            uint64_t now = SystemFileTime();
+            lag.Record(static_cast<int64_t>(now % static_cast<uint64_t>(period)) / kTicksPerMicrosecond);
+        }
+        Print("fixed-interval sleep", lag);
+        return 0;
+    }
+
+    TickSchedulerOptions options;
+    options.periodTicks = period;
+    options.startPaused = true; // until the callback can reach the scheduler
+    MetricsRegistry metrics;
+    options.metrics = &metrics;
+    TickScheduler* self = nullptr;
+    TickScheduler scheduler(nullptr, [&self](const TickEvent& tick) { self->RecordPresent(tick.boundaryUtc, self->NowUtc()); }, options);
+    self = &scheduler;
+    scheduler.SetPaused(false);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    scheduler.Shutdown();
+    Print("boundary to wakeup", scheduler.wakeLatency());
+    Print("boundary to callback", scheduler.presentLatency());
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Headless world-clock service: serves the city list, per-city offsets and
+// NTP-disciplined UTC to local processes over clock_protocol datagrams.
+//
+//   clockd [--config-dir config] [--unix /run/clockd.sock | --bind 127.0.0.1 --port 12400]
+//          [--threads N] [--no-ntp] [--metrics-file PATH [--metrics-json]]
+//          [--metrics-port P]
+//
+// Cities come from <config-dir>/cities.txt and NTP servers from ntp.txt, the
+// same files the desktop clock uses; clock_state.txt there carries the
+// disciplined clock across restarts (see core/clock_warm_start.h).
+// --metrics-file rewrites the runtime metrics there every 10 seconds
+// (Prometheus text, or JSON); --metrics-port serves them over HTTP on
+// 127.0.0.1 at /metrics and /metrics.json.
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/city_file.h"
+#include "core/clock_warm_start.h"
+#include "core/clock_server.h"
+#include "core/metrics.h"
+#include "core/metrics_server.h"
+#include "core/monotonic.h"
+#include "core/net.h"
+#include "core/ntp_worker.h"
+
+using namespace clockcore;
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void OnSignal(int) {
+    g_stop = 1;
+}
+
+static std::vector<std::string> LoadNtpServerFile(const std::filesystem::path& path) {
+    std::vector<std::string> servers;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string current;
+        for (char ch : line + " ") {
+            if (ch == ',' || ch == ';' || ch == ' ' || ch == '\t' || ch == '\r') {
+                if (!current.empty()) {
+                    servers.push_back(current);
+                    current.clear();
+                }
+            } else {
+                current.push_back(ch);
+            }
+        }
+    }
+    if (servers.empty()) {
+        servers.push_back("pool.ntp.org");
+    }
+    return servers;
+}
+
+int main(int argc, char** argv) {
+    std::filesystem::path configDir = "config";
+    ClockServerOptions options;
+    bool ntp = true;
+    MetricsExporterOptions exportOptions;
+    std::string metricsPort;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--config-dir") == 0 && hasValue) {
+            configDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--unix") == 0 && hasValue) {
+            options.unixPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--bind") == 0 && hasValue) {
+            options.bindAddress = argv[++i];
+        } else if (std::strcmp(argv[i], "--port") == 0 && hasValue) {
+            options.port = argv[++i];
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-ntp") == 0) {
+            ntp = false;
+        } else if (std::strcmp(argv[i], "--metrics-file") == 0 && hasValue) {
+            exportOptions.path = argv[++i];
+        } else if (std::strcmp(argv[i], "--metrics-json") == 0) {
+            exportOptions.format = MetricsFormat::Json;
+        } else if (std::strcmp(argv[i], "--metrics-port") == 0 && hasValue) {
+            metricsPort = argv[++i];
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::vector<CityInfo> cities;
+    if (!LoadCityFile(configDir / "cities.txt", cities) || cities.empty()) {
+        cities = DefaultCities();
+    }
+    uint64_t now = SystemFileTime();
+    for (auto& city : cities) {
+        PrimeCityCache(city, now);
+    }
+
+    InitializeNetworking();
+    std::fprintf(stderr, "clockd: monotonic clock %s\n", MonotonicSourceName(ActiveMonotonicSource()));
+    PublishedClock clock;
+    std::unique_ptr<NtpWorker> worker;
+    if (ntp) {
+        const std::filesystem::path statePath = configDir / "clock_state.txt";
+        NtpWorkerOptions workerOptions;
+        int syncDelaySeconds = 0;
+        if (auto state = LoadWarmStart(statePath)) {
+            if (auto estimate = EstimateWarmStart(*state, MonotonicTicks(), SystemFileTime())) {
+                workerOptions.initialClock = estimate->clock;
+                workerOptions.initialFrequencyKnown = estimate->frequencyKnown;
+                syncDelaySeconds = estimate->syncDelaySeconds;
+                std::fprintf(stderr, "clockd: warm start from %llu s ago, +/- %.3f ms, first sync in %d s\n",
+                             static_cast<unsigned long long>(estimate->ageTicks / kTicksPerSecond),
+                             static_cast<double>(estimate->uncertaintyTicks) / 10000.0, syncDelaySeconds);
+            }
+        }
+        worker = std::make_unique<NtpWorker>(clock, [statePath](const NtpSyncResult& result) {
+            if (result.ok) {
+                SaveWarmStart(statePath, CaptureWarmStart(result.clock, NtpRootDistance(result.selection.combined), result.pollSeconds,
+                                                          MonotonicTicks(), SystemFileTime()));
+                std::fprintf(stderr, "clockd: ntp offset %+.3f ms, drift %lld ppb, next poll %d s\n",
+                             static_cast<double>(result.selection.combined.offset) / 10000.0,
+                             static_cast<long long>(result.clock.frequencyPpb), result.pollSeconds);
+            } else if (!result.canceled) {
+                std::fprintf(stderr, "clockd: ntp sync failed\n");
+            }
+        }, workerOptions);
+        worker->SetServers(LoadNtpServerFile(configDir / "ntp.txt"));
+        if (syncDelaySeconds > 0) {
+            worker->ScheduleSync(syncDelaySeconds);
+        } else {
+            worker->RequestSync();
+        }
+    }
+
+    ClockServer server;
+    std::string error;
+    if (!server.Start(cities, &clock, options, error)) {
+        std::fprintf(stderr, "clockd: %s\n", error.c_str());
+        worker.reset();
+        ShutdownNetworking();
+        return 1;
+    }
+    if (options.unixPath.empty()) {
+        std::fprintf(stderr, "clockd: %zu cities on udp %s:%s, %u threads\n", cities.size(), options.bindAddress.c_str(),
+                     server.boundPort().c_str(), server.threadCount());
+    } else {
+        std::fprintf(stderr, "clockd: %zu cities on %s, %u threads\n", cities.size(), options.unixPath.c_str(), server.threadCount());
+    }
+
+    MetricsServer metricsServer;
+    if (!metricsPort.empty()) {
+        MetricsServerOptions metricsOptions;
+        metricsOptions.port = metricsPort;
+        if (metricsServer.Start(DefaultMetrics(), metricsOptions, error)) {
+            std::fprintf(stderr, "clockd: metrics on http://127.0.0.1:%s/metrics\n", metricsServer.boundPort().c_str());
+        } else {
+            std::fprintf(stderr, "clockd: metrics: %s\n", error.c_str());
+        }
+    }
+    std::unique_ptr<MetricsExporter> exporter;
+    if (!exportOptions.path.empty()) {
+        exporter = std::make_unique<MetricsExporter>(DefaultMetrics(), exportOptions);
+    }
+
+    std::signal(SIGINT, OnSignal);
+    std::signal(SIGTERM, OnSignal);
+    // The dispatch threads keep their own counts; fold them in for export.
+    Counter& requests = DefaultMetrics().GetCounter("clockd_requests_total", "Clock protocol requests answered.");
+    uint64_t served = 0;
+    while (!g_stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        uint64_t total = server.requestCount();
+        requests.Add(total - served);
+        served = total;
+    }
+
+    requests.Add(server.requestCount() - served);
+    served = server.requestCount();
+    server.Stop();
+    worker.reset();
+    metricsServer.Stop();
+    exporter.reset();
+    std::fprintf(stderr, "clockd: served %llu requests\n", static_cast<unsigned long long>(served));
+    ShutdownNetworking();
+    return 0;
+}
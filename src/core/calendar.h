@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+
+// Pure integer calendar arithmetic on the proleptic Gregorian calendar.
+// Instants are FILETIME-compatible: 100-ns ticks since 1601-01-01 00:00 UTC.
+// All of it is constexpr so the DST rules built on top (dst.h) can be
+// evaluated, and checked, at compile time.
+
+namespace clockcore {
+
+constexpr int64_t kTicksPerMicrosecond = 10;
+constexpr int64_t kTicksPerSecond = 10000000;
+constexpr int64_t kTicksPerMinute = 60 * kTicksPerSecond;
+constexpr int64_t kTicksPerDay = 86400 * kTicksPerSecond;
+constexpr int64_t kUnixEpochDaysFrom1601 = 134774;
+constexpr uint64_t kUnixEpochFileTime = 116444736000000000ull;
+
+struct CivilTime {
+    int year = 1601;
+    int month = 1;   // 1-12
+    int day = 1;     // 1-31
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    int weekday = 1; // 0=Sunday
+};
+
+constexpr bool IsLeapYear(int year) {
+    return (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+}
+
+constexpr int DaysInMonth(int year, int month) {
+    constexpr int kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && IsLeapYear(year)) {
+        return 29;
+    }
+    return kDays[month - 1];
+}
+
+// Days relative to 1970-01-01 (negative before the Unix epoch).
+// Howard Hinnant's days_from_civil: shift the year to start in March so the
+// leap day is the last day of the "year", then count whole 400-year eras.
+constexpr int64_t DaysFromCivil(int year, int month, int day) {
+    int64_t y = static_cast<int64_t>(year) - (month <= 2 ? 1 : 0);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;                                         // [0, 399]
+    int64_t mp = (month + 9) % 12;                                       // March = 0
+    int64_t doy = (153 * mp + 2) / 5 + day - 1;                          // [0, 365]
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                 // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+constexpr void CivilFromDays(int64_t days, int& year, int& month, int& day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t doe = days - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = static_cast<int>(yoe + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+constexpr int WeekdayFromDays(int64_t days) {
+    // 1970-01-01 was a Thursday.
+    return static_cast<int>(days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6);
+}
+
+constexpr uint64_t FileTimeFromCivil(const CivilTime& civil) {
+    int64_t days = DaysFromCivil(civil.year, civil.month, civil.day) + kUnixEpochDaysFrom1601;
+    int64_t seconds = static_cast<int64_t>(civil.hour) * 3600 + civil.minute * 60 + civil.second;
+    return static_cast<uint64_t>(days * kTicksPerDay + seconds * kTicksPerSecond);
+}
+
+constexpr CivilTime CivilFromFileTime(uint64_t fileTime) {
+    int64_t totalSeconds = static_cast<int64_t>(fileTime / kTicksPerSecond);
+    int64_t days = totalSeconds / 86400;
+    int64_t secondOfDay = totalSeconds % 86400;
+
+    CivilTime civil;
+    int64_t unixDays = days - kUnixEpochDaysFrom1601;
+    CivilFromDays(unixDays, civil.year, civil.month, civil.day);
+    civil.hour = static_cast<int>(secondOfDay / 3600);
+    civil.minute = static_cast<int>((secondOfDay / 60) % 60);
+    civil.second = static_cast<int>(secondOfDay % 60);
+    civil.weekday = WeekdayFromDays(unixDays);
+    return civil;
+}
+
+constexpr int64_t UnixSecondsFromFileTime(uint64_t fileTime) {
+    int64_t ticks = static_cast<int64_t>(fileTime) - static_cast<int64_t>(kUnixEpochFileTime);
+    int64_t seconds = ticks / kTicksPerSecond;
+    return (ticks % kTicksPerSecond < 0) ? seconds - 1 : seconds;
+}
+
+constexpr uint64_t FileTimeFromUnixSeconds(int64_t unixSeconds) {
+    return static_cast<uint64_t>(unixSeconds * kTicksPerSecond + static_cast<int64_t>(kUnixEpochFileTime));
+}
+
+} // namespace clockcore
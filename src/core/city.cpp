@@ -0,0 +1,67 @@
+#include "city.h"
+
+#include <limits>
+
+#include "metrics.h"
+
+namespace clockcore {
+
+// Looked up at startup so the first cache miss, possibly days in, does not
+// allocate on the tick path.
+static Counter& g_offsetCacheMisses = DefaultMetrics().GetCounter(
+    "city_offset_cache_misses_total", "Offset lookups that fell outside a city's cached interval, such as at DST transitions.");
+
+int GetDstAdjustmentMinutes(const CityInfo& city, uint64_t utcFileTime) {
+    const DstRule* rule = GetDstRule(GetDstScheme(city.name));
+    if (!rule) {
+        return 0;
+    }
+    return GetDstAdjustmentMinutes(*rule, city.offsetMinutes, utcFileTime);
+}
+
+static uint64_t FileTimeFromUnixSecondsClamped(int64_t unixSeconds) {
+    constexpr int64_t kMin = -static_cast<int64_t>(kUnixEpochFileTime / kTicksPerSecond);
+    constexpr int64_t kMax = static_cast<int64_t>((std::numeric_limits<uint64_t>::max() - kUnixEpochFileTime) / kTicksPerSecond);
+    if (unixSeconds <= kMin) {
+        return 0;
+    }
+    if (unixSeconds >= kMax) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return FileTimeFromUnixSeconds(unixSeconds);
+}
+
+static void ComputeCityOffset(CityInfo& city, uint64_t utcFileTime) {
+    OffsetCache& cache = city.offsetCache;
+    if (city.zone) {
+        ZoneOffset offset = city.zone->Lookup(UnixSecondsFromFileTime(utcFileTime));
+        cache.validFrom = FileTimeFromUnixSecondsClamped(offset.validFrom);
+        cache.validUntil = FileTimeFromUnixSecondsClamped(offset.validUntil);
+        cache.offsetMinutes = offset.utcOffsetSeconds / 60;
+        return;
+    }
+    const DstRule* rule = GetDstRule(city.dstScheme);
+    if (!rule) {
+        cache.validFrom = 0;
+        cache.validUntil = std::numeric_limits<uint64_t>::max();
+        cache.offsetMinutes = city.offsetMinutes;
+        return;
+    }
+    DstInterval interval = GetDstInterval(*rule, city.offsetMinutes, utcFileTime);
+    cache.validFrom = interval.validFrom;
+    cache.validUntil = interval.validUntil;
+    cache.offsetMinutes = city.offsetMinutes + interval.adjustMinutes;
+}
+
+void PrimeCityCache(CityInfo& city, uint64_t utcFileTime) {
+    city.zone = city.zoneId.empty() ? nullptr : LoadTimeZone(city.zoneId);
+    city.dstScheme = GetDstScheme(city.name);
+    ComputeCityOffset(city, utcFileTime);
+}
+
+void RefreshCityOffset(CityInfo& city, uint64_t utcFileTime) {
+    g_offsetCacheMisses.Add();
+    ComputeCityOffset(city, utcFileTime);
+}
+
+} // namespace clockcore
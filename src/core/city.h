@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "dst.h"
+#include "tzif.h"
+
+namespace clockcore {
+
+// Total UTC offset of a city, valid for UTC instants in [validFrom, validUntil).
+// An empty interval (the default) forces a recompute on next use.
+struct OffsetCache {
+    uint64_t validFrom = 0;
+    uint64_t validUntil = 0;
+    int offsetMinutes = 0; // base offset plus any DST adjustment
+};
+
+struct CityInfo {
+    std::wstring name;
+    int offsetMinutes; // minutes offset from UTC
+    std::string zoneId; // optional IANA zone id; overrides offset and DST rules when it loads
+    std::shared_ptr<const TzZone> zone;
+    DstScheme dstScheme = DstScheme::None;
+    OffsetCache offsetCache;
+};
+
+int GetDstAdjustmentMinutes(const CityInfo& city, uint64_t utcFileTime);
+
+// Resolves the city's zone (or DST scheme from its name) and computes the
+// offset interval around utcFileTime. Call after a city is added, edited or loaded.
+void PrimeCityCache(CityInfo& city, uint64_t utcFileTime);
+void RefreshCityOffset(CityInfo& city, uint64_t utcFileTime);
+
+// Steady-state lookup: one unsigned comparison while the cached interval holds.
+inline int GetCityOffsetMinutes(CityInfo& city, uint64_t utcFileTime) {
+    const OffsetCache& cache = city.offsetCache;
+    if (utcFileTime - cache.validFrom < cache.validUntil - cache.validFrom) {
+        return cache.offsetMinutes;
+    }
+    RefreshCityOffset(city, utcFileTime);
+    return city.offsetCache.offsetMinutes;
+}
+
+} // namespace clockcore
@@ -0,0 +1,223 @@
+#include "city_file.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <unordered_map>
+
+namespace clockcore {
+
+static std::string TrimAscii(const std::string& input) {
+    size_t start = input.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = input.find_last_not_of(" \t\r\n");
+    return input.substr(start, end - start + 1);
+}
+
+static void AppendCodePoint(std::wstring& out, uint32_t cp) {
+    if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+        cp -= 0x10000;
+        out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+        out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+    } else {
+        out.push_back(static_cast<wchar_t>(cp));
+    }
+}
+
+std::wstring WideFromUtf8(const std::string& utf8) {
+    std::wstring out;
+    out.reserve(utf8.size());
+    size_t i = 0;
+    while (i < utf8.size()) {
+        unsigned char lead = static_cast<unsigned char>(utf8[i]);
+        uint32_t cp = 0;
+        size_t extra = 0;
+        if (lead < 0x80) {
+            cp = lead;
+        } else if ((lead & 0xE0) == 0xC0) {
+            cp = lead & 0x1F;
+            extra = 1;
+        } else if ((lead & 0xF0) == 0xE0) {
+            cp = lead & 0x0F;
+            extra = 2;
+        } else if ((lead & 0xF8) == 0xF0) {
+            cp = lead & 0x07;
+            extra = 3;
+        } else {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        if (i + extra >= utf8.size()) {
+            out.push_back(0xFFFD); // truncated sequence at the end
+            break;
+        }
+        bool valid = true;
+        for (size_t k = 1; k <= extra; ++k) {
+            unsigned char next = static_cast<unsigned char>(utf8[i + k]);
+            if ((next & 0xC0) != 0x80) {
+                valid = false;
+                break;
+            }
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        if (!valid || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        AppendCodePoint(out, cp);
+        i += extra + 1;
+    }
+    return out;
+}
+
+std::string Utf8FromWide(const std::wstring& wide) {
+    std::string out;
+    out.reserve(wide.size());
+    for (size_t i = 0; i < wide.size(); ++i) {
+        uint32_t cp = static_cast<uint32_t>(wide[i]);
+        if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp <= 0xDBFF && i + 1 < wide.size()) {
+            uint32_t low = static_cast<uint32_t>(wide[i + 1]);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+        }
+        if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) {
+            cp = 0xFFFD;
+        }
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+    return out;
+}
+
+bool ParseCityLine(const std::string& line, CityInfo& city) {
+    size_t pipePos = line.find('|');
+    if (pipePos == std::string::npos) {
+        return false;
+    }
+    std::string name = TrimAscii(line.substr(0, pipePos));
+    size_t zonePos = line.find('|', pipePos + 1);
+    std::string offsetText = TrimAscii(line.substr(pipePos + 1, zonePos == std::string::npos ? std::string::npos : zonePos - pipePos - 1));
+    if (name.empty() || offsetText.empty()) {
+        return false;
+    }
+    errno = 0;
+    char* end = nullptr;
+    long offset = std::strtol(offsetText.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0' || offset < -24 * 60 || offset > 24 * 60) {
+        return false;
+    }
+    city = CityInfo{};
+    city.name = WideFromUtf8(name);
+    city.offsetMinutes = static_cast<int>(offset);
+    if (zonePos != std::string::npos) {
+        city.zoneId = TrimAscii(line.substr(zonePos + 1));
+    }
+    return true;
+}
+
+std::string FormatCityLine(const CityInfo& city) {
+    std::string line = Utf8FromWide(city.name) + "|" + std::to_string(city.offsetMinutes);
+    if (!city.zoneId.empty()) {
+        line += "|" + city.zoneId;
+    }
+    return line;
+}
+
+bool LoadCityFile(const std::filesystem::path& path, std::vector<CityInfo>& cities) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    cities.clear();
+    std::string line;
+    bool first = true;
+    while (std::getline(in, line)) {
+        if (first && line.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            line.erase(0, 3); // Notepad may save with a BOM
+        }
+        first = false;
+        CityInfo city;
+        if (ParseCityLine(line, city)) {
+            cities.push_back(std::move(city));
+        }
+    }
+    return true;
+}
+
+bool SaveCityFile(const std::filesystem::path& path, const std::vector<CityInfo>& cities) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    for (const auto& city : cities) {
+        out << FormatCityLine(city) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+std::vector<CityInfo> DefaultCities() {
+    std::vector<CityInfo> cities(2);
+    cities[0].name = L"Auckland";
+    cities[0].offsetMinutes = 720;
+    cities[0].zoneId = "Pacific/Auckland";
+    cities[1].name = L"Shanghai";
+    cities[1].offsetMinutes = 480;
+    cities[1].zoneId = "Asia/Shanghai";
+    return cities;
+}
+
+CityListChanges ApplyCityList(std::vector<CityInfo>& cities, std::vector<CityInfo> loaded, uint64_t utcFileTime) {
+    std::unordered_map<std::wstring, std::vector<size_t>> byName; // indices into cities, last first
+    for (size_t i = cities.size(); i-- > 0;) {
+        byName[cities[i].name].push_back(i);
+    }
+    CityListChanges changes;
+    std::vector<bool> used(cities.size(), false);
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        CityInfo& city = loaded[i];
+        auto it = byName.find(city.name);
+        if (it == byName.end() || it->second.empty()) {
+            PrimeCityCache(city, utcFileTime);
+            ++changes.added;
+            continue;
+        }
+        size_t from = it->second.back();
+        it->second.pop_back();
+        used[from] = true;
+        CityInfo& previous = cities[from];
+        if (previous.offsetMinutes != city.offsetMinutes || previous.zoneId != city.zoneId) {
+            PrimeCityCache(city, utcFileTime);
+            ++changes.changed;
+            continue;
+        }
+        city = std::move(previous);
+        ++changes.kept;
+        changes.moved = changes.moved || from != i;
+    }
+    for (bool wasUsed : used) {
+        changes.removed += wasUsed ? 0 : 1;
+    }
+    cities = std::move(loaded);
+    return changes;
+}
+
+} // namespace clockcore
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "city.h"
+
+namespace clockcore {
+
+// cities.txt holds one city per line as UTF-8 "Name|OffsetMinutes[|Zone]".
+
+std::wstring WideFromUtf8(const std::string& utf8);
+std::string Utf8FromWide(const std::wstring& wide);
+
+// False for blank or malformed lines; the name, offset and zone are trimmed.
+bool ParseCityLine(const std::string& line, CityInfo& city);
+std::string FormatCityLine(const CityInfo& city);
+
+// False if the file cannot be opened. Malformed lines are skipped. Loaded
+// cities are not primed; call PrimeCityCache before use.
+bool LoadCityFile(const std::filesystem::path& path, std::vector<CityInfo>& cities);
+bool SaveCityFile(const std::filesystem::path& path, const std::vector<CityInfo>& cities);
+
+// Used when cities.txt is missing or has no valid lines.
+std::vector<CityInfo> DefaultCities();
+
+struct CityListChanges {
+    size_t added = 0;
+    size_t changed = 0; // same name, new offset or zone
+    size_t removed = 0;
+    size_t kept = 0;
+    bool moved = false; // a kept city is at a different position
+    bool any() const { return added || changed || removed || moved; }
+};
+
+// Makes cities equal to loaded, in loaded's order, matching entries by name
+// (duplicates pair up in order). Kept cities move over with their zone and
+// offset cache intact; only added and changed ones are primed at utcFileTime.
+CityListChanges ApplyCityList(std::vector<CityInfo>& cities, std::vector<CityInfo> loaded, uint64_t utcFileTime);
+
+} // namespace clockcore
@@ -0,0 +1,98 @@
+#include "clock_discipline.h"
+
+#include <algorithm>
+
+#include "calendar.h"
+
+namespace clockcore {
+
+// Frequency is averaged with weight interval / (interval + time constant), so
+// short intervals, where offset noise dominates, barely move the estimate.
+static constexpr uint64_t kMinFrequencyInterval = 60 * kTicksPerSecond;
+static constexpr double kFrequencyTimeConstant = 2048.0 * kTicksPerSecond;
+
+static int64_t Abs(int64_t v) {
+    return v < 0 ? -v : v;
+}
+
+void ClockDiscipline::UpdateFrequency(uint64_t utc, uint64_t mono) {
+    if (!haveAnchor_) {
+        anchorUtc_ = utc;
+        anchorMono_ = mono;
+        haveAnchor_ = true;
+        return;
+    }
+    uint64_t monoElapsed = mono - anchorMono_;
+    if (monoElapsed < kMinFrequencyInterval) {
+        return; // keep the older anchor for a longer baseline
+    }
+    // Measured UTC is independent of our own steps and slews, so the rate
+    // between two measurements is the monotonic clock's true frequency error.
+    double gained = static_cast<double>(static_cast<int64_t>(utc - anchorUtc_)) - static_cast<double>(monoElapsed);
+    double measuredPpb = gained * 1e9 / static_cast<double>(monoElapsed);
+    double estimate = measuredPpb;
+    if (haveFrequency_) {
+        double weight = static_cast<double>(monoElapsed) / (static_cast<double>(monoElapsed) + kFrequencyTimeConstant);
+        estimate = static_cast<double>(clock_.frequencyPpb) + weight * (measuredPpb - static_cast<double>(clock_.frequencyPpb));
+    }
+    estimate = std::clamp(estimate, static_cast<double>(-kMaxFrequencyPpb), static_cast<double>(kMaxFrequencyPpb));
+    clock_.frequencyPpb = static_cast<int64_t>(estimate);
+    haveFrequency_ = true;
+    anchorUtc_ = utc;
+    anchorMono_ = mono;
+}
+
+const ClockSample& ClockDiscipline::Update(uint64_t utc, uint64_t mono, int64_t distance) {
+    if (clock_.valid && static_cast<int64_t>(mono - clock_.baseMono) < 0) {
+        return clock_; // older than the state it would correct
+    }
+
+    uint64_t predicted = utc;
+    int64_t residual = 0;
+    bool step = !clock_.valid;
+    if (clock_.valid) {
+        predicted = ExtrapolateUtc(clock_, mono);
+        residual = static_cast<int64_t>(utc - predicted);
+        step = Abs(residual) > kStepThresholdTicks;
+    }
+    UpdateFrequency(utc, mono);
+
+    clock_.baseMono = mono;
+    clock_.valid = true;
+    if (step) {
+        clock_.baseUtc = utc;
+        clock_.slewTicks = 0;
+        clock_.slewDuration = 0;
+    } else {
+        // Continue from the predicted time and spread the residual out at
+        // the maximum slew rate; this replaces any unfinished earlier slew.
+        clock_.baseUtc = predicted;
+        clock_.slewTicks = residual;
+        clock_.slewDuration = static_cast<uint64_t>(static_cast<double>(Abs(residual)) * 1e9 / static_cast<double>(kMaxSlewPpb));
+    }
+    lastResidual_ = residual;
+    lastStepped_ = step;
+
+    // Poll less often while the prediction holds within the measurement's own
+    // uncertainty, and back off quickly when it does not.
+    if (step || !haveFrequency_) {
+        pollSeconds_ = kMinPollSeconds;
+    } else if (Abs(residual) <= distance) {
+        pollSeconds_ = std::min(pollSeconds_ * 2, kMaxPollSeconds);
+    } else {
+        pollSeconds_ = std::max(pollSeconds_ / 2, kMinPollSeconds);
+    }
+    return clock_;
+}
+
+void ClockDiscipline::Seed(const ClockSample& clock, bool frequencyKnown) {
+    Reset();
+    clock_ = clock;
+    haveFrequency_ = clock.valid && frequencyKnown;
+}
+
+void ClockDiscipline::Reset() {
+    *this = ClockDiscipline();
+}
+
+} // namespace clockcore
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "clock_state.h"
+
+namespace clockcore {
+
+constexpr int64_t kStepThresholdTicks = 128 * 10000;   // larger offsets are stepped, not slewed
+constexpr int64_t kMaxSlewPpb = 500000;                 // 500 ppm, as ntpd
+constexpr int64_t kMaxFrequencyPpb = 500000;
+constexpr int kMinPollSeconds = 64;
+constexpr int kMaxPollSeconds = 8192;
+
+// Disciplines a ClockSample from successive time measurements, FLL style:
+// the monotonic clock's frequency error is estimated from the UTC it gained
+// between measurements, and phase errors are slewed out at a bounded rate
+// instead of stepped. Interpolated time therefore stays continuous and stays
+// accurate across long poll intervals.
+//
+// Not thread-safe; one owner feeds measurements and publishes clock().
+class ClockDiscipline {
+public:
+    // Folds in a measurement "UTC was utc at monotonic time mono", accurate
+    // to about distance ticks, and returns the new clock to publish.
+    const ClockSample& Update(uint64_t utc, uint64_t mono, int64_t distance);
+
+    // Starts from an estimate of the clock, e.g. a warm start, instead of
+    // nothing: the first measurement is slewed against it when close enough,
+    // and, if frequencyKnown, its frequency is refined rather than measured
+    // from scratch.
+    void Seed(const ClockSample& clock, bool frequencyKnown);
+
+    // Forgets everything, including the frequency estimate.
+    void Reset();
+
+    const ClockSample& clock() const { return clock_; }
+    int64_t lastResidual() const { return lastResidual_; } // measured minus predicted, ticks
+    bool lastStepped() const { return lastStepped_; }
+    int pollSeconds() const { return pollSeconds_; } // suggested delay before the next measurement
+
+private:
+    void UpdateFrequency(uint64_t utc, uint64_t mono);
+
+    ClockSample clock_;
+    uint64_t anchorUtc_ = 0;  // measurement the frequency is estimated against
+    uint64_t anchorMono_ = 0;
+    bool haveAnchor_ = false;
+    bool haveFrequency_ = false;
+    int64_t lastResidual_ = 0;
+    bool lastStepped_ = false;
+    int pollSeconds_ = kMinPollSeconds;
+};
+
+} // namespace clockcore
@@ -0,0 +1,292 @@
+#include "clock_protocol.h"
+
+#include <cstring>
+
+#include "city_file.h"
+#include "monotonic.h"
+
+namespace clockcore {
+
+namespace {
+
+struct ByteWriter {
+    uint8_t* out;
+    size_t capacity;
+    size_t pos = 0;
+    bool ok = true;
+
+    void Bytes(const void* data, size_t length) {
+        if (!ok || capacity - pos < length) {
+            ok = false;
+            return;
+        }
+        std::memcpy(out + pos, data, length);
+        pos += length;
+    }
+    void U8(uint8_t v) { Bytes(&v, 1); }
+    void U16(uint16_t v) {
+        uint8_t b[2] = {static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v)};
+        Bytes(b, 2);
+    }
+    void U32(uint32_t v) {
+        U16(static_cast<uint16_t>(v >> 16));
+        U16(static_cast<uint16_t>(v));
+    }
+    void U64(uint64_t v) {
+        U32(static_cast<uint32_t>(v >> 32));
+        U32(static_cast<uint32_t>(v));
+    }
+};
+
+struct ByteReader {
+    const uint8_t* data;
+    size_t length;
+    size_t pos = 0;
+    bool ok = true;
+
+    const uint8_t* Bytes(size_t n) {
+        if (!ok || length - pos < n) {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t* p = data + pos;
+        pos += n;
+        return p;
+    }
+    uint8_t U8() {
+        const uint8_t* p = Bytes(1);
+        return p ? p[0] : 0;
+    }
+    uint16_t U16() {
+        const uint8_t* p = Bytes(2);
+        return p ? static_cast<uint16_t>((p[0] << 8) | p[1]) : 0;
+    }
+    uint32_t U32() {
+        uint32_t high = U16();
+        return (high << 16) | U16();
+    }
+    uint64_t U64() {
+        uint64_t high = U32();
+        return (high << 32) | U32();
+    }
+};
+
+} // namespace
+
+static void WriteHeader(ByteWriter& w, uint8_t op, uint32_t requestId) {
+    w.U8('W');
+    w.U8('C');
+    w.U8(kProtocolVersion);
+    w.U8(op);
+    w.U32(requestId);
+}
+
+static std::string FoldAscii(const std::string& text) {
+    std::string folded = text;
+    for (char& ch : folded) {
+        if (ch >= 'A' && ch <= 'Z') {
+            ch = static_cast<char>(ch - 'A' + 'a');
+        }
+    }
+    return folded;
+}
+
+const char* ClockStatusName(ClockStatus status) {
+    switch (status) {
+    case ClockStatus::Ok: return "ok";
+    case ClockStatus::BadRequest: return "bad request";
+    case ClockStatus::UnknownCity: return "unknown city";
+    case ClockStatus::UnknownOp: return "unknown op";
+    case ClockStatus::TooLarge: return "too large";
+    }
+    return "unknown";
+}
+
+size_t EncodeListCitiesRequest(uint32_t requestId, uint8_t* out, size_t capacity) {
+    ByteWriter w{out, capacity};
+    WriteHeader(w, static_cast<uint8_t>(ClockOp::ListCities), requestId);
+    return w.ok ? w.pos : 0;
+}
+
+size_t EncodeFindCityRequest(uint32_t requestId, const std::string& name, uint8_t* out, size_t capacity) {
+    if (name.size() > 255) {
+        return 0;
+    }
+    ByteWriter w{out, capacity};
+    WriteHeader(w, static_cast<uint8_t>(ClockOp::FindCity), requestId);
+    w.U8(static_cast<uint8_t>(name.size()));
+    w.Bytes(name.data(), name.size());
+    return w.ok ? w.pos : 0;
+}
+
+size_t EncodeConvertRequest(uint32_t requestId, uint64_t utc, const uint16_t* cities, size_t count, uint8_t* out, size_t capacity) {
+    if (count > kMaxConvertCities) {
+        return 0;
+    }
+    ByteWriter w{out, capacity};
+    WriteHeader(w, static_cast<uint8_t>(ClockOp::Convert), requestId);
+    w.U64(utc);
+    w.U16(static_cast<uint16_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        w.U16(cities[i]);
+    }
+    return w.ok ? w.pos : 0;
+}
+
+bool DecodeClockResponse(const uint8_t* data, size_t length, ClockResponse& response) {
+    ByteReader r{data, length};
+    if (r.U8() != 'W' || r.U8() != 'C' || r.U8() != kProtocolVersion) {
+        return false;
+    }
+    uint8_t op = r.U8();
+    if (!(op & 0x80)) {
+        return false;
+    }
+    response = ClockResponse();
+    response.op = static_cast<ClockOp>(op & 0x7F);
+    response.requestId = r.U32();
+    response.status = static_cast<ClockStatus>(r.U8());
+    if (!r.ok) {
+        return false;
+    }
+    if (response.status != ClockStatus::Ok) {
+        return true;
+    }
+    switch (response.op) {
+    case ClockOp::ListCities: {
+        uint16_t count = r.U16();
+        for (uint16_t i = 0; i < count && r.ok; ++i) {
+            uint8_t nameLength = r.U8();
+            const uint8_t* name = r.Bytes(nameLength);
+            if (name) {
+                response.names.emplace_back(reinterpret_cast<const char*>(name), nameLength);
+            }
+        }
+        break;
+    }
+    case ClockOp::FindCity:
+        response.index = r.U16();
+        break;
+    case ClockOp::Convert: {
+        response.utc = r.U64();
+        uint16_t count = r.U16();
+        response.offsets.reserve(count);
+        for (uint16_t i = 0; i < count && r.ok; ++i) {
+            CityOffset offset;
+            offset.index = r.U16();
+            offset.offsetMinutes = static_cast<int16_t>(r.U16());
+            response.offsets.push_back(offset);
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    return r.ok;
+}
+
+ClockRequestHandler::ClockRequestHandler(std::vector<CityInfo> cities, const PublishedClock* clock)
+    : cities_(std::move(cities)), clock_(clock) {
+    for (const auto& city : cities_) {
+        std::string name = Utf8FromWide(city.name);
+        if (name.size() > 255) {
+            name.resize(255);
+        }
+        foldedNames_.push_back(FoldAscii(name));
+        names_.push_back(std::move(name));
+    }
+}
+
+uint64_t ClockRequestHandler::Now() const {
+    uint64_t utc = 0;
+    if (clock_ && clock_->TryNow(MonotonicTicks(), utc)) {
+        return utc;
+    }
+    return SystemFileTime();
+}
+
+size_t ClockRequestHandler::Handle(const uint8_t* request, size_t length, uint8_t* response, size_t capacity) {
+    ByteReader r{request, length};
+    if (r.U8() != 'W' || r.U8() != 'C') {
+        return 0;
+    }
+    uint8_t version = r.U8();
+    uint8_t op = r.U8();
+    uint32_t requestId = r.U32();
+    if (!r.ok || (op & 0x80)) {
+        return 0; // truncated, or a response looped back at us
+    }
+
+    ByteWriter w{response, capacity};
+    WriteHeader(w, static_cast<uint8_t>(op | 0x80), requestId);
+    size_t statusPos = w.pos;
+    w.U8(static_cast<uint8_t>(ClockStatus::Ok));
+    auto fail = [&](ClockStatus status) -> size_t {
+        response[statusPos] = static_cast<uint8_t>(status);
+        return statusPos + 1;
+    };
+    if (!w.ok) {
+        return 0;
+    }
+    if (version != kProtocolVersion) {
+        return fail(ClockStatus::BadRequest);
+    }
+
+    switch (static_cast<ClockOp>(op)) {
+    case ClockOp::ListCities:
+        if (cities_.size() > 0xFFFF) {
+            return fail(ClockStatus::TooLarge);
+        }
+        w.U16(static_cast<uint16_t>(cities_.size()));
+        for (const auto& name : names_) {
+            w.U8(static_cast<uint8_t>(name.size()));
+            w.Bytes(name.data(), name.size());
+        }
+        return w.ok ? w.pos : fail(ClockStatus::TooLarge);
+
+    case ClockOp::FindCity: {
+        uint8_t nameLength = r.U8();
+        const uint8_t* name = r.Bytes(nameLength);
+        if (!name) {
+            return fail(ClockStatus::BadRequest);
+        }
+        std::string folded = FoldAscii(std::string(reinterpret_cast<const char*>(name), nameLength));
+        for (size_t i = 0; i < foldedNames_.size() && i <= 0xFFFF; ++i) {
+            if (foldedNames_[i] == folded) {
+                w.U16(static_cast<uint16_t>(i));
+                return w.pos;
+            }
+        }
+        return fail(ClockStatus::UnknownCity);
+    }
+
+    case ClockOp::Convert: {
+        uint64_t utc = r.U64();
+        uint16_t count = r.U16();
+        if (!r.ok || length - r.pos < static_cast<size_t>(count) * 2) {
+            return fail(ClockStatus::BadRequest);
+        }
+        size_t total = count ? count : cities_.size();
+        if (total > kMaxConvertCities) {
+            return fail(ClockStatus::TooLarge);
+        }
+        if (utc == kConvertUtcNow) {
+            utc = Now();
+        }
+        w.U64(utc);
+        w.U16(static_cast<uint16_t>(total));
+        for (size_t i = 0; i < total; ++i) {
+            size_t index = count ? r.U16() : i;
+            if (index >= cities_.size()) {
+                return fail(ClockStatus::UnknownCity);
+            }
+            w.U16(static_cast<uint16_t>(index));
+            w.U16(static_cast<uint16_t>(static_cast<int16_t>(GetCityOffsetMinutes(cities_[index], utc))));
+        }
+        return w.ok ? w.pos : fail(ClockStatus::TooLarge);
+    }
+    }
+    return fail(ClockStatus::UnknownOp);
+}
+
+} // namespace clockcore
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "city.h"
+#include "clock_state.h"
+
+namespace clockcore {
+
+// Datagram protocol served by clockd. All integers are big-endian.
+//
+// Request:  'W' 'C' version op requestId:u32  body
+// Response: 'W' 'C' version op|0x80 requestId:u32 status:u8  body
+//
+// ListCities  body: -                 -> count:u16 { nameLen:u8 name:UTF-8 }*
+// FindCity    body: nameLen:u8 name   -> index:u16  (case-insensitive)
+// Convert     body: utc:u64 count:u16 index:u16*
+//                                     -> utc:u64 count:u16 { index:u16 offsetMinutes:i16 }*
+//             utc is FILETIME ticks; kConvertUtcNow asks for the service's
+//             NTP-disciplined clock. count 0 converts every city. Local time
+//             is utc + offsetMinutes.
+constexpr uint8_t kProtocolVersion = 1;
+constexpr size_t kProtocolHeaderSize = 8;
+constexpr size_t kMaxDatagramSize = 8192;
+constexpr size_t kMaxConvertCities = 1024;
+constexpr uint64_t kConvertUtcNow = 0;
+
+enum class ClockOp : uint8_t {
+    ListCities = 1,
+    FindCity = 2,
+    Convert = 3
+};
+
+enum class ClockStatus : uint8_t {
+    Ok = 0,
+    BadRequest = 1,
+    UnknownCity = 2,
+    UnknownOp = 3,
+    TooLarge = 4
+};
+
+const char* ClockStatusName(ClockStatus status);
+
+struct CityOffset {
+    uint16_t index = 0;
+    int16_t offsetMinutes = 0;
+};
+
+struct ClockResponse {
+    ClockOp op = ClockOp::ListCities;
+    uint32_t requestId = 0;
+    ClockStatus status = ClockStatus::BadRequest;
+    std::vector<std::string> names; // ListCities
+    uint16_t index = 0;             // FindCity
+    uint64_t utc = 0;               // Convert
+    std::vector<CityOffset> offsets;
+};
+
+// Client side. Encoders return the datagram length, 0 if it does not fit.
+size_t EncodeListCitiesRequest(uint32_t requestId, uint8_t* out, size_t capacity);
+size_t EncodeFindCityRequest(uint32_t requestId, const std::string& name, uint8_t* out, size_t capacity);
+size_t EncodeConvertRequest(uint32_t requestId, uint64_t utc, const uint16_t* cities, size_t count, uint8_t* out, size_t capacity);
+bool DecodeClockResponse(const uint8_t* data, size_t length, ClockResponse& response);
+
+// Server side, one per thread: it owns a copy of the cities so their offset
+// caches need no locking. Returns the response length, or 0 to drop a
+// datagram that is not a protocol request.
+class ClockRequestHandler {
+public:
+    ClockRequestHandler(std::vector<CityInfo> cities, const PublishedClock* clock);
+
+    size_t Handle(const uint8_t* request, size_t length, uint8_t* response, size_t capacity);
+
+private:
+    uint64_t Now() const;
+
+    std::vector<CityInfo> cities_;
+    std::vector<std::string> names_;       // UTF-8
+    std::vector<std::string> foldedNames_; // ASCII-lowercased, for FindCity
+    const PublishedClock* clock_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,240 @@
+#include "clock_server.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+
+#include "clock_protocol.h"
+#include "net.h"
+
+#ifndef _WIN32
+#include <sys/un.h>
+#endif
+
+namespace clockcore {
+
+struct alignas(64) DispatchThread {
+    SocketHandle sock = kInvalidSocket;
+    bool ownsSocket = false;
+    std::atomic<uint64_t> requests{0};
+    std::thread thread;
+};
+
+struct ClockServer::Impl {
+    std::vector<std::unique_ptr<DispatchThread>> threads;
+    std::atomic<bool> stopping{false};
+    std::string unixPath; // to unlink on Stop
+    std::string port;
+};
+
+// Dispatch threads poll with this timeout so Stop() never waits on recvfrom.
+static constexpr int kStopPollMs = 100;
+
+static void Serve(DispatchThread* self, std::atomic<bool>* stopping, std::vector<CityInfo> cities, const PublishedClock* clock) {
+    ClockRequestHandler handler(std::move(cities), clock);
+    uint8_t request[kMaxDatagramSize];
+    uint8_t response[kMaxDatagramSize];
+    while (!stopping->load(std::memory_order_relaxed)) {
+        if (WaitReadable(self->sock, kStopPollMs) <= 0) {
+            continue;
+        }
+        // Sockets are non-blocking: when threads share one, several may wake
+        // for a single datagram; the losers just poll again.
+        for (;;) {
+            sockaddr_storage from = {};
+            SockLen fromLength = sizeof(from);
+            int received = static_cast<int>(recvfrom(self->sock, reinterpret_cast<char*>(request), static_cast<int>(sizeof(request)), 0,
+                                                     reinterpret_cast<sockaddr*>(&from), &fromLength));
+            if (received < 0) {
+                break;
+            }
+            size_t length = handler.Handle(request, static_cast<size_t>(received), response, sizeof(response));
+            if (length == 0 || fromLength == 0) {
+                continue; // not a request, or an unbound Unix client with no reply address
+            }
+            sendto(self->sock, reinterpret_cast<const char*>(response), static_cast<int>(length), 0,
+                   reinterpret_cast<const sockaddr*>(&from), fromLength);
+            self->requests.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+static SocketHandle OpenUdpSocket(const std::string& address, const std::string& port, bool reusePort, std::string& error) {
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+    addrinfo* addr = nullptr;
+    if (getaddrinfo(address.c_str(), port.c_str(), &hints, &addr) != 0 || !addr) {
+        error = "cannot resolve " + address + ":" + port;
+        return kInvalidSocket;
+    }
+    SocketHandle sock = socket(addr->ai_family, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == kInvalidSocket) {
+        freeaddrinfo(addr);
+        error = "socket() failed";
+        return kInvalidSocket;
+    }
+#ifdef SO_REUSEPORT
+    if (reusePort) {
+        int one = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&one), sizeof(one));
+    }
+#else
+    (void)reusePort;
+#endif
+    bool bound = bind(sock, addr->ai_addr, static_cast<SockLen>(addr->ai_addrlen)) == 0;
+    freeaddrinfo(addr);
+    if (!bound || !SetNonBlocking(sock)) {
+        CloseSocket(sock);
+        error = "cannot bind " + address + ":" + port;
+        return kInvalidSocket;
+    }
+    return sock;
+}
+
+static std::string LocalPort(SocketHandle sock) {
+    sockaddr_storage local = {};
+    SockLen length = sizeof(local);
+    if (getsockname(sock, reinterpret_cast<sockaddr*>(&local), &length) != 0) {
+        return "";
+    }
+    if (local.ss_family == AF_INET6) {
+        return std::to_string(ntohs(reinterpret_cast<const sockaddr_in6&>(local).sin6_port));
+    }
+    return std::to_string(ntohs(reinterpret_cast<const sockaddr_in&>(local).sin_port));
+}
+
+#ifndef _WIN32
+static SocketHandle OpenUnixSocket(const std::string& path, std::string& error) {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        error = "bad socket path " + path;
+        return kInvalidSocket;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+    SockLen length = static_cast<SockLen>(offsetof(sockaddr_un, sun_path) + path.size());
+    if (path[0] == '@') {
+        addr.sun_path[0] = '\0'; // abstract namespace: no file to clean up
+    } else {
+        unlink(path.c_str());
+        length += 1;
+    }
+    SocketHandle sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (sock == kInvalidSocket) {
+        error = "socket() failed";
+        return kInvalidSocket;
+    }
+    if (bind(sock, reinterpret_cast<const sockaddr*>(&addr), length) != 0 || !SetNonBlocking(sock)) {
+        CloseSocket(sock);
+        error = "cannot bind " + path;
+        return kInvalidSocket;
+    }
+    return sock;
+}
+#endif
+
+ClockServer::ClockServer() : impl_(std::make_unique<Impl>()) {}
+
+ClockServer::~ClockServer() {
+    Stop();
+}
+
+bool ClockServer::Start(const std::vector<CityInfo>& cities, const PublishedClock* clock, const ClockServerOptions& options, std::string& error) {
+    Stop();
+    impl_->stopping.store(false);
+    unsigned count = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (count == 0) {
+        count = 1;
+    }
+
+    std::vector<SocketHandle> sockets;
+    if (!options.unixPath.empty()) {
+#ifdef _WIN32
+        error = "Unix sockets are not supported on this platform";
+        return false;
+#else
+        SocketHandle sock = OpenUnixSocket(options.unixPath, error);
+        if (sock == kInvalidSocket) {
+            return false;
+        }
+        sockets.assign(count, sock); // shared by every thread
+        impl_->unixPath = options.unixPath[0] == '@' ? "" : options.unixPath;
+#endif
+    } else {
+#ifdef SO_REUSEPORT
+        const bool perThread = true;
+#else
+        const bool perThread = false;
+#endif
+        std::string port = options.port;
+        for (unsigned i = 0; i < (perThread ? count : 1); ++i) {
+            SocketHandle sock = OpenUdpSocket(options.bindAddress, port, perThread, error);
+            if (sock == kInvalidSocket) {
+                for (SocketHandle open : sockets) {
+                    CloseSocket(open);
+                }
+                return false;
+            }
+            if (i == 0) {
+                port = LocalPort(sock); // later sockets join the same port
+            }
+            sockets.push_back(sock);
+        }
+        sockets.resize(count, sockets.front());
+        impl_->port = port;
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        auto dispatch = std::make_unique<DispatchThread>();
+        dispatch->sock = sockets[i];
+        dispatch->ownsSocket = i == 0 || sockets[i] != sockets[0];
+        impl_->threads.push_back(std::move(dispatch));
+    }
+    for (auto& dispatch : impl_->threads) {
+        dispatch->thread = std::thread(Serve, dispatch.get(), &impl_->stopping, cities, clock);
+    }
+    return true;
+}
+
+void ClockServer::Stop() {
+    impl_->stopping.store(true);
+    for (auto& dispatch : impl_->threads) {
+        if (dispatch->thread.joinable()) {
+            dispatch->thread.join();
+        }
+    }
+    for (auto& dispatch : impl_->threads) {
+        if (dispatch->ownsSocket) {
+            CloseSocket(dispatch->sock);
+        }
+    }
+    impl_->threads.clear();
+#ifndef _WIN32
+    if (!impl_->unixPath.empty()) {
+        unlink(impl_->unixPath.c_str());
+        impl_->unixPath.clear();
+    }
+#endif
+}
+
+unsigned ClockServer::threadCount() const {
+    return static_cast<unsigned>(impl_->threads.size());
+}
+
+std::string ClockServer::boundPort() const {
+    return impl_->port;
+}
+
+uint64_t ClockServer::requestCount() const {
+    uint64_t total = 0;
+    for (const auto& dispatch : impl_->threads) {
+        total += dispatch->requests.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace clockcore
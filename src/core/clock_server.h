@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "city.h"
+#include "clock_state.h"
+
+namespace clockcore {
+
+struct ClockServerOptions {
+    // Unix datagram socket path (POSIX only; a leading '@' selects the Linux
+    // abstract namespace). Empty serves loopback UDP instead.
+    std::string unixPath;
+    std::string bindAddress = "127.0.0.1";
+    std::string port = "12400"; // "0" picks a free port; see boundPort()
+    unsigned threads = 0;       // 0: one per hardware thread
+};
+
+// Serves clock_protocol requests from a pool of dispatch threads. Each thread
+// has its own ClockRequestHandler, and on platforms with SO_REUSEPORT its own
+// UDP socket, so requests are spread by the kernel and threads share nothing.
+class ClockServer {
+public:
+    ClockServer();
+    ~ClockServer();
+
+    ClockServer(const ClockServer&) = delete;
+    ClockServer& operator=(const ClockServer&) = delete;
+
+    // Binds and starts serving; on failure returns false and describes why.
+    bool Start(const std::vector<CityInfo>& cities, const PublishedClock* clock, const ClockServerOptions& options, std::string& error);
+    void Stop();
+
+    unsigned threadCount() const;
+    std::string boundPort() const; // UDP only
+    uint64_t requestCount() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,62 @@
+#include "clock_state.h"
+
+namespace clockcore {
+
+uint64_t ExtrapolateUtc(const ClockSample& sample, uint64_t monoNow) {
+    int64_t elapsed = static_cast<int64_t>(monoNow - sample.baseMono);
+    int64_t correction = static_cast<int64_t>(static_cast<double>(elapsed) * static_cast<double>(sample.frequencyPpb) * 1e-9);
+    if (sample.slewTicks != 0 && elapsed > 0) {
+        if (static_cast<uint64_t>(elapsed) >= sample.slewDuration) {
+            correction += sample.slewTicks;
+        } else {
+            correction += static_cast<int64_t>(static_cast<double>(sample.slewTicks) * static_cast<double>(elapsed) /
+                                               static_cast<double>(sample.slewDuration));
+        }
+    }
+    return sample.baseUtc + static_cast<uint64_t>(elapsed + correction);
+}
+
+void PublishedClock::Publish(const ClockSample& sample) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    uint64_t seq = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(seq + 1, std::memory_order_relaxed); // odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    baseUtc_.store(sample.baseUtc, std::memory_order_relaxed);
+    baseMono_.store(sample.baseMono, std::memory_order_relaxed);
+    frequencyPpb_.store(sample.frequencyPpb, std::memory_order_relaxed);
+    slewTicks_.store(sample.slewTicks, std::memory_order_relaxed);
+    slewDuration_.store(sample.slewDuration, std::memory_order_relaxed);
+    valid_.store(sample.valid, std::memory_order_relaxed);
+    sequence_.store(seq + 2, std::memory_order_release);
+}
+
+ClockSample PublishedClock::Read() const {
+    ClockSample sample;
+    for (;;) {
+        uint64_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        sample.baseUtc = baseUtc_.load(std::memory_order_relaxed);
+        sample.baseMono = baseMono_.load(std::memory_order_relaxed);
+        sample.frequencyPpb = frequencyPpb_.load(std::memory_order_relaxed);
+        sample.slewTicks = slewTicks_.load(std::memory_order_relaxed);
+        sample.slewDuration = slewDuration_.load(std::memory_order_relaxed);
+        sample.valid = valid_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == before) {
+            return sample;
+        }
+    }
+}
+
+bool PublishedClock::TryNow(uint64_t monoNow, uint64_t& utcOut) const {
+    ClockSample sample = Read();
+    if (!sample.valid) {
+        return false;
+    }
+    utcOut = ExtrapolateUtc(sample, monoNow);
+    return true;
+}
+
+} // namespace clockcore
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace clockcore {
+
+// A UTC reference pinned to the monotonic clock: at baseMono the time was
+// baseUtc, and monotonic ticks run fast/slow by frequencyPpb. A pending phase
+// correction of slewTicks is spread linearly over the slewDuration monotonic
+// ticks after baseMono, so corrections never make the clock jump.
+struct ClockSample {
+    uint64_t baseUtc = 0;  // FILETIME ticks
+    uint64_t baseMono = 0; // MonotonicTicks() at baseUtc
+    int64_t frequencyPpb = 0;
+    int64_t slewTicks = 0;
+    uint64_t slewDuration = 0;
+    bool valid = false;
+};
+
+uint64_t ExtrapolateUtc(const ClockSample& sample, uint64_t monoNow);
+
+// Clock state published by one writer and read by any number of threads.
+// Readers use a sequence lock: they never block, never write shared memory
+// and retry only if a publish raced with the read.
+class PublishedClock {
+public:
+    void Publish(const ClockSample& sample);
+    ClockSample Read() const;
+
+    // False until the first sample is published.
+    bool TryNow(uint64_t monoNow, uint64_t& utcOut) const;
+
+private:
+    alignas(64) std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> baseUtc_{0};
+    std::atomic<uint64_t> baseMono_{0};
+    std::atomic<int64_t> frequencyPpb_{0};
+    std::atomic<int64_t> slewTicks_{0};
+    std::atomic<uint64_t> slewDuration_{0};
+    std::atomic<bool> valid_{false};
+    alignas(64) std::mutex writerMutex_; // serializes publishers only
+};
+
+} // namespace clockcore
@@ -0,0 +1,243 @@
+#include "clock_view.h"
+
+#include <algorithm>
+#include <string>
+
+namespace clockcore {
+
+int ClockFontPixelHeight(int dpi) {
+    return (kClockFontPoints * dpi + 36) / 72;
+}
+
+void ClockLineWidths::Update(Renderer& renderer, const std::vector<CityInfo>& cities) {
+    if (lineHeight_ == 0) {
+        TextSize time = renderer.MeasureString(L"00:00:00", 8);
+        lineHeight_ = time.height;
+        timeWidth_ = time.width;
+    }
+    std::unordered_map<std::wstring, int> previous = std::move(widths_);
+    widths_.clear();
+    widest_ = cities.empty() ? timeWidth_ : 0;
+    for (const auto& city : cities) {
+        if (widths_.count(city.name) != 0) {
+            continue;
+        }
+        auto known = previous.find(city.name);
+        int width;
+        if (known != previous.end()) {
+            width = known->second;
+        } else {
+            std::wstring sample = city.name + L": 00:00:00";
+            width = renderer.MeasureString(sample.c_str(), sample.size()).width;
+        }
+        widths_.emplace(city.name, width);
+        widest_ = std::max(widest_, width);
+    }
+}
+
+void ClockLineWidths::Clear() {
+    widths_.clear();
+    widest_ = 0;
+    lineHeight_ = 0;
+    timeWidth_ = 0;
+}
+
+ClockLayout LayoutClockView(const ClockLineWidths& widths, size_t cityCount, TextSize maxClient) {
+    const int padding = kClockInnerPadding + kClockFrameThickness;
+    ClockLayout layout;
+    layout.lineHeight = std::max(widths.lineHeight(), 1);
+    layout.columnWidth = widths.widest() + kClockColumnGap;
+
+    size_t maxRows = SIZE_MAX;
+    if (maxClient.height > 0) {
+        maxRows = static_cast<size_t>(std::max(1, (maxClient.height - padding * 2) / layout.lineHeight));
+    }
+    size_t maxColumns = SIZE_MAX;
+    if (maxClient.width > 0) {
+        maxColumns = static_cast<size_t>(std::max(1, (maxClient.width - padding * 2 + kClockColumnGap) / layout.columnWidth));
+    }
+    size_t rows = std::min(cityCount, maxRows);
+    size_t columns = rows == 0 ? 1 : std::min((cityCount + rows - 1) / rows, maxColumns);
+    if (rows > 0 && cityCount <= rows * columns) {
+        rows = (cityCount + columns - 1) / columns; // one page: even out the columns
+    }
+    layout.rows = static_cast<int>(rows);
+    layout.columns = static_cast<int>(columns);
+    layout.pageSize = rows * columns;
+    layout.pageCount = layout.pageSize == 0 ? 1 : (cityCount + layout.pageSize - 1) / layout.pageSize;
+
+    layout.client.width = layout.columns * layout.columnWidth - kClockColumnGap + padding * 2;
+    layout.client.height = layout.rows * widths.lineHeight() + padding * 2;
+    return layout;
+}
+
+void ClockGlyphCache::Build(Renderer& renderer, const std::vector<CityInfo>& cities) {
+    Clear();
+    atlas_ = renderer.RasterizeString(kAtlasChars, kAtlasGlyphs, kClockTextColor, kClockBackgroundColor);
+    for (size_t i = 0; i <= kAtlasGlyphs; ++i) {
+        glyphX_[i] = renderer.MeasureString(kAtlasChars, i).width;
+    }
+    lineHeight_ = renderer.MeasureString(kAtlasChars, kAtlasGlyphs).height;
+    UpdateLabels(renderer, cities);
+}
+
+void ClockGlyphCache::UpdateLabels(Renderer& renderer, const std::vector<CityInfo>& cities) {
+    // Labels are matched by text, so inserting, removing or reordering
+    // cities only rasterizes the labels that are new.
+    std::vector<Label> previous = std::move(labels_);
+    std::unordered_multimap<std::wstring, size_t> rasterized;
+    for (size_t i = 0; i < previous.size(); ++i) {
+        if (previous[i].image) {
+            rasterized.emplace(previous[i].text, i);
+        }
+    }
+    labels_.clear();
+    labels_.resize(cities.size());
+    const bool retainAll = cities.size() <= kRetainedLabels;
+    for (size_t i = 0; i < cities.size(); ++i) {
+        Label& label = labels_[i];
+        label.text = cities[i].name + L": ";
+        bool visible = IsVisible(i);
+        if (!visible && !retainAll) {
+            continue;
+        }
+        if (i < previous.size() && previous[i].image && previous[i].text == label.text) {
+            label.image = std::move(previous[i].image);
+            continue;
+        }
+        for (auto [it, end] = rasterized.equal_range(label.text); it != end; ++it) {
+            if (previous[it->second].image) {
+                label.image = std::move(previous[it->second].image);
+                break;
+            }
+        }
+        if (!label.image && visible) {
+            Rasterize(renderer, label);
+        }
+    }
+}
+
+void ClockGlyphCache::SetVisibleRange(Renderer& renderer, size_t first, size_t count) {
+    if (first == visibleFirst_ && count == visibleCount_) {
+        return;
+    }
+    size_t oldFirst = std::min(visibleFirst_, labels_.size());
+    size_t oldEnd = oldFirst + std::min(visibleCount_, labels_.size() - oldFirst);
+    visibleFirst_ = first;
+    visibleCount_ = count;
+    for (size_t i = oldFirst; i < oldEnd && labels_.size() > kRetainedLabels; ++i) {
+        if (!IsVisible(i)) {
+            labels_[i].image.reset();
+        }
+    }
+    first = std::min(first, labels_.size());
+    size_t end = first + std::min(count, labels_.size() - first);
+    for (size_t i = first; i < end; ++i) {
+        if (!labels_[i].image && atlas_) {
+            Rasterize(renderer, labels_[i]);
+        }
+    }
+}
+
+void ClockGlyphCache::Rasterize(Renderer& renderer, Label& label) const {
+    label.image = renderer.RasterizeString(label.text.c_str(), label.text.size(), kClockTextColor, kClockBackgroundColor);
+}
+
+void ClockGlyphCache::Clear() {
+    atlas_.reset();
+    labels_.clear();
+    lineHeight_ = 0;
+}
+
+bool ClockGlyphCache::DrawLine(Renderer& renderer, size_t index, const wchar_t* text, size_t length, int x, int y) const {
+    if (!atlas_ || index >= labels_.size() || length < kTimeLength) {
+        return false;
+    }
+    const Label& label = labels_[index];
+    size_t labelLength = length - kTimeLength;
+    if (!label.image || label.text.size() != labelLength || label.text.compare(0, labelLength, text, labelLength) != 0) {
+        return false;
+    }
+    size_t glyphs[kTimeLength];
+    for (size_t i = 0; i < kTimeLength; ++i) {
+        wchar_t ch = text[labelLength + i];
+        if (ch >= L'0' && ch <= L'9') {
+            glyphs[i] = static_cast<size_t>(ch - L'0');
+        } else if (ch == L':') {
+            glyphs[i] = 10;
+        } else {
+            return false;
+        }
+    }
+
+    TextSize labelSize = label.image->size();
+    renderer.DrawImage(*label.image, 0, labelSize.width, x, y);
+    x += labelSize.width;
+    for (size_t glyph : glyphs) {
+        int width = glyphX_[glyph + 1] - glyphX_[glyph];
+        renderer.DrawImage(*atlas_, glyphX_[glyph], width, x, y);
+        x += width;
+    }
+    return true;
+}
+
+static void DrawClockBackground(Renderer& renderer, int width, int height) {
+    renderer.FillRectangle(0, 0, width, height, kClockBackgroundColor);
+
+    const int t = kClockFrameThickness;
+    renderer.FillRectangle(0, 0, width, t, kClockFrameColor);
+    renderer.FillRectangle(0, height - t, width, height, kClockFrameColor);
+    renderer.FillRectangle(0, t, t, height - t, kClockFrameColor);
+    renderer.FillRectangle(width - t, t, width, height - t, kClockFrameColor);
+}
+
+void DrawClockView(Renderer& renderer, int width, int height, const FrameText& frame) {
+    DrawClockBackground(renderer, width, height);
+
+    int padding = kClockInnerPadding + kClockFrameThickness;
+    int y = padding;
+    for (size_t i = 0; i < frame.lines.size(); ++i) {
+        const wchar_t* line = frame.LineData(i);
+        size_t length = frame.LineLength(i);
+        renderer.DrawString(padding, y, line, length, kClockTextColor);
+        y += renderer.MeasureString(line, length).height;
+    }
+}
+
+void DrawClockView(Renderer& renderer, int width, int height, const FrameText& frame, const ClockGlyphCache& cache) {
+    if (!cache.built()) {
+        DrawClockView(renderer, width, height, frame);
+        return;
+    }
+    DrawClockBackground(renderer, width, height);
+
+    int padding = kClockInnerPadding + kClockFrameThickness;
+    int y = padding;
+    for (size_t i = 0; i < frame.lines.size(); ++i) {
+        const wchar_t* line = frame.LineData(i);
+        size_t length = frame.LineLength(i);
+        if (!cache.DrawLine(renderer, frame.firstCity + i, line, length, padding, y)) {
+            renderer.DrawString(padding, y, line, length, kClockTextColor);
+        }
+        y += cache.lineHeight();
+    }
+}
+
+void DrawClockView(Renderer& renderer, int width, int height, const FrameText& frame, const ClockGlyphCache& cache,
+                   const ClockLayout& layout) {
+    DrawClockBackground(renderer, width, height);
+
+    int padding = kClockInnerPadding + kClockFrameThickness;
+    size_t rows = static_cast<size_t>(std::max(layout.rows, 1));
+    for (size_t i = 0; i < frame.lines.size(); ++i) {
+        const wchar_t* line = frame.LineData(i);
+        size_t length = frame.LineLength(i);
+        int x = padding + static_cast<int>(i / rows) * layout.columnWidth;
+        int y = padding + static_cast<int>(i % rows) * layout.lineHeight;
+        if (!cache.DrawLine(renderer, frame.firstCity + i, line, length, x, y)) {
+            renderer.DrawString(x, y, line, length, kClockTextColor);
+        }
+    }
+}
+
+} // namespace clockcore
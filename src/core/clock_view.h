@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "city.h"
+#include "frame_format.h"
+#include "render.h"
+
+// Layout and painting of the clock window, independent of the backend: a
+// dark background, a light frame inside the client edge and one text line
+// per city, in as many columns and pages as the screen requires.
+
+namespace clockcore {
+
+constexpr int kClockInnerPadding = 12;
+constexpr int kClockFrameThickness = 4;
+constexpr int kClockFontPoints = 24;
+constexpr int kClockColumnGap = 24; // between columns of a multi-column layout
+constexpr Rgba kClockBackgroundColor{20, 20, 20, 255};
+constexpr Rgba kClockFrameColor{170, 170, 170, 255};
+constexpr Rgba kClockTextColor{0, 255, 128, 255};
+
+// Pixel height of the clock font at a given DPI, rounded like MulDiv.
+int ClockFontPixelHeight(int dpi);
+
+// Widest possible line of each city, measured once per distinct name, so a
+// list change only measures the names it adds or renames.
+class ClockLineWidths {
+public:
+    void Update(Renderer& renderer, const std::vector<CityInfo>& cities);
+    void Clear(); // call when the font changes
+
+    int widest() const { return widest_; }
+    int lineHeight() const { return lineHeight_; }
+
+private:
+    std::unordered_map<std::wstring, int> widths_; // by city name
+    int widest_ = 0;
+    int lineHeight_ = 0;
+    int timeWidth_ = 0; // "00:00:00", the width of an empty list
+};
+
+// Where each line goes: lines fill a column top to bottom, then the next
+// column to the right; cities beyond one screenful are split into pages.
+struct ClockLayout {
+    int lineHeight = 0;
+    int columnWidth = 0; // widest line plus kClockColumnGap
+    int rows = 0;        // lines per column
+    int columns = 0;
+    size_t pageSize = 0; // rows * columns
+    size_t pageCount = 1;
+    TextSize client;
+
+    size_t PageStart(size_t page) const { return pageCount > 1 ? page % pageCount * pageSize : 0; }
+};
+
+// Lays out cityCount lines within maxClient (client pixels; 0 for no limit):
+// one column while the lines fit the height, more columns up to the width,
+// pages beyond that. Uses only cached widths, so it costs the same for any
+// number of cities.
+ClockLayout LayoutClockView(const ClockLineWidths& widths, size_t cityCount, TextSize maxClient);
+
+// Digits, ':' and each city's "Name: " label, rasterized once over the
+// clock background. A frame is then composed by copying cached pixels
+// rather than shaping and measuring text every second.
+class ClockGlyphCache {
+public:
+    // Rasterizes the digit atlas and every label; call when the font or DPI changes.
+    void Build(Renderer& renderer, const std::vector<CityInfo>& cities);
+    // Rasterizes only labels not already cached, wherever the city moved;
+    // call after cities change.
+    void UpdateLabels(Renderer& renderer, const std::vector<CityInfo>& cities);
+    // Rasterizes the missing labels of cities [first, first + count).
+    // Lists of up to kRetainedLabels cities keep every label once drawn, so
+    // paging stops allocating after the first rotation; longer lists keep
+    // only the visible range, so memory follows the page rather than the
+    // list. Everything is visible until this is called.
+    void SetVisibleRange(Renderer& renderer, size_t first, size_t count);
+    void Clear();
+
+    bool built() const { return atlas_ != nullptr; }
+    int lineHeight() const { return lineHeight_; }
+
+    // Draws line index of a FrameText from the cache; false (nothing drawn)
+    // when its label or characters are not cached.
+    bool DrawLine(Renderer& renderer, size_t index, const wchar_t* text, size_t length, int x, int y) const;
+
+private:
+    static constexpr wchar_t kAtlasChars[] = L"0123456789:";
+    static constexpr size_t kAtlasGlyphs = 11;
+    static constexpr size_t kTimeLength = 8; // "HH:MM:SS"
+    static constexpr size_t kRetainedLabels = 1024;
+
+    struct Label {
+        std::wstring text; // "Name: "
+        std::unique_ptr<RenderImage> image;
+    };
+
+    bool IsVisible(size_t index) const { return index >= visibleFirst_ && index - visibleFirst_ < visibleCount_; }
+    void Rasterize(Renderer& renderer, Label& label) const;
+
+    std::unique_ptr<RenderImage> atlas_;
+    int glyphX_[kAtlasGlyphs + 1] = {}; // left edge of each atlas glyph, then the atlas width
+    int lineHeight_ = 0;
+    std::vector<Label> labels_; // one per city; images only for the visible range
+    size_t visibleFirst_ = 0;
+    size_t visibleCount_ = SIZE_MAX;
+};
+
+// Paints one frame into a width x height client area. With a built cache
+// the lines are blitted from it; otherwise, and for any line the cache does
+// not cover, text is drawn directly. Without a layout the lines form one
+// column; with one, frame holds the lines of the page being shown.
+void DrawClockView(Renderer& renderer, int width, int height, const FrameText& frame);
+void DrawClockView(Renderer& renderer, int width, int height, const FrameText& frame, const ClockGlyphCache& cache);
+void DrawClockView(Renderer& renderer, int width, int height, const FrameText& frame, const ClockGlyphCache& cache,
+                   const ClockLayout& layout);
+
+} // namespace clockcore
@@ -0,0 +1,133 @@
+#include "clock_warm_start.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "calendar.h"
+#include "clock_discipline.h"
+#include "monotonic.h"
+
+namespace clockcore {
+
+WarmStartState CaptureWarmStart(const ClockSample& clock, int64_t uncertaintyTicks, int pollSeconds, uint64_t monoNow,
+                                uint64_t systemNow) {
+    WarmStartState state;
+    state.systemUtc = systemNow;
+    state.offsetTicks = static_cast<int64_t>(ExtrapolateUtc(clock, monoNow) - systemNow);
+    state.frequencyPpb = clock.frequencyPpb;
+    state.uncertaintyTicks = std::max<int64_t>(uncertaintyTicks, 0);
+    state.pollSeconds = pollSeconds;
+    state.monotonicSource = MonotonicSourceName(ActiveMonotonicSource());
+    return state;
+}
+
+std::optional<WarmStartEstimate> EstimateWarmStart(const WarmStartState& state, uint64_t monoNow, uint64_t systemNow) {
+    if (systemNow < state.systemUtc) {
+        return std::nullopt; // the host clock was set back; the offset means nothing now
+    }
+    WarmStartEstimate estimate;
+    estimate.ageTicks = systemNow - state.systemUtc;
+    double age = static_cast<double>(estimate.ageTicks);
+
+    // The host clock is assumed to have drifted like the monotonic clock did.
+    // If the OS kept it in step instead, that drift is wrong by up to
+    // |frequencyPpb|, so the bound grows by that as well as by PHI.
+    int64_t frequency = state.frequencyPpb;
+    double wanderPpb = static_cast<double>(kWarmStartWanderPpb + (frequency < 0 ? -frequency : frequency));
+    estimate.uncertaintyTicks = state.uncertaintyTicks + static_cast<int64_t>(age * wanderPpb * 1e-9);
+    if (estimate.uncertaintyTicks > kWarmStartMaxUncertaintyTicks) {
+        return std::nullopt;
+    }
+    estimate.frequencyKnown = state.monotonicSource == MonotonicSourceName(ActiveMonotonicSource());
+    if (!estimate.frequencyKnown) {
+        frequency = 0;
+    }
+    int64_t drift = static_cast<int64_t>(age * static_cast<double>(frequency) * 1e-9);
+
+    estimate.clock.baseUtc = systemNow + static_cast<uint64_t>(state.offsetTicks + drift);
+    estimate.clock.baseMono = monoNow;
+    estimate.clock.frequencyPpb = frequency;
+    estimate.clock.valid = true;
+
+    // Sync when the discipline would have, or once the bound is no longer
+    // fresh, whichever comes first.
+    if (estimate.frequencyKnown && estimate.uncertaintyTicks < kWarmStartFreshTicks) {
+        double untilStale = static_cast<double>(kWarmStartFreshTicks - estimate.uncertaintyTicks) * 1e9 / wanderPpb;
+        int64_t untilPoll = static_cast<int64_t>(state.pollSeconds) * kTicksPerSecond - static_cast<int64_t>(estimate.ageTicks);
+        int64_t delay = std::min(static_cast<int64_t>(untilStale), untilPoll);
+        estimate.syncDelaySeconds = delay > 0 ? static_cast<int>(delay / kTicksPerSecond) : 0;
+    }
+    return estimate;
+}
+
+bool SaveWarmStart(const std::filesystem::path& path, const WarmStartState& state) {
+    std::ostringstream text;
+    text << "# Last NTP-disciplined clock; rewritten after every successful sync.\n"
+         << "system_utc " << state.systemUtc << "\n"
+         << "offset_ticks " << state.offsetTicks << "\n"
+         << "frequency_ppb " << state.frequencyPpb << "\n"
+         << "uncertainty_ticks " << state.uncertaintyTicks << "\n"
+         << "poll_seconds " << state.pollSeconds << "\n"
+         << "monotonic_source " << state.monotonicSource << "\n";
+    std::string bytes = text.str();
+
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+std::optional<WarmStartState> LoadWarmStart(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return std::nullopt;
+    }
+    WarmStartState state;
+    unsigned seen = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || key[0] == '#') {
+            continue;
+        }
+        auto read = [&](auto& field, unsigned bit) {
+            if (fields >> field) {
+                seen |= bit;
+            }
+        };
+        if (key == "system_utc") {
+            read(state.systemUtc, 1);
+        } else if (key == "offset_ticks") {
+            read(state.offsetTicks, 2);
+        } else if (key == "frequency_ppb") {
+            read(state.frequencyPpb, 4);
+        } else if (key == "uncertainty_ticks") {
+            read(state.uncertaintyTicks, 8);
+        } else if (key == "poll_seconds") {
+            read(state.pollSeconds, 0); // optional
+        } else if (key == "monotonic_source") {
+            read(state.monotonicSource, 0); // optional; missing means unknown
+        }
+    }
+    if (seen != 15 || state.uncertaintyTicks < 0) {
+        return std::nullopt;
+    }
+    state.frequencyPpb = std::clamp(state.frequencyPpb, -kMaxFrequencyPpb, kMaxFrequencyPpb);
+    return state;
+}
+
+} // namespace clockcore
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "clock_state.h"
+
+// Warm start: the disciplined clock is saved after every successful sync and
+// reloaded at startup, so corrected time is shown before the first NTP reply
+// (or with no network at all). Monotonic ticks do not survive a restart, so
+// the state is kept against the host wall clock, like ntpd's drift file: at
+// system time systemUtc the disciplined clock read systemUtc + offsetTicks.
+
+namespace clockcore {
+
+// Frequency tolerance the saved error bound grows by while no sync confirms
+// it (PHI in RFC 5905).
+constexpr int64_t kWarmStartWanderPpb = 15000;
+// Older or less certain state is not used at all.
+constexpr int64_t kWarmStartMaxUncertaintyTicks = 1000 * 10000; // 1 s
+// While the bound stays below this the startup sync can wait.
+constexpr int64_t kWarmStartFreshTicks = 50 * 10000; // 50 ms
+
+struct WarmStartState {
+    uint64_t systemUtc = 0;       // SystemFileTime() when saved
+    int64_t offsetTicks = 0;      // disciplined UTC minus systemUtc
+    int64_t frequencyPpb = 0;     // drift estimate carried into the next run
+    int64_t uncertaintyTicks = 0; // error bound when saved, e.g. the sync's root distance
+    int pollSeconds = 0;          // interval the discipline had chosen until its next sync
+    std::string monotonicSource;  // MonotonicSourceName() frequencyPpb was measured against
+};
+
+// Snapshot of clock at monoNow, which SystemFileTime() read as systemNow,
+// tagged with ActiveMonotonicSource().
+WarmStartState CaptureWarmStart(const ClockSample& clock, int64_t uncertaintyTicks, int pollSeconds, uint64_t monoNow,
+                                uint64_t systemNow);
+
+struct WarmStartEstimate {
+    ClockSample clock;            // publish until the first sync; valid
+    int64_t uncertaintyTicks = 0; // saved bound grown by the elapsed time
+    uint64_t ageTicks = 0;        // system time since the state was saved
+    int syncDelaySeconds = 0;     // how long the startup sync can wait; 0 = now
+    bool frequencyKnown = false;  // clock.frequencyPpb is the saved estimate for this source
+};
+
+// The clock implied by state at monoNow / systemNow: the saved offset plus
+// the drift accumulated since, with the error bound grown at
+// kWarmStartWanderPpb. Nullopt if the host clock reads earlier than when the
+// state was saved or the bound exceeds kWarmStartMaxUncertaintyTicks. If the
+// state was saved against another monotonic source its frequency says
+// nothing about this one: it is dropped (no drift, frequencyKnown false) and
+// the startup sync is not deferred.
+std::optional<WarmStartEstimate> EstimateWarmStart(const WarmStartState& state, uint64_t monoNow, uint64_t systemNow);
+
+// A small "key value" text file, replaced atomically. Load returns nullopt
+// if the file is missing or incomplete.
+bool SaveWarmStart(const std::filesystem::path& path, const WarmStartState& state);
+std::optional<WarmStartState> LoadWarmStart(const std::filesystem::path& path);
+
+} // namespace clockcore
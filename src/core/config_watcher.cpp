@@ -0,0 +1,334 @@
+#include "config_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace clockcore {
+
+// Raw change events for a directory. Uses the platform's notifications when
+// they can be set up and otherwise stats the watched files every pollMs.
+class ConfigWatcher::Source {
+public:
+    Source(const std::filesystem::path& directory, const std::vector<std::string>& files, int pollMs)
+        : directory_(directory), files_(files), pollMs_(std::max(pollMs, 10)) {
+#if defined(__linux__)
+        inotify_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        wake_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB;
+        if (inotify_ < 0 || wake_ < 0 || inotify_add_watch(inotify_, directory.c_str(), mask) < 0) {
+            CloseNotifications();
+        }
+#elif defined(_WIN32)
+        directoryHandle_ = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                       nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        overlapped_.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        wake_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        if (directoryHandle_ == INVALID_HANDLE_VALUE || !overlapped_.hEvent || !wake_ || !IssueRead()) {
+            CloseNotifications();
+        }
+#endif
+        if (!notifying()) {
+            stamps_ = StampAll();
+        }
+    }
+
+    ~Source() { CloseNotifications(); }
+
+    bool notifying() const {
+#if defined(__linux__)
+        return inotify_ >= 0;
+#elif defined(_WIN32)
+        return directoryHandle_ != INVALID_HANDLE_VALUE;
+#else
+        return false;
+#endif
+    }
+
+    // Waits up to timeoutMs (-1: no limit) and appends the names of changed
+    // files; after an event overflow every watched file is reported. Returns
+    // false once interrupted.
+    bool Wait(int timeoutMs, std::vector<std::string>& names) {
+        if (!notifying()) {
+            return Poll(timeoutMs, names);
+        }
+#if defined(__linux__)
+        pollfd fds[2] = {{inotify_, POLLIN, 0}, {wake_, POLLIN, 0}};
+        if (poll(fds, 2, timeoutMs) <= 0) {
+            return true; // timeout or EINTR
+        }
+        if (fds[1].revents & POLLIN) {
+            return false;
+        }
+        alignas(inotify_event) char buffer[4096];
+        for (;;) {
+            ssize_t length = read(inotify_, buffer, sizeof(buffer));
+            if (length <= 0) {
+                return true;
+            }
+            for (ssize_t pos = 0; pos < length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + pos);
+                if (event->mask & IN_Q_OVERFLOW) {
+                    names.insert(names.end(), files_.begin(), files_.end());
+                } else if (event->len > 0) {
+                    names.emplace_back(event->name);
+                }
+                pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+#elif defined(_WIN32)
+        HANDLE handles[2] = {wake_, overlapped_.hEvent};
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+        if (result == WAIT_OBJECT_0) {
+            return false;
+        }
+        if (result != WAIT_OBJECT_0 + 1) {
+            return true;
+        }
+        DWORD bytes = 0;
+        GetOverlappedResult(directoryHandle_, &overlapped_, &bytes, FALSE);
+        if (bytes == 0) {
+            names.insert(names.end(), files_.begin(), files_.end()); // the change buffer overflowed
+        }
+        for (DWORD pos = 0; pos < bytes;) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer_ + pos);
+            int wideLength = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+            int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, nullptr, 0, nullptr, nullptr);
+            std::string name(static_cast<size_t>(size), '\0');
+            WideCharToMultiByte(CP_UTF8, 0, info->FileName, wideLength, name.data(), size, nullptr, nullptr);
+            names.push_back(std::move(name));
+            if (info->NextEntryOffset == 0) {
+                break;
+            }
+            pos += info->NextEntryOffset;
+        }
+        if (!IssueRead()) {
+            names.insert(names.end(), files_.begin(), files_.end());
+            CloseNotifications(); // the directory went away; poll from now on
+            stamps_ = StampAll();
+        }
+        return true;
+#else
+        return Poll(timeoutMs, names);
+#endif
+    }
+
+    void Interrupt() {
+#if defined(__linux__)
+        if (wake_ >= 0) {
+            uint64_t one = 1;
+            ssize_t written = write(wake_, &one, sizeof(one));
+            (void)written;
+        }
+#elif defined(_WIN32)
+        if (wake_) {
+            SetEvent(wake_);
+        }
+#endif
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupted_ = true;
+        interrupt_.notify_one();
+    }
+
+private:
+    struct Stamp {
+        bool exists = false;
+        uintmax_t size = 0;
+        std::filesystem::file_time_type modified;
+    };
+
+    std::vector<Stamp> StampAll() const {
+        std::vector<Stamp> stamps(files_.size());
+        for (size_t i = 0; i < files_.size(); ++i) {
+            std::error_code error;
+            std::filesystem::path path = directory_ / files_[i];
+            stamps[i].modified = std::filesystem::last_write_time(path, error);
+            stamps[i].exists = !error;
+            stamps[i].size = stamps[i].exists ? std::filesystem::file_size(path, error) : 0;
+        }
+        return stamps;
+    }
+
+    bool Poll(int timeoutMs, std::vector<std::string>& names) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            int waitMs = timeoutMs < 0 ? pollMs_ : std::min(timeoutMs, pollMs_);
+            if (interrupt_.wait_for(lock, std::chrono::milliseconds(waitMs), [this] { return interrupted_; })) {
+                return false;
+            }
+        }
+        std::vector<Stamp> stamps = StampAll();
+        for (size_t i = 0; i < stamps.size(); ++i) {
+            const Stamp& before = stamps_[i];
+            const Stamp& after = stamps[i];
+            if (before.exists != after.exists || before.size != after.size || before.modified != after.modified) {
+                names.push_back(files_[i]);
+            }
+        }
+        stamps_ = std::move(stamps);
+        return true;
+    }
+
+#ifdef _WIN32
+    bool IssueRead() {
+        const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+        return ReadDirectoryChangesW(directoryHandle_, buffer_, sizeof(buffer_), FALSE, filter, nullptr, &overlapped_, nullptr) != 0;
+    }
+#endif
+
+    void CloseNotifications() {
+#if defined(__linux__)
+        if (inotify_ >= 0) {
+            close(inotify_);
+            inotify_ = -1;
+        }
+        if (wake_ >= 0) {
+            close(wake_);
+            wake_ = -1;
+        }
+#elif defined(_WIN32)
+        if (directoryHandle_ != INVALID_HANDLE_VALUE) {
+            // The kernel writes into buffer_ until the read is canceled.
+            DWORD bytes = 0;
+            if (CancelIoEx(directoryHandle_, &overlapped_) || GetLastError() != ERROR_NOT_FOUND) {
+                GetOverlappedResult(directoryHandle_, &overlapped_, &bytes, TRUE);
+            }
+            CloseHandle(directoryHandle_);
+            directoryHandle_ = INVALID_HANDLE_VALUE;
+        }
+        if (overlapped_.hEvent) {
+            CloseHandle(overlapped_.hEvent);
+            overlapped_.hEvent = nullptr;
+        }
+        if (wake_) {
+            CloseHandle(wake_);
+            wake_ = nullptr;
+        }
+#endif
+    }
+
+    std::filesystem::path directory_;
+    std::vector<std::string> files_;
+    int pollMs_;
+#if defined(__linux__)
+    int inotify_ = -1;
+    int wake_ = -1;
+#elif defined(_WIN32)
+    HANDLE directoryHandle_ = INVALID_HANDLE_VALUE;
+    HANDLE wake_ = nullptr;
+    OVERLAPPED overlapped_ = {};
+    alignas(DWORD) BYTE buffer_[16384];
+#endif
+    // Polling fallback.
+    std::vector<Stamp> stamps_;
+    std::mutex mutex_;
+    std::condition_variable interrupt_;
+    bool interrupted_ = false;
+};
+
+ConfigWatcher::ConfigWatcher(std::filesystem::path directory, std::vector<std::string> files, ConfigChangeCallback callback,
+                             ConfigWatcherOptions options)
+    : directory_(std::move(directory)), files_(std::move(files)), callback_(std::move(callback)), options_(options) {
+    options_.debounceMs = std::max(options_.debounceMs, 0);
+    options_.maxDelayMs = std::max(options_.maxDelayMs, options_.debounceMs);
+    source_ = std::make_unique<Source>(directory_, files_, options_.pollMs);
+    thread_ = std::thread([this]() { Run(); });
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    Shutdown();
+}
+
+void ConfigWatcher::Shutdown() {
+    stopping_.store(true);
+    source_->Interrupt();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool ConfigWatcher::notifying() const {
+    return source_->notifying();
+}
+
+int ConfigWatcher::WatchedIndex(const std::string& name) const {
+    for (size_t i = 0; i < files_.size(); ++i) {
+#ifdef _WIN32
+        // NTFS names are case-insensitive; config names are ASCII.
+        bool same = files_[i].size() == name.size() && std::equal(name.begin(), name.end(), files_[i].begin(), [](char a, char b) {
+                        return (a >= 'A' && a <= 'Z' ? a + 32 : a) == (b >= 'A' && b <= 'Z' ? b + 32 : b);
+                    });
+#else
+        bool same = files_[i] == name;
+#endif
+        if (same) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void ConfigWatcher::Run() {
+    using Clock = std::chrono::steady_clock;
+    std::vector<bool> pending(files_.size(), false);
+    bool anyPending = false;
+    Clock::time_point quietAt;    // debounce deadline, pushed back by every event
+    Clock::time_point deliverBy;  // first pending event plus maxDelayMs
+    while (!stopping_.load()) {
+        int timeoutMs = -1;
+        if (anyPending) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(std::min(quietAt, deliverBy) - Clock::now()).count();
+            timeoutMs = static_cast<int>(std::max<long long>(left, 0));
+        }
+        std::vector<std::string> names;
+        if (!source_->Wait(timeoutMs, names)) {
+            return;
+        }
+        auto now = Clock::now();
+        for (const auto& name : names) {
+            int index = WatchedIndex(name);
+            if (index < 0) {
+                continue;
+            }
+            if (!anyPending) {
+                anyPending = true;
+                deliverBy = now + std::chrono::milliseconds(options_.maxDelayMs);
+            }
+            pending[static_cast<size_t>(index)] = true;
+            quietAt = now + std::chrono::milliseconds(options_.debounceMs);
+        }
+        if (!anyPending || now < std::min(quietAt, deliverBy)) {
+            continue;
+        }
+        std::vector<std::string> changed;
+        for (size_t i = 0; i < files_.size(); ++i) {
+            if (pending[i]) {
+                changed.push_back(files_[i]);
+                pending[i] = false;
+            }
+        }
+        anyPending = false;
+        if (callback_ && !stopping_.load()) {
+            callback_(changed);
+        }
+    }
+}
+
+} // namespace clockcore
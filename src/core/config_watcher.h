@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clockcore {
+
+// Called on the watcher thread with the watched names that changed, in the
+// order they were given to the watcher. Must not call Shutdown.
+using ConfigChangeCallback = std::function<void(const std::vector<std::string>& files)>;
+
+struct ConfigWatcherOptions {
+    // Changes are reported once the files have been quiet this long, so an
+    // editor's truncate-write-rename burst becomes one notification...
+    int debounceMs = 250;
+    // ...unless they keep changing for this long.
+    int maxDelayMs = 2000;
+    // Stat interval where no change notification API is available.
+    int pollMs = 1000;
+};
+
+// Watches files in one directory: inotify on Linux, ReadDirectoryChangesW on
+// Windows, and polling of size and modification time elsewhere or when the
+// watch cannot be set up. Writes in place, replace-by-rename and deletion
+// all count as changes. The directory must exist when the watcher starts.
+class ConfigWatcher {
+public:
+    ConfigWatcher(std::filesystem::path directory, std::vector<std::string> files, ConfigChangeCallback callback,
+                  ConfigWatcherOptions options = ConfigWatcherOptions());
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Joins the thread; pending changes are dropped. Idempotent; also run by
+    // the destructor.
+    void Shutdown();
+
+    // False when change notifications are unavailable and files are polled.
+    bool notifying() const;
+
+private:
+    class Source;
+
+    void Run();
+    int WatchedIndex(const std::string& name) const;
+
+    std::filesystem::path directory_;
+    std::vector<std::string> files_;
+    ConfigChangeCallback callback_;
+    ConfigWatcherOptions options_;
+    std::unique_ptr<Source> source_;
+    std::atomic<bool> stopping_{false};
+    std::thread thread_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,218 @@
+#include "dns_cache.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "calendar.h"
+#include "monotonic.h"
+#include "net.h"
+
+namespace clockcore {
+
+ResolveResult SystemResolver::Resolve(const std::string& host) {
+    ResolveResult result;
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_protocol = IPPROTO_UDP;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &addresses) != 0 || !addresses) {
+        return result;
+    }
+    for (addrinfo* addr = addresses; addr; addr = addr->ai_next) {
+        char text[64] = {};
+        if (addr->ai_family == AF_INET) {
+            inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(addr->ai_addr)->sin_addr, text, sizeof(text));
+        } else if (addr->ai_family == AF_INET6) {
+            inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(addr->ai_addr)->sin6_addr, text, sizeof(text));
+        } else {
+            continue;
+        }
+        if (text[0] && std::find(result.addresses.begin(), result.addresses.end(), text) == result.addresses.end()) {
+            result.addresses.push_back(text);
+        }
+    }
+    freeaddrinfo(addresses);
+    result.ok = !result.addresses.empty();
+    return result;
+}
+
+void StaticResolver::SetHost(const std::string& host, std::vector<std::string> addresses, uint32_t ttlSeconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResolveResult& result = hosts_[host];
+    result.ok = !addresses.empty();
+    result.addresses = std::move(addresses);
+    result.ttlSeconds = ttlSeconds;
+}
+
+void StaticResolver::RemoveHost(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hosts_.erase(host);
+}
+
+ResolveResult StaticResolver::Resolve(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++resolveCount_;
+    auto it = hosts_.find(host);
+    return it == hosts_.end() ? ResolveResult() : it->second;
+}
+
+uint64_t StaticResolver::resolveCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resolveCount_;
+}
+
+static uint64_t SecondsToTicks(uint32_t seconds) {
+    return static_cast<uint64_t>(seconds) * kTicksPerSecond;
+}
+
+DnsCache::DnsCache(std::shared_ptr<Resolver> resolver, DnsCacheOptions options)
+    : resolver_(std::move(resolver)), options_(options) {
+    if (options_.backgroundRefresh) {
+        refresher_ = std::thread([this]() { RefreshLoop(); });
+    }
+}
+
+DnsCache::~DnsCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    if (refresher_.joinable()) {
+        refresher_.join();
+    }
+}
+
+uint64_t DnsCache::Now() const {
+    return options_.clock ? options_.clock() : MonotonicTicks();
+}
+
+void DnsCache::Store(Entry& entry, const ResolveResult& result, uint64_t now) {
+    if (result.ok && !result.addresses.empty()) {
+        uint32_t ttl = result.ttlSeconds ? result.ttlSeconds : options_.defaultTtlSeconds;
+        ttl = std::clamp(ttl, options_.minTtlSeconds, options_.maxTtlSeconds);
+        entry.ok = true;
+        entry.addresses = result.addresses;
+        entry.resolvedAt = now;
+        entry.expiresAt = now + SecondsToTicks(ttl);
+        entry.refreshAt = now + SecondsToTicks(ttl) / 4 * 3;
+        return;
+    }
+    if (entry.ok && now < entry.expiresAt + SecondsToTicks(options_.maxStaleSeconds)) {
+        // Resolver failed: keep the last good addresses and retry later.
+        entry.refreshAt = now + SecondsToTicks(options_.negativeTtlSeconds);
+        return;
+    }
+    entry.ok = false;
+    entry.addresses.clear();
+    entry.resolvedAt = now;
+    entry.expiresAt = now + SecondsToTicks(options_.negativeTtlSeconds);
+    entry.refreshAt = entry.expiresAt;
+}
+
+DnsLookup DnsCache::Lookup(const std::string& host) {
+    DnsLookup lookup;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        // Re-fetched every pass: Clear() may run while we wait.
+        Entry& entry = entries_[host];
+        uint64_t now = Now();
+        if (entry.resolvedAt != 0) {
+            bool fresh = now < entry.expiresAt;
+            bool serveStale = entry.ok && options_.backgroundRefresh &&
+                              now < entry.expiresAt + SecondsToTicks(options_.maxStaleSeconds);
+            if (fresh || serveStale) {
+                entry.usedSinceRefresh = true;
+                if (entry.ok && now >= entry.refreshAt) {
+                    changed_.notify_all();
+                }
+                lookup.ok = entry.ok;
+                lookup.addresses = entry.addresses;
+                lookup.fromCache = true;
+                lookup.stale = !fresh;
+                return lookup;
+            }
+        }
+        if (!entry.resolving) {
+            entry.resolving = true;
+            break;
+        }
+        changed_.wait(lock); // someone else is resolving this host
+    }
+
+    lock.unlock();
+    ResolveResult result = resolver_->Resolve(host);
+    lock.lock();
+
+    Entry& entry = entries_[host];
+    uint64_t now = Now();
+    Store(entry, result, now);
+    entry.resolving = false;
+    changed_.notify_all();
+    lookup.ok = entry.ok;
+    lookup.addresses = entry.addresses;
+    lookup.stale = entry.ok && now >= entry.expiresAt;
+    return lookup;
+}
+
+void DnsCache::Invalidate(const std::string& host) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(host);
+    if (it != entries_.end() && !it->second.resolving) {
+        entries_.erase(it);
+    }
+}
+
+void DnsCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        it = it->second.resolving ? std::next(it) : entries_.erase(it);
+    }
+}
+
+void DnsCache::RefreshLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        uint64_t now = Now();
+        std::string due;
+        bool haveWork = false;
+        uint64_t earliest = 0;
+        for (auto& [host, entry] : entries_) {
+            // Only hosts someone still looks up are worth refreshing.
+            if (!entry.ok || entry.resolving || !entry.usedSinceRefresh) {
+                continue;
+            }
+            if (now >= entry.refreshAt) {
+                due = host;
+                break;
+            }
+            if (!haveWork || entry.refreshAt < earliest) {
+                earliest = entry.refreshAt;
+                haveWork = true;
+            }
+        }
+
+        if (due.empty()) {
+            if (haveWork) {
+                changed_.wait_for(lock, std::chrono::microseconds((earliest - now) / 10 + 1));
+            } else {
+                changed_.wait(lock);
+            }
+            continue;
+        }
+
+        Entry& entry = entries_[due];
+        entry.resolving = true;
+        entry.usedSinceRefresh = false;
+        lock.unlock();
+        ResolveResult result = resolver_->Resolve(due);
+        lock.lock();
+        Entry& refreshed = entries_[due];
+        Store(refreshed, result, Now());
+        refreshed.resolving = false;
+        changed_.notify_all();
+    }
+}
+
+} // namespace clockcore
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace clockcore {
+
+struct ResolveResult {
+    bool ok = false;
+    std::vector<std::string> addresses; // numeric, e.g. "192.0.2.1" or "2001:db8::1"
+    uint32_t ttlSeconds = 0;            // 0: the resolver does not know
+};
+
+// Name lookup behind the cache. Implementations must be thread-safe.
+class Resolver {
+public:
+    virtual ~Resolver() = default;
+    virtual ResolveResult Resolve(const std::string& host) = 0;
+};
+
+// getaddrinfo. It does not expose record TTLs, so ttlSeconds is 0.
+class SystemResolver : public Resolver {
+public:
+    ResolveResult Resolve(const std::string& host) override;
+};
+
+// Fixed host table, for offline setups and for exercising the cache without
+// a network. Unknown hosts fail; SetHost/RemoveHost may be called at any time.
+class StaticResolver : public Resolver {
+public:
+    void SetHost(const std::string& host, std::vector<std::string> addresses, uint32_t ttlSeconds = 0);
+    void RemoveHost(const std::string& host);
+    ResolveResult Resolve(const std::string& host) override;
+    uint64_t resolveCount() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, ResolveResult> hosts_;
+    uint64_t resolveCount_ = 0;
+};
+
+struct DnsCacheOptions {
+    uint32_t defaultTtlSeconds = 300; // when the resolver reports none
+    uint32_t minTtlSeconds = 30;
+    uint32_t maxTtlSeconds = 86400;
+    uint32_t negativeTtlSeconds = 30; // failed lookups are remembered this long
+    uint32_t maxStaleSeconds = 86400; // expired addresses still served while refresh fails
+    bool backgroundRefresh = true;    // re-resolve hot entries before they expire
+    std::function<uint64_t()> clock;  // monotonic 100-ns ticks; MonotonicTicks() if empty
+};
+
+struct DnsLookup {
+    bool ok = false;
+    std::vector<std::string> addresses;
+    bool fromCache = false;
+    bool stale = false; // past its TTL; a refresh is pending or failing
+};
+
+// Resolved-address cache with TTLs and negative caching. Concurrent misses
+// for one host share a single resolver call. With background refresh, a
+// thread re-resolves entries that were used since their last refresh once
+// three quarters of their TTL has passed, and keeps serving the old addresses
+// if the resolver is slow or down, so lookups rarely wait on DNS.
+class DnsCache {
+public:
+    explicit DnsCache(std::shared_ptr<Resolver> resolver, DnsCacheOptions options = DnsCacheOptions());
+    ~DnsCache();
+
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    DnsLookup Lookup(const std::string& host);
+    void Invalidate(const std::string& host);
+    void Clear();
+
+private:
+    struct Entry {
+        bool ok = false;
+        std::vector<std::string> addresses;
+        uint64_t resolvedAt = 0; // Now()
+        uint64_t refreshAt = 0;
+        uint64_t expiresAt = 0;
+        bool resolving = false;
+        bool usedSinceRefresh = false;
+    };
+
+    uint64_t Now() const;
+    void Store(Entry& entry, const ResolveResult& result, uint64_t now);
+    void RefreshLoop();
+
+    std::shared_ptr<Resolver> resolver_;
+    DnsCacheOptions options_;
+    std::mutex mutex_;
+    std::condition_variable changed_; // resolves finishing, refresh work, shutdown
+    std::map<std::string, Entry> entries_;
+    bool stopping_ = false;
+    std::thread refresher_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,143 @@
+#include "dst.h"
+
+#include <cwctype>
+
+namespace clockcore {
+
+namespace {
+
+constexpr uint64_t Utc(int year, int month, int day, int hour) {
+    CivilTime civil;
+    civil.year = year;
+    civil.month = month;
+    civil.day = day;
+    civil.hour = hour;
+    return FileTimeFromCivil(civil);
+}
+
+template <const DstRule& Rule>
+constexpr bool TransitionsAre(int year, int baseOffsetMinutes, uint64_t startUtc, uint64_t endUtc) {
+    DstTransitions transitions = GetDstTransitions<Rule>(year, baseOffsetMinutes);
+    return transitions.startUtc == startUtc && transitions.endUtc == endUtc;
+}
+
+// Published transitions (tzdata for New York, Berlin, Sydney and Auckland)
+// since each rule took its current form; a change to a rule table that moves
+// any of them fails the build.
+static_assert(TransitionsAre<kDstNorthAmerica>(2008, -300, Utc(2008, 3, 9, 7), Utc(2008, 11, 2, 6)));
+static_assert(TransitionsAre<kDstNorthAmerica>(2016, -300, Utc(2016, 3, 13, 7), Utc(2016, 11, 6, 6)));
+static_assert(TransitionsAre<kDstNorthAmerica>(2024, -300, Utc(2024, 3, 10, 7), Utc(2024, 11, 3, 6)));
+static_assert(TransitionsAre<kDstNorthAmerica>(2032, -300, Utc(2032, 3, 14, 7), Utc(2032, 11, 7, 6)));
+static_assert(TransitionsAre<kDstNorthAmerica>(2040, -300, Utc(2040, 3, 11, 7), Utc(2040, 11, 4, 6)));
+static_assert(TransitionsAre<kDstNorthAmerica>(2050, -300, Utc(2050, 3, 13, 7), Utc(2050, 11, 6, 6)));
+static_assert(TransitionsAre<kDstNorthAmerica>(2024, -480, Utc(2024, 3, 10, 10), Utc(2024, 11, 3, 9)));
+
+static_assert(TransitionsAre<kDstEurope>(1996, 60, Utc(1996, 3, 31, 1), Utc(1996, 10, 27, 1)));
+static_assert(TransitionsAre<kDstEurope>(2000, 60, Utc(2000, 3, 26, 1), Utc(2000, 10, 29, 1)));
+static_assert(TransitionsAre<kDstEurope>(2008, 60, Utc(2008, 3, 30, 1), Utc(2008, 10, 26, 1)));
+static_assert(TransitionsAre<kDstEurope>(2016, 60, Utc(2016, 3, 27, 1), Utc(2016, 10, 30, 1)));
+static_assert(TransitionsAre<kDstEurope>(2024, 60, Utc(2024, 3, 31, 1), Utc(2024, 10, 27, 1)));
+static_assert(TransitionsAre<kDstEurope>(2032, 60, Utc(2032, 3, 28, 1), Utc(2032, 10, 31, 1)));
+static_assert(TransitionsAre<kDstEurope>(2040, 60, Utc(2040, 3, 25, 1), Utc(2040, 10, 28, 1)));
+static_assert(TransitionsAre<kDstEurope>(2050, 0, Utc(2050, 3, 27, 1), Utc(2050, 10, 30, 1)));
+
+static_assert(TransitionsAre<kDstAustralia>(2008, 600, Utc(2008, 10, 4, 16), Utc(2008, 4, 5, 16)));
+static_assert(TransitionsAre<kDstAustralia>(2016, 600, Utc(2016, 10, 1, 16), Utc(2016, 4, 2, 16)));
+static_assert(TransitionsAre<kDstAustralia>(2024, 600, Utc(2024, 10, 5, 16), Utc(2024, 4, 6, 16)));
+static_assert(TransitionsAre<kDstAustralia>(2032, 600, Utc(2032, 10, 2, 16), Utc(2032, 4, 3, 16)));
+static_assert(TransitionsAre<kDstAustralia>(2040, 600, Utc(2040, 10, 6, 16), Utc(2040, 3, 31, 16)));
+static_assert(TransitionsAre<kDstAustralia>(2050, 600, Utc(2050, 10, 1, 16), Utc(2050, 4, 2, 16)));
+
+static_assert(TransitionsAre<kDstNewZealand>(2008, 720, Utc(2008, 9, 27, 14), Utc(2008, 4, 5, 14)));
+static_assert(TransitionsAre<kDstNewZealand>(2016, 720, Utc(2016, 9, 24, 14), Utc(2016, 4, 2, 14)));
+static_assert(TransitionsAre<kDstNewZealand>(2024, 720, Utc(2024, 9, 28, 14), Utc(2024, 4, 6, 14)));
+static_assert(TransitionsAre<kDstNewZealand>(2032, 720, Utc(2032, 9, 25, 14), Utc(2032, 4, 3, 14)));
+static_assert(TransitionsAre<kDstNewZealand>(2040, 720, Utc(2040, 9, 29, 14), Utc(2040, 3, 31, 14)));
+static_assert(TransitionsAre<kDstNewZealand>(2050, 720, Utc(2050, 9, 24, 14), Utc(2050, 4, 2, 14)));
+
+// The season lookups agree with the transitions on either side of them.
+static_assert(GetDstAdjustmentMinutes<kDstNorthAmerica>(-300, Utc(2024, 3, 10, 7) - 1) == 0);
+static_assert(GetDstAdjustmentMinutes<kDstNorthAmerica>(-300, Utc(2024, 3, 10, 7)) == 60);
+static_assert(GetDstAdjustmentMinutes<kDstAustralia>(600, Utc(2024, 1, 1, 0)) == 60);
+static_assert(GetDstAdjustmentMinutes<kDstAustralia>(600, Utc(2024, 4, 6, 16)) == 0);
+static_assert(GetDstInterval<kDstEurope>(60, Utc(2024, 7, 1, 0)).validFrom == Utc(2024, 3, 31, 1));
+static_assert(GetDstInterval<kDstEurope>(60, Utc(2024, 7, 1, 0)).validUntil == Utc(2024, 10, 27, 1));
+static_assert(GetDstInterval<kDstNewZealand>(720, Utc(2024, 12, 31, 23)).validUntil == Utc(2025, 4, 5, 14));
+static_assert(GetDstInterval<kDstNewZealand>(720, Utc(2024, 12, 31, 23)).adjustMinutes == 60);
+
+} // namespace
+
+// Compares in place rather than lowercasing a copy of the name.
+static bool EqualsIgnoreCase(const std::wstring& name, const wchar_t* lower) {
+    size_t i = 0;
+    for (; i < name.size() && lower[i] != L'\0'; ++i) {
+        if (static_cast<wchar_t>(towlower(name[i])) != lower[i]) {
+            return false;
+        }
+    }
+    return i == name.size() && lower[i] == L'\0';
+}
+
+DstScheme GetDstScheme(const std::wstring& cityName) {
+    // Mexico City is deliberately absent: Mexico never followed the US dates
+    // and abolished DST in 2022.
+    static const struct {
+        const wchar_t* name;
+        DstScheme scheme;
+    } kCitySchemes[] = {
+        {L"new york", DstScheme::NorthAmerica}, {L"los angeles", DstScheme::NorthAmerica}, {L"chicago", DstScheme::NorthAmerica},
+        {L"san francisco", DstScheme::NorthAmerica}, {L"toronto", DstScheme::NorthAmerica}, {L"london", DstScheme::Europe},
+        {L"berlin", DstScheme::Europe}, {L"paris", DstScheme::Europe}, {L"sydney", DstScheme::Australia},
+        {L"auckland", DstScheme::NewZealand},
+    };
+    for (const auto& entry : kCitySchemes) {
+        if (EqualsIgnoreCase(cityName, entry.name)) {
+            return entry.scheme;
+        }
+    }
+    return DstScheme::None;
+}
+
+const DstRule* GetDstRule(DstScheme scheme) {
+    switch (scheme) {
+    case DstScheme::NorthAmerica: return &kDstNorthAmerica;
+    case DstScheme::Europe: return &kDstEurope;
+    case DstScheme::Australia: return &kDstAustralia;
+    case DstScheme::NewZealand: return &kDstNewZealand;
+    default: return nullptr;
+    }
+}
+
+int GetDstAdjustmentMinutes(const DstRule& rule, int baseOffsetMinutes, uint64_t utcFileTime) {
+    if (&rule == &kDstNorthAmerica) {
+        return GetDstAdjustmentMinutes<kDstNorthAmerica>(baseOffsetMinutes, utcFileTime);
+    }
+    if (&rule == &kDstEurope) {
+        return GetDstAdjustmentMinutes<kDstEurope>(baseOffsetMinutes, utcFileTime);
+    }
+    if (&rule == &kDstAustralia) {
+        return GetDstAdjustmentMinutes<kDstAustralia>(baseOffsetMinutes, utcFileTime);
+    }
+    if (&rule == &kDstNewZealand) {
+        return GetDstAdjustmentMinutes<kDstNewZealand>(baseOffsetMinutes, utcFileTime);
+    }
+    return DstAdjustmentMinutes(rule, baseOffsetMinutes, utcFileTime);
+}
+
+DstInterval GetDstInterval(const DstRule& rule, int baseOffsetMinutes, uint64_t utcFileTime) {
+    if (&rule == &kDstNorthAmerica) {
+        return GetDstInterval<kDstNorthAmerica>(baseOffsetMinutes, utcFileTime);
+    }
+    if (&rule == &kDstEurope) {
+        return GetDstInterval<kDstEurope>(baseOffsetMinutes, utcFileTime);
+    }
+    if (&rule == &kDstAustralia) {
+        return GetDstInterval<kDstAustralia>(baseOffsetMinutes, utcFileTime);
+    }
+    if (&rule == &kDstNewZealand) {
+        return GetDstInterval<kDstNewZealand>(baseOffsetMinutes, utcFileTime);
+    }
+    return FindDstInterval(rule, baseOffsetMinutes, utcFileTime);
+}
+
+} // namespace clockcore
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "calendar.h"
+
+namespace clockcore {
+
+enum class DstScheme {
+    None,
+    NorthAmerica, // second Sun Mar 02:00 -> first Sun Nov 02:00 (US/Canada)
+    Europe,       // last Sun Mar 01:00 UTC -> last Sun Oct 01:00 UTC
+    Australia,    // first Sun Oct 02:00 -> first Sun Apr 03:00 (AU east)
+    NewZealand    // last Sun Sep 02:00 -> first Sun Apr 03:00 (NZ)
+};
+
+struct DstRule {
+    int startMonth;
+    int startWeek;     // 1-based; -1 = last
+    int startWeekday;  // 0=Sunday
+    int startHour;     // local (or UTC if timesAreUtc)
+    bool startInDst;   // offset includes DST at start boundary
+    int endMonth;
+    int endWeek;
+    int endWeekday;
+    int endHour;
+    bool endInDst;     // offset includes DST at end boundary
+    int adjustMinutes; // minutes to add when DST is active
+    bool timesAreUtc;  // transitions expressed in UTC (EU)
+};
+
+inline constexpr DstRule kDstNorthAmerica{3, 2, 0, 2, false, 11, 1, 0, 2, true, 60, false};
+inline constexpr DstRule kDstEurope{3, -1, 0, 1, false, 10, -1, 0, 1, false, 60, true};
+inline constexpr DstRule kDstAustralia{10, 1, 0, 2, false, 4, 1, 0, 3, true, 60, false};
+inline constexpr DstRule kDstNewZealand{9, -1, 0, 2, false, 4, 1, 0, 3, true, 60, false};
+
+constexpr int ResolveWeekdayOfMonth(int year, int month, int week, int weekday) {
+    int firstDow = WeekdayFromDays(DaysFromCivil(year, month, 1));
+    int daysInMonth = DaysInMonth(year, month);
+
+    if (week > 0) {
+        int day = 1 + ((weekday - firstDow + 7) % 7) + (week - 1) * 7;
+        return day < daysInMonth ? day : daysInMonth;
+    }
+
+    // last occurrence
+    int lastDow = (firstDow + daysInMonth - 1) % 7;
+    int day = daysInMonth - ((lastDow - weekday + 7) % 7);
+    return day;
+}
+
+constexpr uint64_t LocalToUtcFileTime(const CivilTime& local, int offsetMinutes) {
+    int64_t ticks = static_cast<int64_t>(FileTimeFromCivil(local)) - static_cast<int64_t>(offsetMinutes) * kTicksPerMinute;
+    return static_cast<uint64_t>(ticks);
+}
+
+constexpr uint64_t BuildTransitionUtc(const DstRule& rule, bool isStart, int year, int baseOffsetMinutes) {
+    int month = isStart ? rule.startMonth : rule.endMonth;
+    int week = isStart ? rule.startWeek : rule.endWeek;
+    int weekday = isStart ? rule.startWeekday : rule.endWeekday;
+    int hour = isStart ? rule.startHour : rule.endHour;
+    bool inDst = isStart ? rule.startInDst : rule.endInDst;
+
+    CivilTime local;
+    local.year = year;
+    local.month = month;
+    local.day = ResolveWeekdayOfMonth(year, month, week, weekday);
+    local.hour = hour;
+
+    int offset = 0;
+    if (!rule.timesAreUtc) {
+        offset = baseOffsetMinutes + (inDst ? rule.adjustMinutes : 0);
+    }
+
+    return LocalToUtcFileTime(local, offset);
+}
+
+// Half-open UTC interval [validFrom, validUntil) during which the DST
+// adjustment stays constant.
+struct DstInterval {
+    uint64_t validFrom;
+    uint64_t validUntil;
+    int adjustMinutes;
+};
+
+// UTC instants at which a rule starts and ends DST in a calendar year. For
+// southern rules the end comes first (April) and closes the season that
+// started the year before.
+struct DstTransitions {
+    uint64_t startUtc;
+    uint64_t endUtc;
+};
+
+constexpr int DstAdjustmentMinutes(const DstRule& rule, int baseOffsetMinutes, uint64_t utcFileTime) {
+    CivilTime utc = CivilFromFileTime(utcFileTime);
+
+    uint64_t startUtc = 0;
+    uint64_t endUtc = 0;
+    if (rule.startMonth > rule.endMonth) {
+        // Southern hemisphere style, spans year boundary.
+        int startYear = (utc.month <= rule.endMonth) ? utc.year - 1 : utc.year;
+        startUtc = BuildTransitionUtc(rule, true, startYear, baseOffsetMinutes);
+        endUtc = BuildTransitionUtc(rule, false, startYear + 1, baseOffsetMinutes);
+    } else {
+        startUtc = BuildTransitionUtc(rule, true, utc.year, baseOffsetMinutes);
+        endUtc = BuildTransitionUtc(rule, false, utc.year, baseOffsetMinutes);
+    }
+
+    if (startUtc == 0 || endUtc == 0) {
+        return 0;
+    }
+
+    bool active = false;
+    if (startUtc < endUtc) {
+        active = utcFileTime >= startUtc && utcFileTime < endUtc;
+    } else {
+        active = utcFileTime >= startUtc || utcFileTime < endUtc;
+    }
+    return active ? rule.adjustMinutes : 0;
+}
+
+constexpr DstInterval FindDstInterval(const DstRule& rule, int baseOffsetMinutes, uint64_t utcFileTime) {
+    // Transitions of the neighbouring years always bracket the instant, so
+    // sorting six edges is enough to find the enclosing interval.
+    struct Edge {
+        uint64_t at = 0;
+        bool startsDst = false;
+    };
+    int year = CivilFromFileTime(utcFileTime).year;
+    Edge edges[6];
+    int count = 0;
+    for (int y = year - 1; y <= year + 1; ++y) {
+        edges[count++] = {BuildTransitionUtc(rule, true, y, baseOffsetMinutes), true};
+        edges[count++] = {BuildTransitionUtc(rule, false, y, baseOffsetMinutes), false};
+    }
+    // Insertion sort: std::sort is not constexpr before C++20.
+    for (int i = 1; i < count; ++i) {
+        Edge edge = edges[i];
+        int j = i;
+        for (; j > 0 && edges[j - 1].at > edge.at; --j) {
+            edges[j] = edges[j - 1];
+        }
+        edges[j] = edge;
+    }
+
+    int last = 0;
+    while (last + 1 < count && edges[last + 1].at <= utcFileTime) {
+        ++last;
+    }
+    DstInterval interval{};
+    interval.validFrom = edges[last].at;
+    interval.validUntil = edges[last + 1 < count ? last + 1 : last].at;
+    interval.adjustMinutes = edges[last].startsDst ? rule.adjustMinutes : 0;
+    return interval;
+}
+
+// The same evaluations with the rule as a template argument: every field is
+// a constant, so the weekday arithmetic folds and whole years can be checked
+// with static_assert (see dst.cpp). The runtime entry points below dispatch
+// the built-in rules to these.
+template <const DstRule& Rule>
+constexpr DstTransitions GetDstTransitions(int year, int baseOffsetMinutes) {
+    return {BuildTransitionUtc(Rule, true, year, baseOffsetMinutes), BuildTransitionUtc(Rule, false, year, baseOffsetMinutes)};
+}
+
+template <const DstRule& Rule>
+constexpr int GetDstAdjustmentMinutes(int baseOffsetMinutes, uint64_t utcFileTime) {
+    return DstAdjustmentMinutes(Rule, baseOffsetMinutes, utcFileTime);
+}
+
+template <const DstRule& Rule>
+constexpr DstInterval GetDstInterval(int baseOffsetMinutes, uint64_t utcFileTime) {
+    return FindDstInterval(Rule, baseOffsetMinutes, utcFileTime);
+}
+
+DstScheme GetDstScheme(const std::wstring& cityName);
+const DstRule* GetDstRule(DstScheme scheme);
+int GetDstAdjustmentMinutes(const DstRule& rule, int baseOffsetMinutes, uint64_t utcFileTime);
+DstInterval GetDstInterval(const DstRule& rule, int baseOffsetMinutes, uint64_t utcFileTime);
+
+} // namespace clockcore
@@ -0,0 +1,56 @@
+#include "frame_format.h"
+
+#include <algorithm>
+
+#include "calendar.h"
+
+namespace clockcore {
+
+static wchar_t* WriteTwoDigits(wchar_t* out, int value) {
+    out[0] = static_cast<wchar_t>(L'0' + value / 10);
+    out[1] = static_cast<wchar_t>(L'0' + value % 10);
+    return out + 2;
+}
+
+void FormatFrame(std::vector<CityInfo>& cities, uint64_t utcFileTime, FrameText& frame) {
+    FormatFrame(cities, utcFileTime, 0, cities.size(), frame);
+}
+
+void FormatFrame(std::vector<CityInfo>& cities, uint64_t utcFileTime, size_t first, size_t count, FrameText& frame) {
+    static constexpr size_t kTimeSuffixLength = 10; // ": HH:MM:SS"
+
+    first = std::min(first, cities.size());
+    count = std::min(count, cities.size() - first);
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += cities[first + i].name.size() + kTimeSuffixLength;
+    }
+    frame.chars.resize(total);
+    frame.lines.resize(count);
+    frame.firstCity = first;
+
+    const int64_t utcSeconds = static_cast<int64_t>(utcFileTime / kTicksPerSecond);
+    wchar_t* out = frame.chars.data();
+    for (size_t i = 0; i < count; ++i) {
+        CityInfo& city = cities[first + i];
+        int offsetMinutes = GetCityOffsetMinutes(city, utcFileTime);
+        int64_t secondOfDay = (utcSeconds + static_cast<int64_t>(offsetMinutes) * 60) % 86400;
+        if (secondOfDay < 0) {
+            secondOfDay += 86400;
+        }
+
+        wchar_t* lineStart = out;
+        out = std::copy(city.name.begin(), city.name.end(), out);
+        *out++ = L':';
+        *out++ = L' ';
+        out = WriteTwoDigits(out, static_cast<int>(secondOfDay / 3600));
+        *out++ = L':';
+        out = WriteTwoDigits(out, static_cast<int>((secondOfDay / 60) % 60));
+        *out++ = L':';
+        out = WriteTwoDigits(out, static_cast<int>(secondOfDay % 60));
+
+        frame.lines[i] = {static_cast<size_t>(lineStart - frame.chars.data()), static_cast<size_t>(out - lineStart)};
+    }
+}
+
+} // namespace clockcore
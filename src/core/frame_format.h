@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "city.h"
+
+namespace clockcore {
+
+struct FrameLine {
+    size_t offset; // into FrameText::chars
+    size_t length;
+};
+
+// All display lines of one tick ("Name: HH:MM:SS"), packed into a single
+// buffer that is reused from frame to frame.
+struct FrameText {
+    std::vector<wchar_t> chars;
+    std::vector<FrameLine> lines;
+    size_t firstCity = 0; // lines[i] shows cities[firstCity + i]
+
+    const wchar_t* LineData(size_t index) const { return chars.data() + lines[index].offset; }
+    size_t LineLength(size_t index) const { return lines[index].length; }
+};
+
+// Formats every city against one UTC snapshot so all lines agree on the
+// second. Offsets come from each city's cache; buffers only grow.
+void FormatFrame(std::vector<CityInfo>& cities, uint64_t utcFileTime, FrameText& frame);
+// Formats only cities [first, first + count), e.g. the page on screen; the
+// rest are not touched, so their offsets are not refreshed either.
+void FormatFrame(std::vector<CityInfo>& cities, uint64_t utcFileTime, size_t first, size_t count, FrameText& frame);
+
+} // namespace clockcore
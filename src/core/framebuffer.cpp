@@ -0,0 +1,118 @@
+#include "framebuffer.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+namespace clockcore {
+
+void Framebuffer::Resize(int newWidth, int newHeight) {
+    width = newWidth > 0 ? newWidth : 0;
+    height = newHeight > 0 ? newHeight : 0;
+    pixels.assign(static_cast<size_t>(width) * static_cast<size_t>(height), Rgba{});
+}
+
+static void PutLe16(unsigned char* p, uint32_t value) {
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void PutLe32(unsigned char* p, uint32_t value) {
+    PutLe16(p, value);
+    PutLe16(p + 2, value >> 16);
+}
+
+static uint32_t GetLe16(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8;
+}
+
+static uint32_t GetLe32(const unsigned char* p) {
+    return GetLe16(p) | GetLe16(p + 2) << 16;
+}
+
+// BITMAPFILEHEADER (14 bytes) followed by a BITMAPINFOHEADER (40 bytes).
+static constexpr size_t kBmpHeaderSize = 54;
+
+bool SaveFramebufferBmp(const std::filesystem::path& path, const Framebuffer& image) {
+    uint32_t pixelBytes = static_cast<uint32_t>(image.pixels.size() * 4);
+    unsigned char header[kBmpHeaderSize] = {'B', 'M'};
+    PutLe32(header + 2, static_cast<uint32_t>(kBmpHeaderSize) + pixelBytes);
+    PutLe32(header + 10, static_cast<uint32_t>(kBmpHeaderSize));
+    PutLe32(header + 14, 40);
+    PutLe32(header + 18, static_cast<uint32_t>(image.width));
+    PutLe32(header + 22, static_cast<uint32_t>(-image.height)); // negative: top-down rows
+    PutLe16(header + 26, 1);
+    PutLe16(header + 28, 32);
+    PutLe32(header + 34, pixelBytes);
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    std::vector<unsigned char> row(static_cast<size_t>(image.width) * 4);
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            const Rgba& pixel = image.At(x, y);
+            unsigned char* p = row.data() + static_cast<size_t>(x) * 4;
+            p[0] = pixel.b;
+            p[1] = pixel.g;
+            p[2] = pixel.r;
+            p[3] = pixel.a;
+        }
+        out.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+    }
+    return static_cast<bool>(out);
+}
+
+bool LoadFramebufferBmp(const std::filesystem::path& path, Framebuffer& image) {
+    std::ifstream in(path, std::ios::binary);
+    unsigned char header[kBmpHeaderSize];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != 'B' || header[1] != 'M') {
+        return false;
+    }
+    uint32_t dataOffset = GetLe32(header + 10);
+    int32_t width = static_cast<int32_t>(GetLe32(header + 18));
+    int32_t height = static_cast<int32_t>(GetLe32(header + 22));
+    uint32_t bitsPerPixel = GetLe16(header + 28);
+    uint32_t compression = GetLe32(header + 30);
+    bool topDown = height < 0;
+    height = std::abs(height);
+    // BI_BITFIELDS (3) with the standard BGRA masks is how many tools write 32-bit files.
+    if (width <= 0 || height <= 0 || width > 32768 || height > 32768 || (bitsPerPixel != 32 && bitsPerPixel != 24) ||
+        (compression != 0 && compression != 3)) {
+        return false;
+    }
+
+    size_t bytesPerPixel = bitsPerPixel / 8;
+    size_t stride = (static_cast<size_t>(width) * bytesPerPixel + 3) & ~size_t{3};
+    std::vector<unsigned char> row(stride);
+    image.Resize(width, height);
+    in.seekg(dataOffset);
+    for (int i = 0; i < height; ++i) {
+        if (!in.read(reinterpret_cast<char*>(row.data()), static_cast<std::streamsize>(stride))) {
+            return false;
+        }
+        int y = topDown ? i : height - 1 - i;
+        for (int x = 0; x < width; ++x) {
+            const unsigned char* p = row.data() + static_cast<size_t>(x) * bytesPerPixel;
+            image.At(x, y) = Rgba{p[2], p[1], p[0], bytesPerPixel == 4 ? p[3] : uint8_t{255}};
+        }
+    }
+    return true;
+}
+
+size_t CountPixelDifferences(const Framebuffer& a, const Framebuffer& b, int tolerance) {
+    if (a.width != b.width || a.height != b.height) {
+        return SIZE_MAX;
+    }
+    size_t differences = 0;
+    for (size_t i = 0; i < a.pixels.size(); ++i) {
+        const Rgba& p = a.pixels[i];
+        const Rgba& q = b.pixels[i];
+        if (std::abs(p.r - q.r) > tolerance || std::abs(p.g - q.g) > tolerance || std::abs(p.b - q.b) > tolerance ||
+            std::abs(p.a - q.a) > tolerance) {
+            ++differences;
+        }
+    }
+    return differences;
+}
+
+} // namespace clockcore
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include "render.h"
+
+namespace clockcore {
+
+// Top-down, row-major RGBA pixels.
+struct Framebuffer {
+    int width = 0;
+    int height = 0;
+    std::vector<Rgba> pixels;
+
+    void Resize(int newWidth, int newHeight);
+    Rgba& At(int x, int y) { return pixels[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)]; }
+    const Rgba& At(int x, int y) const { return pixels[static_cast<size_t>(y) * static_cast<size_t>(width) + static_cast<size_t>(x)]; }
+};
+
+// Uncompressed 32-bit BMP, alpha kept. Load also accepts 24-bit files.
+bool SaveFramebufferBmp(const std::filesystem::path& path, const Framebuffer& image);
+bool LoadFramebufferBmp(const std::filesystem::path& path, Framebuffer& image);
+
+// Pixels whose channels differ by more than tolerance; SIZE_MAX when the
+// sizes differ.
+size_t CountPixelDifferences(const Framebuffer& a, const Framebuffer& b, int tolerance);
+
+} // namespace clockcore
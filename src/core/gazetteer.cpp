@@ -0,0 +1,608 @@
+#include "gazetteer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace clockcore {
+
+// On-disk layout, all little-endian and 4-byte aligned: header, nodes
+// (nodeCount + 1, the last a sentinel), postings, entries, labels, strings.
+// Node i's label is labels[labelBegin(i), labelBegin(i + 1)), its own
+// postings are postings[postingBegin(i), postingBegin(i + 1)), its subtree
+// is nodes [i, subtreeEnd), and its first child, if any, is node i + 1.
+// Siblings are ordered by their subtree's best population, highest first.
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; // kByteOrderMark as the builder wrote it
+    uint32_t nodeCount;
+    uint32_t labelBytes;
+    uint32_t postingCount;
+    uint32_t entryCount;
+    uint32_t stringBytes;
+    uint32_t nodesOffset;
+    uint32_t postingsOffset;
+    uint32_t entriesOffset;
+    uint32_t labelsOffset;
+    uint32_t stringsOffset;
+};
+
+struct IndexNode {
+    uint32_t labelBegin;
+    uint32_t subtreeEnd;
+    uint32_t postingBegin; // entries whose name ends exactly here, most populous first
+    uint32_t best;         // highest population in the subtree
+};
+
+struct IndexEntry {
+    uint32_t name; // offsets into the string pool
+    uint32_t country;
+    uint32_t zoneId;
+    int32_t offsetMinutes;
+    uint32_t population;
+};
+
+struct Gazetteer::Node : IndexNode {};
+struct Gazetteer::Entry : IndexEntry {};
+
+static constexpr char kIndexMagic[8] = {'W', 'C', 'G', 'A', 'Z', 'I', 'D', 'X'};
+static constexpr uint32_t kIndexVersion = 1;
+static constexpr uint32_t kByteOrderMark = 0x01020304;
+static constexpr size_t kMaxKeyBytes = 255;
+
+static uint32_t DecodeUtf8(const unsigned char*& p, const unsigned char* end) {
+    unsigned char lead = *p++;
+    if (lead < 0x80) {
+        return lead;
+    }
+    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0 || end - p < extra) {
+        return 0xFFFD;
+    }
+    uint32_t cp = lead & (0x3F >> extra);
+    for (int i = 0; i < extra; ++i) {
+        if ((*p & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (*p++ & 0x3F);
+    }
+    return cp;
+}
+
+static void AppendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// Base letters of U+00C0-U+00FF and U+0100-U+017F; ' ' marks a separator,
+// and ligatures are expanded in FoldLatin.
+static constexpr char kLatin1Base[] = "aaaaaaaceeeeiiiidnooooo ouuuuytsaaaaaaaceeeeiiiidnooooo ouuuuyty";
+static constexpr char kLatinExtendedABase[] =
+    "aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiiiiijjkkkllllllllllnnnnnnnnnoooooooorrrrrrsssssssstttttt"
+    "uuuuuuuuuuuuwwyyyzzzzzzs";
+static_assert(sizeof(kLatin1Base) == 64 + 1, "one letter per code point");
+static_assert(sizeof(kLatinExtendedABase) == 128 + 1, "one letter per code point");
+
+// Folded ASCII for a Latin letter, or nullptr if cp is not one we fold.
+static const char* FoldLatin(uint32_t cp, char (&single)[2]) {
+    switch (cp) {
+    case 0xC6: case 0xE6: return "ae";
+    case 0xDE: case 0xFE: return "th";
+    case 0xDF: return "ss";
+    case 0x132: case 0x133: return "ij";
+    case 0x152: case 0x153: return "oe";
+    case 0x218: case 0x219: return "s"; // Romanian comma-below letters
+    case 0x21A: case 0x21B: return "t";
+    default: break;
+    }
+    if (cp >= 0xC0 && cp <= 0xFF) {
+        single[0] = kLatin1Base[cp - 0xC0];
+    } else if (cp >= 0x100 && cp <= 0x17F) {
+        single[0] = kLatinExtendedABase[cp - 0x100];
+    } else {
+        return nullptr;
+    }
+    single[1] = '\0';
+    return single;
+}
+
+std::string NormalizeSearchKey(std::string_view utf8) {
+    std::string key;
+    bool separator = false;
+    auto append = [&](const char* text) {
+        if (separator && !key.empty()) {
+            key += ' ';
+        }
+        separator = false;
+        key += text;
+    };
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(utf8.data());
+    const unsigned char* end = p + utf8.size();
+    while (p < end && key.size() < kMaxKeyBytes) {
+        uint32_t cp = DecodeUtf8(p, end);
+        char single[2] = {};
+        if (cp < 0x80) {
+            if ((cp >= 'a' && cp <= 'z') || (cp >= '0' && cp <= '9')) {
+                single[0] = static_cast<char>(cp);
+                append(single);
+            } else if (cp >= 'A' && cp <= 'Z') {
+                single[0] = static_cast<char>(cp + ('a' - 'A'));
+                append(single);
+            } else if (cp != '\'') {
+                separator = true;
+            }
+            continue;
+        }
+        if (cp == 0x2019 || cp == 0x2BC) {
+            continue; // typographic apostrophes
+        }
+        if (const char* folded = FoldLatin(cp, single)) {
+            if (folded[0] == ' ') {
+                separator = true;
+            } else {
+                append(folded);
+            }
+            continue;
+        }
+        if (cp == 0xA0 || cp == 0x2010 || cp == 0x2013 || cp == 0x2014 || cp == 0xFFFD) {
+            separator = true;
+            continue;
+        }
+        if (cp >= 0x410 && cp <= 0x42F) {
+            cp += 0x20; // Cyrillic capitals
+        } else if (cp >= 0x400 && cp <= 0x40F) {
+            cp += 0x50;
+        } else if (cp >= 0x391 && cp <= 0x3A9 && cp != 0x3A2) {
+            cp += 0x20; // Greek capitals
+        }
+        std::string encoded;
+        AppendUtf8(encoded, cp);
+        append(encoded.c_str());
+    }
+    if (key.size() > kMaxKeyBytes) {
+        key.resize(kMaxKeyBytes);
+    }
+    return key;
+}
+
+namespace {
+
+struct KeyPosting {
+    std::string key;
+    uint32_t population;
+    uint32_t entry;
+};
+
+class IndexBuilder {
+public:
+    IndexBuilder(const std::vector<GazetteerRecord>& records) : records_(records) {}
+
+    std::vector<unsigned char> Build() {
+        strings_.push_back('\0'); // offset 0 is the empty string
+        for (const auto& record : records_) {
+            IndexEntry entry;
+            entry.name = Intern(record.name);
+            entry.country = Intern(record.country);
+            entry.zoneId = Intern(record.zoneId);
+            entry.offsetMinutes = record.offsetMinutes;
+            entry.population = record.population;
+            entries_.push_back(entry);
+        }
+
+        std::vector<KeyPosting> postings;
+        for (uint32_t i = 0; i < records_.size(); ++i) {
+            std::vector<std::string> keys;
+            keys.push_back(NormalizeSearchKey(records_[i].name));
+            for (const auto& alternate : records_[i].alternateNames) {
+                keys.push_back(NormalizeSearchKey(alternate));
+            }
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+            for (auto& key : keys) {
+                if (!key.empty()) {
+                    postings.push_back({std::move(key), records_[i].population, i});
+                }
+            }
+        }
+        std::sort(postings.begin(), postings.end(), [](const KeyPosting& a, const KeyPosting& b) {
+            if (a.key != b.key) {
+                return a.key < b.key;
+            }
+            return a.population != b.population ? a.population > b.population : a.entry < b.entry;
+        });
+        for (size_t i = 0; i < postings.size();) {
+            keys_.push_back(postings[i].key);
+            keyPostings_.push_back(static_cast<uint32_t>(sortedPostings_.size()));
+            for (; i < postings.size() && postings[i].key == keys_.back(); ++i) {
+                sortedPostings_.push_back(postings[i].entry);
+            }
+        }
+        keyPostings_.push_back(static_cast<uint32_t>(sortedPostings_.size()));
+
+        Emit(0, keys_.size(), 0, 0);
+        nodes_.push_back({static_cast<uint32_t>(labels_.size()), static_cast<uint32_t>(nodes_.size()), static_cast<uint32_t>(postingsOut_.size()), 0});
+        return Serialize();
+    }
+
+private:
+    uint32_t Intern(const std::string& text) {
+        if (text.empty()) {
+            return 0;
+        }
+        auto it = interned_.find(text);
+        if (it != interned_.end()) {
+            return it->second;
+        }
+        uint32_t offset = static_cast<uint32_t>(strings_.size());
+        strings_.insert(strings_.end(), text.begin(), text.end());
+        strings_.push_back('\0');
+        interned_.emplace(text, offset);
+        return offset;
+    }
+
+    static size_t CommonPrefix(const std::string& a, const std::string& b) {
+        size_t n = std::min(a.size(), b.size());
+        size_t i = 0;
+        while (i < n && a[i] == b[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    uint32_t RangeBest(size_t lo, size_t hi) const {
+        uint32_t best = 0;
+        for (size_t k = lo; k < hi; ++k) {
+            best = std::max(best, entries_[sortedPostings_[keyPostings_[k]]].population);
+        }
+        return best;
+    }
+
+    // Emits the node for the sorted keys [lo, hi), which share their first
+    // labelEnd bytes, and its subtree in pre-order, children most populous
+    // first.
+    void Emit(size_t lo, size_t hi, size_t depth, size_t labelEnd) {
+        size_t index = nodes_.size();
+        nodes_.push_back({static_cast<uint32_t>(labels_.size()), 0, static_cast<uint32_t>(postingsOut_.size()), RangeBest(lo, hi)});
+        labels_.append(keys_.empty() ? std::string() : keys_[lo].substr(depth, labelEnd - depth));
+        size_t next = lo;
+        if (next < hi && keys_[next].size() == labelEnd) {
+            postingsOut_.insert(postingsOut_.end(), sortedPostings_.begin() + keyPostings_[next],
+                                sortedPostings_.begin() + keyPostings_[next + 1]);
+            ++next;
+        }
+        struct Group {
+            size_t lo, hi;
+            uint32_t best;
+        };
+        std::vector<Group> groups;
+        while (next < hi) {
+            char first = keys_[next][labelEnd];
+            size_t end = next;
+            while (end < hi && keys_[end][labelEnd] == first) {
+                ++end;
+            }
+            groups.push_back({next, end, RangeBest(next, end)});
+            next = end;
+        }
+        std::stable_sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) { return a.best > b.best; });
+        for (const Group& group : groups) {
+            Emit(group.lo, group.hi, labelEnd, CommonPrefix(keys_[group.lo], keys_[group.hi - 1]));
+        }
+        nodes_[index].subtreeEnd = static_cast<uint32_t>(nodes_.size());
+    }
+
+    template <typename T>
+    static void Append(std::vector<unsigned char>& out, const T* data, size_t count) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+        out.resize((out.size() + 3) & ~size_t{3});
+    }
+
+    std::vector<unsigned char> Serialize() const {
+        IndexHeader header = {};
+        std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+        header.version = kIndexVersion;
+        header.byteOrder = kByteOrderMark;
+        header.nodeCount = static_cast<uint32_t>(nodes_.size() - 1);
+        header.labelBytes = static_cast<uint32_t>(labels_.size());
+        header.postingCount = static_cast<uint32_t>(postingsOut_.size());
+        header.entryCount = static_cast<uint32_t>(entries_.size());
+        header.stringBytes = static_cast<uint32_t>(strings_.size());
+
+        std::vector<unsigned char> out(sizeof(header));
+        header.nodesOffset = static_cast<uint32_t>(out.size());
+        Append(out, nodes_.data(), nodes_.size());
+        header.postingsOffset = static_cast<uint32_t>(out.size());
+        Append(out, postingsOut_.data(), postingsOut_.size());
+        header.entriesOffset = static_cast<uint32_t>(out.size());
+        Append(out, entries_.data(), entries_.size());
+        header.labelsOffset = static_cast<uint32_t>(out.size());
+        Append(out, labels_.data(), labels_.size());
+        header.stringsOffset = static_cast<uint32_t>(out.size());
+        Append(out, strings_.data(), strings_.size());
+        std::memcpy(out.data(), &header, sizeof(header));
+        return out;
+    }
+
+    const std::vector<GazetteerRecord>& records_;
+    std::vector<IndexEntry> entries_;
+    std::vector<char> strings_;
+    std::unordered_map<std::string, uint32_t> interned_;
+    std::vector<std::string> keys_;           // distinct, sorted
+    std::vector<uint32_t> keyPostings_;       // CSR into sortedPostings_
+    std::vector<uint32_t> sortedPostings_;
+    std::vector<IndexNode> nodes_;
+    std::string labels_;
+    std::vector<uint32_t> postingsOut_;
+};
+
+} // namespace
+
+std::vector<unsigned char> BuildGazetteerIndex(const std::vector<GazetteerRecord>& records) {
+    return IndexBuilder(records).Build();
+}
+
+bool Gazetteer::Open(const std::filesystem::path& path) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+    bytes_.clear();
+    file_ = std::move(file);
+    if (!Attach(file_.data(), file_.size())) {
+        file_.Close();
+        return false;
+    }
+    return true;
+}
+
+bool Gazetteer::Load(std::vector<unsigned char> bytes) {
+    file_.Close();
+    bytes_ = std::move(bytes);
+    return Attach(bytes_.data(), bytes_.size());
+}
+
+// Checks that every offset stays inside the file, so searches can follow
+// them without bounds checks; nothing is copied or decoded.
+bool Gazetteer::Attach(const unsigned char* data, size_t size) {
+    nodes_ = nullptr;
+    nodeCount_ = 0;
+    entryCount_ = 0;
+    IndexHeader header;
+    if (size < sizeof(header) || reinterpret_cast<uintptr_t>(data) % 4 != 0) {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || header.version != kIndexVersion ||
+        header.byteOrder != kByteOrderMark || header.nodeCount == 0 || header.stringBytes == 0) {
+        return false;
+    }
+    auto fits = [&](uint32_t offset, uint64_t bytes) { return offset % 4 == 0 && offset + bytes <= size; };
+    if (!fits(header.nodesOffset, (uint64_t{header.nodeCount} + 1) * sizeof(Node)) ||
+        !fits(header.postingsOffset, uint64_t{header.postingCount} * sizeof(uint32_t)) ||
+        !fits(header.entriesOffset, uint64_t{header.entryCount} * sizeof(Entry)) || !fits(header.labelsOffset, header.labelBytes) ||
+        !fits(header.stringsOffset, header.stringBytes)) {
+        return false;
+    }
+    const Node* nodes = reinterpret_cast<const Node*>(data + header.nodesOffset);
+    const uint32_t* postings = reinterpret_cast<const uint32_t*>(data + header.postingsOffset);
+    const Entry* entries = reinterpret_cast<const Entry*>(data + header.entriesOffset);
+    const char* strings = reinterpret_cast<const char*>(data + header.stringsOffset);
+
+    if (nodes[0].labelBegin != 0 || nodes[1].labelBegin != 0 || nodes[0].postingBegin != 0 ||
+        nodes[header.nodeCount].labelBegin != header.labelBytes || nodes[header.nodeCount].postingBegin != header.postingCount) {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.nodeCount; ++i) {
+        const Node& node = nodes[i];
+        bool labelOk = i == 0 || nodes[i + 1].labelBegin > node.labelBegin; // only the root has an empty label
+        if (!labelOk || node.subtreeEnd <= i || node.subtreeEnd > header.nodeCount || nodes[i + 1].postingBegin < node.postingBegin) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.postingCount; ++i) {
+        if (postings[i] >= header.entryCount) {
+            return false;
+        }
+    }
+    if (strings[header.stringBytes - 1] != '\0') {
+        return false;
+    }
+    for (uint32_t i = 0; i < header.entryCount; ++i) {
+        if (entries[i].name >= header.stringBytes || entries[i].country >= header.stringBytes || entries[i].zoneId >= header.stringBytes) {
+            return false;
+        }
+    }
+
+    nodes_ = nodes;
+    postings_ = postings;
+    entries_ = entries;
+    labels_ = reinterpret_cast<const char*>(data + header.labelsOffset);
+    strings_ = strings;
+    nodeCount_ = header.nodeCount;
+    entryCount_ = header.entryCount;
+    return true;
+}
+
+GazetteerEntry Gazetteer::entry(uint32_t index) const {
+    const Entry& e = entries_[index];
+    return {strings_ + e.name, strings_ + e.country, strings_ + e.zoneId, e.offsetMinutes, e.population};
+}
+
+uint32_t Gazetteer::LabelLength(uint32_t node) const {
+    return nodes_[node + 1].labelBegin - nodes_[node].labelBegin;
+}
+
+// Calls visit(byte, position) for each way the matched text can continue.
+template <typename F>
+void Gazetteer::ForEachNext(Position position, F&& visit) const {
+    const Node& node = nodes_[position.node];
+    if (position.consumed < LabelLength(position.node)) {
+        visit(labels_[node.labelBegin + position.consumed], Position{position.node, position.consumed + 1});
+        return;
+    }
+    for (uint32_t child = position.node + 1; child < node.subtreeEnd; child = nodes_[child].subtreeEnd) {
+        visit(labels_[nodes_[child].labelBegin], Position{child, 1});
+    }
+}
+
+// Collects the positions reachable by matching key[index..] with exactly one
+// edit, given that key[..index) matched without any.
+void Gazetteer::FuzzyWalk(Position position, const std::string& key, size_t index, std::vector<Position>& found) const {
+    auto follow = [&](Position from, size_t i) {
+        while (i < key.size()) {
+            bool moved = false;
+            ForEachNext(from, [&](char ch, Position next) {
+                if (!moved && ch == key[i]) {
+                    from = next;
+                    moved = true;
+                }
+            });
+            if (!moved) {
+                return;
+            }
+            ++i;
+        }
+        found.push_back(from);
+    };
+    if (index == key.size()) {
+        return; // no edit spent: the exact search covers it
+    }
+    follow(position, index + 1); // the query has an extra character
+    ForEachNext(position, [&](char ch, Position next) {
+        if (ch == key[index]) {
+            FuzzyWalk(next, key, index + 1, found);
+        } else {
+            follow(next, index + 1); // substitution
+            if (index + 1 < key.size() && ch == key[index + 1]) {
+                ForEachNext(next, [&](char second, Position after) {
+                    if (second == key[index]) {
+                        follow(after, index + 2); // transposition
+                    }
+                });
+            }
+        }
+        follow(next, index); // the query is missing a character
+    });
+}
+
+std::vector<GazetteerMatch> Gazetteer::Search(std::string_view utf8Query, size_t maxResults) const {
+    std::vector<GazetteerMatch> results;
+    std::string key = NormalizeSearchKey(utf8Query);
+    if (!nodes_ || key.empty() || maxResults == 0) {
+        return results;
+    }
+
+    // Best-first over subtrees: a node's score is the best population below
+    // it, so entries come out in population order within each rank. Postings
+    // and siblings are stored best first, so each popped item only needs to
+    // push its successor rather than every alternative.
+    struct Item {
+        uint32_t rank; // 0 exact, 1 prefix, 2 fuzzy exact, 3 fuzzy prefix
+        uint32_t score;
+        uint32_t node;
+        uint32_t posting;      // kNoPosting for the node's whole subtree
+        uint32_t siblingLimit; // parent's subtreeEnd to continue with the next sibling, else 0
+    };
+    constexpr uint32_t kNoPosting = UINT32_MAX;
+    auto worse = [](const Item& a, const Item& b) { return a.rank != b.rank ? a.rank > b.rank : a.score < b.score; };
+    std::vector<Item> heap;
+    auto push = [&](const Item& item) {
+        heap.push_back(item);
+        std::push_heap(heap.begin(), heap.end(), worse);
+    };
+    auto pushPosting = [&](uint32_t rank, uint32_t node, uint32_t posting) {
+        if (posting < nodes_[node + 1].postingBegin) {
+            push({rank, entries_[postings_[posting]].population, node, posting, 0});
+        }
+    };
+    auto pushSubtree = [&](uint32_t rank, uint32_t node, uint32_t siblingLimit) {
+        push({rank, nodes_[node].best, node, kNoPosting, siblingLimit});
+    };
+    auto pushChildren = [&](uint32_t rank, uint32_t node) {
+        if (node + 1 < nodes_[node].subtreeEnd) {
+            pushSubtree(rank, node + 1, nodes_[node].subtreeEnd);
+        }
+    };
+    auto pushRoot = [&](Position position, uint32_t baseRank) {
+        if (position.consumed < LabelLength(position.node)) {
+            pushSubtree(baseRank + 1, position.node, 0);
+            return;
+        }
+        pushPosting(baseRank, position.node, nodes_[position.node].postingBegin);
+        pushChildren(baseRank + 1, position.node);
+    };
+    auto drain = [&]() {
+        while (!heap.empty() && results.size() < maxResults) {
+            std::pop_heap(heap.begin(), heap.end(), worse);
+            Item item = heap.back();
+            heap.pop_back();
+            if (item.posting != kNoPosting) {
+                uint32_t entry = postings_[item.posting];
+                bool seen = std::any_of(results.begin(), results.end(), [&](const GazetteerMatch& m) { return m.entry == entry; });
+                if (!seen) {
+                    results.push_back({entry, item.rank >= 2 ? 1 : 0, item.rank % 2 == 0});
+                }
+                pushPosting(item.rank, item.node, item.posting + 1);
+                continue;
+            }
+            pushPosting(item.rank, item.node, nodes_[item.node].postingBegin);
+            pushChildren(item.rank, item.node);
+            uint32_t sibling = nodes_[item.node].subtreeEnd;
+            if (sibling < item.siblingLimit) {
+                pushSubtree(item.rank, sibling, item.siblingLimit);
+            }
+        }
+    };
+
+    Position position{0, 0};
+    bool matched = true;
+    for (size_t i = 0; i < key.size() && matched; ++i) {
+        matched = false;
+        ForEachNext(position, [&](char ch, Position next) {
+            if (!matched && ch == key[i]) {
+                position = next;
+                matched = true;
+            }
+        });
+    }
+    if (matched) {
+        pushRoot(position, 0);
+        drain();
+    }
+
+    if (results.size() < maxResults && key.size() >= 3) {
+        std::vector<Position> found;
+        FuzzyWalk(Position{0, 0}, key, 0, found);
+        // A whole-label position ranks its node's names as exact; prefer it.
+        std::sort(found.begin(), found.end(), [](const Position& a, const Position& b) {
+            return a.node != b.node ? a.node < b.node : a.consumed > b.consumed;
+        });
+        uint32_t last = UINT32_MAX;
+        heap.clear();
+        for (const Position& root : found) {
+            if (root.node != last) {
+                pushRoot(root, 2);
+                last = root.node;
+            }
+        }
+        drain();
+    }
+    return results;
+}
+
+} // namespace clockcore
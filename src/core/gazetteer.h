@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Searchable city gazetteer. An index is built offline (tools/gazetteer_build
+// from GeoNames or a pipe-separated list) into a flat little-endian file that
+// is memory-mapped and searched in place: a path-compressed trie over
+// normalized names, laid out in pre-order so every subtree is a contiguous
+// node range, plus a posting list per name and fixed-size entry records.
+
+namespace clockcore {
+
+struct GazetteerRecord {
+    std::string name; // UTF-8 display name
+    std::string country;
+    std::string zoneId;
+    int offsetMinutes = 0;   // standard UTC offset; used when the zone cannot be loaded
+    uint32_t population = 0; // ranking weight
+    std::vector<std::string> alternateNames; // also searchable, never displayed
+};
+
+// Search key for a UTF-8 name: ASCII letters and digits lowercased, accents
+// on Latin letters dropped (and ligatures such as "ß" expanded), Greek and
+// Cyrillic lowercased, apostrophes removed, and every other run of
+// punctuation or spaces turned into one space. "São Paulo" and "sao-paulo"
+// both become "sao paulo".
+std::string NormalizeSearchKey(std::string_view utf8);
+
+// Serializes records into the format Gazetteer reads.
+std::vector<unsigned char> BuildGazetteerIndex(const std::vector<GazetteerRecord>& records);
+
+struct GazetteerEntry {
+    const char* name; // UTF-8, NUL-terminated, owned by the index
+    const char* country;
+    const char* zoneId;
+    int offsetMinutes;
+    uint32_t population;
+};
+
+struct GazetteerMatch {
+    uint32_t entry;
+    int edits;  // 0, or 1 for a fuzzy match
+    bool exact; // some name of the entry equals the query (within the edits)
+};
+
+class Gazetteer {
+public:
+    // Maps an index file; false if it is missing or fails validation.
+    bool Open(const std::filesystem::path& path);
+    // Uses an index held in memory, e.g. from BuildGazetteerIndex.
+    bool Load(std::vector<unsigned char> bytes);
+
+    size_t size() const { return entryCount_; }
+    GazetteerEntry entry(uint32_t index) const;
+
+    // Up to maxResults distinct entries for what the user has typed so far,
+    // best first: names equal to the query, then names starting with it,
+    // each ordered by population. If that leaves room, and the query has at
+    // least three characters, names within one edit (insertion, deletion,
+    // substitution or transposition) fill the rest the same way.
+    std::vector<GazetteerMatch> Search(std::string_view utf8Query, size_t maxResults) const;
+
+private:
+    struct Node;
+    struct Entry;
+    struct Position {
+        uint32_t node;
+        uint32_t consumed; // bytes of the node's label matched so far
+    };
+
+    bool Attach(const unsigned char* data, size_t size);
+    uint32_t LabelLength(uint32_t node) const;
+    template <typename F>
+    void ForEachNext(Position position, F&& visit) const;
+    void FuzzyWalk(Position position, const std::string& key, size_t index, std::vector<Position>& found) const;
+
+    MappedFile file_;
+    std::vector<unsigned char> bytes_;
+    const Node* nodes_ = nullptr;
+    const char* labels_ = nullptr;
+    const uint32_t* postings_ = nullptr;
+    const Entry* entries_ = nullptr;
+    const char* strings_ = nullptr;
+    uint32_t nodeCount_ = 0;
+    uint32_t entryCount_ = 0;
+};
+
+} // namespace clockcore
@@ -0,0 +1,281 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <system_error>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace clockcore {
+
+static int HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+    constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+    value = std::min(value, (uint64_t{1} << kMaxValueBits) - 1);
+    if (value < kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    int shift = HighestBit(value) - kSubBucketBits;
+    return static_cast<size_t>(shift + 1) * kSubBuckets + static_cast<size_t>((value >> shift) - kSubBuckets);
+}
+
+uint64_t Histogram::BucketLowest(size_t index) {
+    constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    return (kSubBuckets + (index & (kSubBuckets - 1))) << shift;
+}
+
+uint64_t Histogram::BucketHighest(size_t index) {
+    if (index < (size_t{1} << kSubBucketBits)) {
+        return index;
+    }
+    int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+    return BucketLowest(index) + (uint64_t{1} << shift) - 1;
+}
+
+void Histogram::Record(int64_t value) {
+    uint64_t v = value < 0 ? 0 : static_cast<uint64_t>(value);
+    buckets_[BucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(v, std::memory_order_relaxed);
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (v > seen && !max_.compare_exchange_weak(seen, v, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::ValueAtQuantile(double q) const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets_) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    q = std::clamp(q, 0.0, 1.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(BucketHighest(i), max());
+        }
+    }
+    return max();
+}
+
+enum MetricKind { kCounterKind, kGaugeKind, kHistogramKind };
+
+struct MetricsRegistry::Entry {
+    std::string name;
+    std::string help;
+    int kind;
+    bool exported = true;
+    Counter counter;
+    Gauge gauge;
+    std::unique_ptr<Histogram> histogram; // only histograms pay for buckets
+};
+
+MetricsRegistry::MetricsRegistry() = default;
+MetricsRegistry::~MetricsRegistry() = default;
+
+MetricsRegistry::Entry& MetricsRegistry::Find(const std::string& name, const std::string& help, int kind) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (entry->name == name && entry->kind == kind) {
+            return *entry;
+        }
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->kind = kind;
+    if (kind == kHistogramKind) {
+        entry->histogram = std::make_unique<Histogram>();
+    }
+    // A clash with another kind stays out of the exports.
+    entry->exported = std::none_of(entries_.begin(), entries_.end(), [&](const std::unique_ptr<Entry>& other) { return other->name == name; });
+    entries_.push_back(std::move(entry));
+    return *entries_.back();
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name, const std::string& help) {
+    return Find(name, help, kCounterKind).counter;
+}
+
+Gauge& MetricsRegistry::GetGauge(const std::string& name, const std::string& help) {
+    return Find(name, help, kGaugeKind).gauge;
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name, const std::string& help) {
+    return *Find(name, help, kHistogramKind).histogram;
+}
+
+static const struct {
+    double q;
+    const char* label;
+    const char* jsonKey;
+} kExportQuantiles[] = {{0.5, "0.5", "p50"}, {0.9, "0.9", "p90"}, {0.99, "0.99", "p99"}, {0.999, "0.999", "p999"}};
+
+static void AppendHelp(std::string& out, const std::string& help) {
+    for (char ch : help) {
+        if (ch == '\\') {
+            out += "\\\\";
+        } else if (ch == '\n') {
+            out += "\\n";
+        } else {
+            out += ch;
+        }
+    }
+}
+
+std::string MetricsRegistry::FormatPrometheus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    for (const auto& entry : entries_) {
+        if (!entry->exported) {
+            continue;
+        }
+        const std::string& name = entry->name;
+        out += "# HELP " + name + " ";
+        AppendHelp(out, entry->help);
+        out += '\n';
+        switch (entry->kind) {
+        case kCounterKind:
+            out += "# TYPE " + name + " counter\n" + name + " " + std::to_string(entry->counter.value()) + "\n";
+            break;
+        case kGaugeKind:
+            out += "# TYPE " + name + " gauge\n" + name + " " + std::to_string(entry->gauge.value()) + "\n";
+            break;
+        default: {
+            const Histogram& histogram = *entry->histogram;
+            out += "# TYPE " + name + " summary\n";
+            for (const auto& quantile : kExportQuantiles) {
+                out += name + "{quantile=\"" + quantile.label + "\"} " + std::to_string(histogram.ValueAtQuantile(quantile.q)) + "\n";
+            }
+            out += name + "_sum " + std::to_string(histogram.sum()) + "\n";
+            out += name + "_count " + std::to_string(histogram.count()) + "\n";
+            out += "# TYPE " + name + "_max gauge\n" + name + "_max " + std::to_string(histogram.max()) + "\n";
+            break;
+        }
+        }
+    }
+    return out;
+}
+
+std::string MetricsRegistry::FormatJson() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string sections[3];
+    for (const auto& entry : entries_) {
+        if (!entry->exported) {
+            continue;
+        }
+        std::string& out = sections[entry->kind];
+        out += out.empty() ? "\"" : ",\"";
+        out += entry->name + "\":";
+        switch (entry->kind) {
+        case kCounterKind:
+            out += std::to_string(entry->counter.value());
+            break;
+        case kGaugeKind:
+            out += std::to_string(entry->gauge.value());
+            break;
+        default: {
+            const Histogram& histogram = *entry->histogram;
+            out += "{\"count\":" + std::to_string(histogram.count()) + ",\"sum\":" + std::to_string(histogram.sum()) +
+                   ",\"max\":" + std::to_string(histogram.max());
+            for (const auto& quantile : kExportQuantiles) {
+                out += ",\"" + std::string(quantile.jsonKey) + "\":" + std::to_string(histogram.ValueAtQuantile(quantile.q));
+            }
+            out += "}";
+            break;
+        }
+        }
+    }
+    return "{\"counters\":{" + sections[kCounterKind] + "},\"gauges\":{" + sections[kGaugeKind] + "},\"histograms\":{" +
+           sections[kHistogramKind] + "}}\n";
+}
+
+MetricsRegistry& DefaultMetrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+bool WriteMetricsFile(const MetricsRegistry& registry, const std::filesystem::path& path, MetricsFormat format) {
+    std::string text = format == MetricsFormat::Json ? registry.FormatJson() : registry.FormatPrometheus();
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+MetricsExporter::MetricsExporter(const MetricsRegistry& registry, MetricsExporterOptions options)
+    : registry_(registry), options_(std::move(options)) {
+    options_.intervalSeconds = std::max(options_.intervalSeconds, 1);
+    thread_ = std::thread([this]() { Run(); });
+}
+
+MetricsExporter::~MetricsExporter() {
+    Shutdown();
+}
+
+void MetricsExporter::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MetricsExporter::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        bool stopping = wake_.wait_for(lock, std::chrono::seconds(options_.intervalSeconds), [this] { return stopping_; });
+        lock.unlock();
+        WriteMetricsFile(registry_, options_.path, options_.format);
+        lock.lock();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+} // namespace clockcore
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// In-process metrics: counters, gauges and latency histograms that hot paths
+// update with a few relaxed atomic operations, and text exports of them for
+// a file or the local metrics endpoint (metrics_server.h).
+
+namespace clockcore {
+
+class Counter {
+public:
+    void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// HDR-style log-linear histogram of non-negative integers. Values below 32
+// are counted exactly; above that each power of two is split into 32
+// buckets, so any reported quantile is within about 3% of the true value.
+// Record is lock-free and allocation-free; readers may see a recording
+// that is only partly applied, which is harmless for monitoring.
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr int kMaxValueBits = 40; // larger values are clamped
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) << kSubBucketBits;
+
+    void Record(int64_t value);
+    void Reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+    // Highest value in the bucket holding the q-th (0..1) recording; 0 when empty.
+    uint64_t ValueAtQuantile(double q) const;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketLowest(size_t index);
+    static uint64_t BucketHighest(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Named metrics. Registration locks; the returned references stay valid for
+// the registry's lifetime, so callers look a metric up once and keep it.
+// Names follow Prometheus rules ([a-z_][a-z0-9_]*) and carry their unit.
+class MetricsRegistry {
+public:
+    MetricsRegistry();
+    ~MetricsRegistry();
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    // Returns the metric already registered under name, or registers it. A
+    // name is one kind of metric; asking for it as another kind returns a
+    // detached metric that is never exported.
+    Counter& GetCounter(const std::string& name, const std::string& help);
+    Gauge& GetGauge(const std::string& name, const std::string& help);
+    Histogram& GetHistogram(const std::string& name, const std::string& help);
+
+    // Prometheus text exposition format 0.0.4. Histograms are exported as
+    // summaries (quantiles 0.5, 0.9, 0.99, 0.999 plus _sum and _count) with
+    // a separate <name>_max gauge.
+    std::string FormatPrometheus() const;
+    // {"counters":{...},"gauges":{...},"histograms":{name:{count,sum,max,p50,p90,p99,p999}}}
+    std::string FormatJson() const;
+
+private:
+    struct Entry;
+
+    Entry& Find(const std::string& name, const std::string& help, int kind);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Entry>> entries_; // registration order
+};
+
+// The process-wide registry every component records into by default.
+MetricsRegistry& DefaultMetrics();
+
+enum class MetricsFormat { Prometheus, Json };
+
+// Writes the registry through a temporary file and a rename, so readers
+// never see a partial export.
+bool WriteMetricsFile(const MetricsRegistry& registry, const std::filesystem::path& path, MetricsFormat format);
+
+struct MetricsExporterOptions {
+    std::filesystem::path path;
+    MetricsFormat format = MetricsFormat::Prometheus;
+    int intervalSeconds = 10;
+};
+
+// Rewrites a metrics file every interval on its own thread, and once more
+// on shutdown.
+class MetricsExporter {
+public:
+    MetricsExporter(const MetricsRegistry& registry, MetricsExporterOptions options);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Joins the thread. Idempotent; also run by the destructor.
+    void Shutdown();
+
+private:
+    void Run();
+
+    const MetricsRegistry& registry_;
+    MetricsExporterOptions options_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,157 @@
+#include "metrics_server.h"
+
+#include <atomic>
+#include <thread>
+
+#include "net.h"
+
+namespace clockcore {
+
+struct MetricsServer::Impl {
+    SocketHandle listener = kInvalidSocket;
+    std::atomic<bool> stopping{false};
+    std::string port;
+    std::thread thread;
+};
+
+// The accept loop polls with this timeout so Stop() never waits on accept.
+static constexpr int kStopPollMs = 100;
+// A client that has not sent its request line by then is dropped.
+static constexpr int kRequestTimeoutMs = 1000;
+static constexpr size_t kMaxRequestBytes = 4096;
+
+static void SendAll(SocketHandle sock, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = static_cast<int>(send(sock, data.data() + sent, static_cast<int>(data.size() - sent), 0));
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+static std::string Response(const char* status, const char* contentType, const std::string& body) {
+    return std::string("HTTP/1.0 ") + status + "\r\nContent-Type: " + contentType + "\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\nConnection: close\r\n\r\n" + body;
+}
+
+static void HandleConnection(SocketHandle sock, const MetricsRegistry& registry) {
+    // Only the request line matters; headers are read and ignored.
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.find("\n\n") == std::string::npos &&
+           request.size() < kMaxRequestBytes) {
+        if (WaitReadable(sock, kRequestTimeoutMs) <= 0) {
+            return;
+        }
+        int n = static_cast<int>(recv(sock, buffer, static_cast<int>(sizeof(buffer)), 0));
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+    size_t methodEnd = request.find(' ');
+    size_t pathEnd = methodEnd == std::string::npos ? std::string::npos : request.find_first_of(" \r\n", methodEnd + 1);
+    if (pathEnd == std::string::npos) {
+        SendAll(sock, Response("400 Bad Request", "text/plain", "bad request\n"));
+        return;
+    }
+    std::string method = request.substr(0, methodEnd);
+    std::string path = request.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+    path = path.substr(0, path.find('?'));
+    bool head = method == "HEAD";
+    std::string response;
+    if (method != "GET" && !head) {
+        response = Response("405 Method Not Allowed", "text/plain", "GET only\n");
+    } else if (path == "/metrics") {
+        response = Response("200 OK", "text/plain; version=0.0.4", registry.FormatPrometheus());
+    } else if (path == "/metrics.json") {
+        response = Response("200 OK", "application/json", registry.FormatJson());
+    } else {
+        response = Response("404 Not Found", "text/plain", "try /metrics or /metrics.json\n");
+    }
+    if (head) {
+        response.resize(response.find("\r\n\r\n") + 4);
+    }
+    SendAll(sock, response);
+}
+
+static void Serve(SocketHandle listener, const std::atomic<bool>* stopping, const MetricsRegistry* registry) {
+    while (!stopping->load(std::memory_order_relaxed)) {
+        if (WaitReadable(listener, kStopPollMs) <= 0) {
+            continue;
+        }
+        SocketHandle client = accept(listener, nullptr, nullptr);
+        if (client == kInvalidSocket) {
+            continue;
+        }
+        HandleConnection(client, *registry);
+        CloseSocket(client);
+    }
+}
+
+MetricsServer::MetricsServer() : impl_(std::make_unique<Impl>()) {}
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+bool MetricsServer::Start(const MetricsRegistry& registry, const MetricsServerOptions& options, std::string& error) {
+    Stop();
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+    addrinfo* addr = nullptr;
+    if (getaddrinfo(options.bindAddress.c_str(), options.port.c_str(), &hints, &addr) != 0 || !addr) {
+        error = "cannot resolve " + options.bindAddress + ":" + options.port;
+        return false;
+    }
+    SocketHandle sock = socket(addr->ai_family, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == kInvalidSocket) {
+        freeaddrinfo(addr);
+        error = "socket() failed";
+        return false;
+    }
+#ifndef _WIN32
+    int one = 1; // restarts need not wait out TIME_WAIT
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+#endif
+    bool bound = bind(sock, addr->ai_addr, static_cast<SockLen>(addr->ai_addrlen)) == 0 && listen(sock, 16) == 0;
+    freeaddrinfo(addr);
+    if (!bound) {
+        CloseSocket(sock);
+        error = "cannot listen on " + options.bindAddress + ":" + options.port;
+        return false;
+    }
+
+    sockaddr_storage local = {};
+    SockLen length = sizeof(local);
+    getsockname(sock, reinterpret_cast<sockaddr*>(&local), &length);
+    uint16_t port = local.ss_family == AF_INET6 ? reinterpret_cast<const sockaddr_in6&>(local).sin6_port
+                                                : reinterpret_cast<const sockaddr_in&>(local).sin_port;
+    impl_->port = std::to_string(ntohs(port));
+    impl_->listener = sock;
+    impl_->stopping.store(false);
+    impl_->thread = std::thread(Serve, sock, &impl_->stopping, &registry);
+    return true;
+}
+
+void MetricsServer::Stop() {
+    impl_->stopping.store(true);
+    if (impl_->thread.joinable()) {
+        impl_->thread.join();
+    }
+    if (impl_->listener != kInvalidSocket) {
+        CloseSocket(impl_->listener);
+        impl_->listener = kInvalidSocket;
+    }
+}
+
+std::string MetricsServer::boundPort() const {
+    return impl_->port;
+}
+
+} // namespace clockcore
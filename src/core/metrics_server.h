@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "metrics.h"
+
+namespace clockcore {
+
+struct MetricsServerOptions {
+    std::string bindAddress = "127.0.0.1";
+    std::string port = "9464"; // "0" picks a free port; see boundPort()
+};
+
+// Serves a registry over plain HTTP on one thread, for scrapers and curl:
+// GET /metrics answers in the Prometheus text format, GET /metrics.json in
+// JSON. One request per connection; bind to loopback unless the network
+// is trusted, since there is no authentication.
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Binds and starts serving; on failure returns false and describes why.
+    bool Start(const MetricsRegistry& registry, const MetricsServerOptions& options, std::string& error);
+    void Stop();
+
+    std::string boundPort() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,368 @@
+#include "monotonic.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "calendar.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CLOCKCORE_X86_64 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace clockcore {
+
+using Ticks = std::chrono::duration<int64_t, std::ratio<1, 10000000>>;
+
+namespace {
+
+using SteadyTicks = std::chrono::steady_clock::duration;
+constexpr double kSteadyNanosPerUnit = 1e9 * SteadyTicks::period::num / SteadyTicks::period::den;
+
+uint64_t ReadSteady() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<uint64_t>(std::chrono::duration_cast<Ticks>(now).count());
+}
+
+#ifdef CLOCK_MONOTONIC_RAW
+uint64_t RawNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000u + static_cast<uint64_t>(now.tv_nsec);
+}
+
+uint64_t ReadRaw() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+    return static_cast<uint64_t>(now.tv_sec) * kTicksPerSecond + static_cast<uint64_t>(now.tv_nsec) / 100;
+}
+#endif
+
+#ifdef _WIN32
+uint64_t QpcFrequency() {
+    static const uint64_t frequency = [] {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        return static_cast<uint64_t>(value.QuadPart);
+    }();
+    return frequency;
+}
+
+uint64_t QpcCount() {
+    LARGE_INTEGER value;
+    QueryPerformanceCounter(&value);
+    return static_cast<uint64_t>(value.QuadPart);
+}
+
+uint64_t ReadQpc() {
+    uint64_t count = QpcCount();
+    uint64_t frequency = QpcFrequency();
+    if (frequency == kTicksPerSecond) {
+        return count; // the usual 10 MHz counter is already in ticks
+    }
+    return count / frequency * kTicksPerSecond + count % frequency * kTicksPerSecond / frequency;
+}
+#endif
+
+// Nanoseconds on the clock the TSC is calibrated against.
+uint64_t ReferenceNanos() {
+#if defined(CLOCK_MONOTONIC_RAW)
+    return RawNanos();
+#elif defined(_WIN32)
+    uint64_t count = QpcCount();
+    uint64_t frequency = QpcFrequency();
+    return count / frequency * 1000000000u + count % frequency * 1000000000u / frequency;
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+#ifdef CLOCKCORE_X86_64
+bool CpuHasInvariantTsc() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0x80000000);
+    if (static_cast<unsigned>(info[0]) < 0x80000007u) {
+        return false;
+    }
+    __cpuid(info, 0x80000007);
+    return (info[3] & (1 << 8)) != 0;
+#else
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    return __get_cpuid(0x80000007, &a, &b, &c, &d) && (d & (1u << 8));
+#endif
+}
+
+// Linux falls back from the TSC clocksource when it finds the counter
+// unstable (often on VMs or multi-socket hosts); trust it only while the
+// kernel does, and not at all without sysfs (some containers), where that
+// cannot be told. Elsewhere the CPUID bit is all there is.
+bool KernelTrustsTsc() {
+#ifdef __linux__
+    std::ifstream in("/sys/devices/system/clocksource/clocksource0/current_clocksource");
+    std::string current;
+    return (in >> current) && current == "tsc";
+#else
+    return true;
+#endif
+}
+
+// ticks = anchor ticks + (rdtsc - anchor tsc) * multiplier >> kTscShift, with the
+// TSC rate measured against ReferenceNanos() over kTscCalibrationMs. Any
+// error left in the rate is a constant frequency offset of a few ppm, which
+// the clock discipline measures and removes like any oscillator's.
+constexpr int kTscShift = 40;
+constexpr int kTscCalibrationMs = 20;
+
+struct TscScale {
+    uint64_t tsc = 0;
+    uint64_t ticks = 0;
+    uint64_t multiplier = 0;
+    double nanosPerCycle = 0;
+};
+
+struct TscAnchor {
+    uint64_t tsc;
+    uint64_t nanos;
+};
+
+// The TSC read between the two closest of a few reference reads.
+TscAnchor ReadTscAnchor() {
+    TscAnchor best = {0, 0};
+    uint64_t bestSpread = ~uint64_t{0};
+    for (int i = 0; i < 16; ++i) {
+        uint64_t before = ReferenceNanos();
+        uint64_t tsc = __rdtsc();
+        uint64_t after = ReferenceNanos();
+        if (after - before < bestSpread) {
+            bestSpread = after - before;
+            best = {tsc, before + (after - before) / 2};
+        }
+    }
+    return best;
+}
+
+const TscScale& Tsc() {
+    static const TscScale scale = [] {
+        TscAnchor start = ReadTscAnchor();
+        std::this_thread::sleep_for(std::chrono::milliseconds(kTscCalibrationMs));
+        TscAnchor end = ReadTscAnchor();
+        TscScale s;
+        s.nanosPerCycle = static_cast<double>(end.nanos - start.nanos) / static_cast<double>(end.tsc - start.tsc);
+        s.multiplier = static_cast<uint64_t>(std::ldexp(s.nanosPerCycle / 100.0, kTscShift) + 0.5);
+        s.tsc = end.tsc;
+        s.ticks = end.nanos / 100; // continue the reference clock's epoch
+        return s;
+    }();
+    return scale;
+}
+
+uint64_t ReadTsc() {
+    const TscScale& scale = Tsc();
+    uint64_t cycles = __rdtsc() - scale.tsc;
+#ifdef _MSC_VER
+    uint64_t high = 0;
+    uint64_t low = _umul128(cycles, scale.multiplier, &high);
+    return scale.ticks + __shiftright128(low, high, kTscShift);
+#else
+    return scale.ticks + static_cast<uint64_t>((static_cast<unsigned __int128>(cycles) * scale.multiplier) >> kTscShift);
+#endif
+}
+#endif // CLOCKCORE_X86_64
+
+using Reader = uint64_t (*)();
+
+Reader ReaderFor(MonotonicSource source) {
+    if (!IsMonotonicSourceAvailable(source)) {
+        return nullptr;
+    }
+    switch (source) {
+#ifdef CLOCK_MONOTONIC_RAW
+    case MonotonicSource::MonotonicRaw: return ReadRaw;
+#endif
+#ifdef _WIN32
+    case MonotonicSource::Qpc: return ReadQpc;
+#endif
+#ifdef CLOCKCORE_X86_64
+    case MonotonicSource::Tsc: return ReadTsc;
+#endif
+    case MonotonicSource::Steady: return ReadSteady;
+    default: return nullptr;
+    }
+}
+
+// The source's own counter and the nanoseconds one count lasts, for
+// measuring resolution finer than a tick.
+uint64_t ReadNative(MonotonicSource source) {
+    switch (source) {
+#ifdef CLOCK_MONOTONIC_RAW
+    case MonotonicSource::MonotonicRaw: return RawNanos();
+#endif
+#ifdef _WIN32
+    case MonotonicSource::Qpc: return QpcCount();
+#endif
+#ifdef CLOCKCORE_X86_64
+    case MonotonicSource::Tsc: return __rdtsc();
+#endif
+    default: return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    }
+}
+
+double NativeNanos(MonotonicSource source) {
+    switch (source) {
+    case MonotonicSource::MonotonicRaw: return 1.0;
+#ifdef _WIN32
+    case MonotonicSource::Qpc: return 1e9 / static_cast<double>(QpcFrequency());
+#endif
+#ifdef CLOCKCORE_X86_64
+    case MonotonicSource::Tsc: return Tsc().nanosPerCycle;
+#endif
+    default: return kSteadyNanosPerUnit;
+    }
+}
+
+constexpr MonotonicSource kSources[] = {MonotonicSource::Steady, MonotonicSource::MonotonicRaw, MonotonicSource::Qpc,
+                                        MonotonicSource::Tsc};
+
+MonotonicSource SelectSource() {
+    if (const char* name = std::getenv("CLOCKCORE_MONOTONIC_SOURCE")) {
+        for (MonotonicSource source : kSources) {
+            if (std::strcmp(name, MonotonicSourceName(source)) == 0 && IsMonotonicSourceAvailable(source)) {
+                return source;
+            }
+        }
+    }
+    for (MonotonicSource source : {MonotonicSource::MonotonicRaw, MonotonicSource::Qpc}) {
+        if (IsMonotonicSourceAvailable(source)) {
+            return source;
+        }
+    }
+    return MonotonicSource::Steady;
+}
+
+} // namespace
+
+uint64_t MonotonicTicks() {
+    static const Reader read = ReaderFor(ActiveMonotonicSource());
+    return read();
+}
+
+uint64_t SystemFileTime() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return kUnixEpochFileTime + static_cast<uint64_t>(std::chrono::duration_cast<Ticks>(now).count());
+}
+
+bool IsMonotonicSourceAvailable(MonotonicSource source) {
+    switch (source) {
+    case MonotonicSource::Steady: return true;
+    case MonotonicSource::MonotonicRaw: {
+#ifdef CLOCK_MONOTONIC_RAW
+        timespec now;
+        static const bool works = clock_gettime(CLOCK_MONOTONIC_RAW, &now) == 0;
+        return works;
+#else
+        return false;
+#endif
+    }
+    case MonotonicSource::Qpc:
+#ifdef _WIN32
+        return QpcFrequency() != 0;
+#else
+        return false;
+#endif
+    case MonotonicSource::Tsc: {
+#ifdef CLOCKCORE_X86_64
+        static const bool usable = CpuHasInvariantTsc() && KernelTrustsTsc();
+        return usable;
+#else
+        return false;
+#endif
+    }
+    }
+    return false;
+}
+
+const char* MonotonicSourceName(MonotonicSource source) {
+    switch (source) {
+    case MonotonicSource::Steady: return "steady";
+    case MonotonicSource::MonotonicRaw: return "raw";
+    case MonotonicSource::Qpc: return "qpc";
+    case MonotonicSource::Tsc: return "tsc";
+    }
+    return "?";
+}
+
+uint64_t ReadMonotonicSource(MonotonicSource source) {
+    Reader read = ReaderFor(source);
+    return read ? read() : 0;
+}
+
+MonotonicSourceReport MeasureMonotonicSource(MonotonicSource source, int reads) {
+    MonotonicSourceReport report;
+    report.source = source;
+    Reader read = ReaderFor(source);
+    if (!read) {
+        return report;
+    }
+    reads = std::max(reads, 1);
+    read(); // calibrate and fault in before timing
+
+    volatile uint64_t sink = 0;
+    uint64_t begin = ReferenceNanos();
+    for (int i = 0; i < reads; ++i) {
+        sink = read();
+    }
+    (void)sink;
+    uint64_t elapsed = ReferenceNanos() - begin;
+    report.readNanos = static_cast<double>(elapsed) / reads;
+
+    // The smallest nonzero step between consecutive readings, over at most
+    // 1000 steps and about 50 ms in all, so a coarse or stalled counter
+    // cannot hold the caller up.
+    uint64_t step = 0;
+    uint64_t deadline = ReferenceNanos() + 50000000;
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t first = ReadNative(source);
+        uint64_t next = first;
+        bool timedOut = false;
+        while (next == first && !(timedOut = ReferenceNanos() >= deadline)) {
+            next = ReadNative(source);
+        }
+        if (timedOut) {
+            break;
+        }
+        step = step == 0 ? next - first : std::min(step, next - first);
+    }
+    report.resolutionNanos = static_cast<double>(step) * NativeNanos(source);
+    return report;
+}
+
+MonotonicSource ActiveMonotonicSource() {
+    static const MonotonicSource active = SelectSource();
+    return active;
+}
+
+} // namespace clockcore
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace clockcore {
+
+// Monotonic clock in 100-ns ticks (same unit as FILETIME); the epoch is
+// arbitrary, so only differences are meaningful. Read from
+// ActiveMonotonicSource().
+uint64_t MonotonicTicks();
+
+// Host wall clock as FILETIME ticks (100 ns since 1601 UTC). May step.
+uint64_t SystemFileTime();
+
+enum class MonotonicSource {
+    Steady,       // std::chrono::steady_clock; always available
+    MonotonicRaw, // clock_gettime(CLOCK_MONOTONIC_RAW): the oscillator, never slewed by the host's NTP
+    Qpc,          // QueryPerformanceCounter (Windows)
+    Tsc           // invariant TSC (x86-64, and on Linux only while it is the kernel's clocksource),
+                  // calibrated against MonotonicRaw / Qpc over 20 ms on first read
+};
+
+bool IsMonotonicSourceAvailable(MonotonicSource source);
+const char* MonotonicSourceName(MonotonicSource source);
+
+// One reading of source in 100-ns ticks; each source has its own epoch, so
+// only compare readings of the same source. 0 if it is unavailable.
+uint64_t ReadMonotonicSource(MonotonicSource source);
+
+struct MonotonicSourceReport {
+    MonotonicSource source = MonotonicSource::Steady;
+    double readNanos = 0;       // mean cost of one ReadMonotonicSource()
+    double resolutionNanos = 0; // smallest step seen between consecutive native readings; 0 if none within 50 ms
+};
+
+// Times reads back-to-back reads of source (for benchmarks; never run
+// implicitly). Zeros if it is unavailable.
+MonotonicSourceReport MeasureMonotonicSource(MonotonicSource source, int reads = 20000);
+
+// The source MonotonicTicks() reads, fixed for the process: MonotonicRaw
+// where clock_gettime has it (Linux), Qpc on Windows, Steady elsewhere. The
+// TSC is never picked on its own; the CLOCKCORE_MONOTONIC_SOURCE environment
+// variable (steady, raw, qpc or tsc) selects any available source instead.
+MonotonicSource ActiveMonotonicSource();
+
+} // namespace clockcore
@@ -0,0 +1,93 @@
+#include "net.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#endif
+
+namespace clockcore {
+
+#ifdef _WIN32
+
+bool InitializeNetworking() {
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+}
+
+void ShutdownNetworking() {
+    WSACleanup();
+}
+
+void CloseSocket(SocketHandle sock) {
+    closesocket(sock);
+}
+
+bool SetNonBlocking(SocketHandle sock) {
+    u_long mode = 1;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0;
+}
+
+int LastSocketError() {
+    return WSAGetLastError();
+}
+
+bool IsWouldBlock(int error) {
+    return error == WSAEWOULDBLOCK;
+}
+
+bool IsInterrupted(int error) {
+    return error == WSAEINTR;
+}
+
+int WaitReadable(SocketHandle sock, int timeoutMs) {
+    WSAPOLLFD pfd = {};
+    pfd.fd = sock;
+    pfd.events = POLLRDNORM;
+    int ready = WSAPoll(&pfd, 1, timeoutMs);
+    return ready < 0 ? -1 : ready;
+}
+
+#else
+
+bool InitializeNetworking() {
+    return true;
+}
+
+void ShutdownNetworking() {
+}
+
+void CloseSocket(SocketHandle sock) {
+    close(sock);
+}
+
+bool SetNonBlocking(SocketHandle sock) {
+    int flags = fcntl(sock, F_GETFL, 0);
+    return flags >= 0 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int LastSocketError() {
+    return errno;
+}
+
+bool IsWouldBlock(int error) {
+    return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+bool IsInterrupted(int error) {
+    return error == EINTR;
+}
+
+int WaitReadable(SocketHandle sock, int timeoutMs) {
+    pollfd pfd = {};
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    int ready;
+    do {
+        ready = poll(&pfd, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    return ready < 0 ? -1 : ready;
+}
+
+#endif
+
+} // namespace clockcore
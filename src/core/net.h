@@ -0,0 +1,49 @@
+#pragma once
+
+// Minimal socket portability layer shared by the NTP client and tools.
+// Include only from .cpp files: it pulls in the platform socket headers.
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace clockcore {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+using SockLen = int;
+constexpr SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+using SocketHandle = int;
+using SockLen = socklen_t;
+constexpr SocketHandle kInvalidSocket = -1;
+#endif
+
+// WSAStartup/WSACleanup on Windows; no-ops elsewhere.
+bool InitializeNetworking();
+void ShutdownNetworking();
+
+void CloseSocket(SocketHandle sock);
+bool SetNonBlocking(SocketHandle sock);
+int LastSocketError();
+bool IsWouldBlock(int error);
+bool IsInterrupted(int error);
+
+// Waits until the socket is readable: 1 ready, 0 timeout, -1 error.
+int WaitReadable(SocketHandle sock, int timeoutMs);
+
+} // namespace clockcore
@@ -0,0 +1,136 @@
+#include "ntp.h"
+
+#include "calendar.h"
+
+namespace clockcore {
+
+static void WriteBe32(unsigned char* p, uint32_t v) {
+    p[0] = static_cast<unsigned char>(v >> 24);
+    p[1] = static_cast<unsigned char>(v >> 16);
+    p[2] = static_cast<unsigned char>(v >> 8);
+    p[3] = static_cast<unsigned char>(v);
+}
+
+static void WriteBe64(unsigned char* p, uint64_t v) {
+    WriteBe32(p, static_cast<uint32_t>(v >> 32));
+    WriteBe32(p + 4, static_cast<uint32_t>(v));
+}
+
+static uint32_t ReadBe32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static uint64_t ReadBe64(const unsigned char* p) {
+    return (static_cast<uint64_t>(ReadBe32(p)) << 32) | ReadBe32(p + 4);
+}
+
+void EncodeNtpPacket(const NtpPacket& packet, unsigned char out[kNtpPacketSize]) {
+    out[0] = static_cast<unsigned char>(((packet.leap & 0x3) << 6) | ((packet.version & 0x7) << 3) | (packet.mode & 0x7));
+    out[1] = packet.stratum;
+    out[2] = static_cast<unsigned char>(packet.poll);
+    out[3] = static_cast<unsigned char>(packet.precision);
+    WriteBe32(out + 4, packet.rootDelay);
+    WriteBe32(out + 8, packet.rootDispersion);
+    WriteBe32(out + 12, packet.referenceId);
+    WriteBe64(out + 16, packet.referenceTime);
+    WriteBe64(out + 24, packet.originTime);
+    WriteBe64(out + 32, packet.receiveTime);
+    WriteBe64(out + 40, packet.transmitTime);
+}
+
+bool DecodeNtpPacket(const unsigned char* data, size_t size, NtpPacket& packet) {
+    if (size < kNtpPacketSize) {
+        return false;
+    }
+    packet.leap = static_cast<uint8_t>(data[0] >> 6);
+    packet.version = static_cast<uint8_t>((data[0] >> 3) & 0x7);
+    packet.mode = static_cast<uint8_t>(data[0] & 0x7);
+    packet.stratum = data[1];
+    packet.poll = static_cast<int8_t>(data[2]);
+    packet.precision = static_cast<int8_t>(data[3]);
+    packet.rootDelay = ReadBe32(data + 4);
+    packet.rootDispersion = ReadBe32(data + 8);
+    packet.referenceId = ReadBe32(data + 12);
+    packet.referenceTime = ReadBe64(data + 16);
+    packet.originTime = ReadBe64(data + 24);
+    packet.receiveTime = ReadBe64(data + 32);
+    packet.transmitTime = ReadBe64(data + 40);
+    return true;
+}
+
+uint64_t NtpFromFileTime(uint64_t fileTime) {
+    uint64_t ticks = fileTime - kNtpEpochFileTime;
+    uint64_t seconds = ticks / kTicksPerSecond;
+    uint64_t remainder = ticks % kTicksPerSecond;
+    uint64_t fraction = (remainder << 32) / kTicksPerSecond;
+    return (seconds << 32) | (fraction & 0xFFFFFFFFull);
+}
+
+uint64_t FileTimeFromNtp(uint64_t ntpTime, uint64_t pivotFileTime) {
+    // Signed 32.32 distance from the pivot resolves the era.
+    int64_t delta = static_cast<int64_t>(ntpTime - NtpFromFileTime(pivotFileTime));
+    bool negative = delta < 0;
+    uint64_t magnitude = negative ? static_cast<uint64_t>(-delta) : static_cast<uint64_t>(delta);
+    uint64_t ticks = (magnitude >> 32) * kTicksPerSecond + (((magnitude & 0xFFFFFFFFull) * kTicksPerSecond) >> 32);
+    return negative ? pivotFileTime - ticks : pivotFileTime + ticks;
+}
+
+const char* NtpErrorName(NtpError error) {
+    switch (error) {
+    case NtpError::None: return "ok";
+    case NtpError::Resolve: return "resolve failed";
+    case NtpError::Socket: return "socket error";
+    case NtpError::Timeout: return "timeout";
+    case NtpError::Malformed: return "malformed reply";
+    case NtpError::BadMode: return "bad mode";
+    case NtpError::Unsynchronized: return "server unsynchronized";
+    case NtpError::KissOfDeath: return "kiss-o'-death";
+    case NtpError::BadStratum: return "bad stratum";
+    case NtpError::ZeroTimestamp: return "zero timestamp";
+    case NtpError::OriginMismatch: return "origin mismatch";
+    case NtpError::Canceled: return "canceled";
+    }
+    return "unknown";
+}
+
+NtpError EvaluateNtpResponse(const NtpPacket& response, uint64_t requestTransmit, uint64_t t1, uint64_t t4, NtpSample& sample) {
+    if (response.mode != kNtpModeServer) {
+        return NtpError::BadMode;
+    }
+    if (response.version < 1 || response.version > 4) {
+        return NtpError::Malformed;
+    }
+    if (response.stratum == 0) {
+        return NtpError::KissOfDeath;
+    }
+    if (response.stratum > kNtpMaxStratum) {
+        return NtpError::BadStratum;
+    }
+    if (response.leap == kNtpLeapUnsynchronized) {
+        return NtpError::Unsynchronized;
+    }
+    if (response.transmitTime == 0 || response.receiveTime == 0) {
+        return NtpError::ZeroTimestamp;
+    }
+    if (response.originTime != requestTransmit) {
+        return NtpError::OriginMismatch;
+    }
+
+    uint64_t t2 = FileTimeFromNtp(response.receiveTime, t1);
+    uint64_t t3 = FileTimeFromNtp(response.transmitTime, t4);
+    int64_t forward = static_cast<int64_t>(t2 - t1);
+    int64_t backward = static_cast<int64_t>(t3 - t4);
+    sample.offset = forward / 2 + backward / 2 + (forward % 2 + backward % 2) / 2;
+    sample.delay = static_cast<int64_t>(t4 - t1) - static_cast<int64_t>(t3 - t2);
+    if (sample.delay < 0) {
+        sample.delay = 0; // clock granularity on very short paths
+    }
+    sample.t4 = t4;
+    sample.stratum = response.stratum;
+    sample.rootDelay = response.rootDelay;
+    sample.rootDispersion = response.rootDispersion;
+    return NtpError::None;
+}
+
+} // namespace clockcore
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// NTPv4 on-wire format and the RFC 5905 offset/delay computation.
+
+namespace clockcore {
+
+constexpr size_t kNtpPacketSize = 48;
+constexpr uint8_t kNtpModeClient = 3;
+constexpr uint8_t kNtpModeServer = 4;
+constexpr uint8_t kNtpLeapUnsynchronized = 3;
+constexpr uint8_t kNtpMaxStratum = 15;
+
+// 1900-01-01 00:00 UTC in FILETIME ticks.
+constexpr uint64_t kNtpEpochFileTime = 94354848000000000ull;
+
+struct NtpPacket {
+    uint8_t leap = 0;
+    uint8_t version = 4;
+    uint8_t mode = kNtpModeClient;
+    uint8_t stratum = 0;
+    int8_t poll = 0;
+    int8_t precision = 0;
+    uint32_t rootDelay = 0;      // 16.16 seconds
+    uint32_t rootDispersion = 0; // 16.16 seconds
+    uint32_t referenceId = 0;
+    uint64_t referenceTime = 0;  // 32.32 NTP timestamps
+    uint64_t originTime = 0;
+    uint64_t receiveTime = 0;
+    uint64_t transmitTime = 0;
+};
+
+void EncodeNtpPacket(const NtpPacket& packet, unsigned char out[kNtpPacketSize]);
+bool DecodeNtpPacket(const unsigned char* data, size_t size, NtpPacket& packet);
+
+// 32.32 NTP timestamps <-> FILETIME. Decoding picks the NTP era closest to
+// pivotFileTime, so it keeps working past the 2036 rollover.
+uint64_t NtpFromFileTime(uint64_t fileTime);
+uint64_t FileTimeFromNtp(uint64_t ntpTime, uint64_t pivotFileTime);
+
+enum class NtpError {
+    None,
+    Resolve,
+    Socket,
+    Timeout,
+    Malformed,
+    BadMode,
+    Unsynchronized, // leap indicator 3
+    KissOfDeath,    // stratum 0
+    BadStratum,
+    ZeroTimestamp,
+    OriginMismatch,
+    Canceled
+};
+
+const char* NtpErrorName(NtpError error);
+
+// One client/server exchange. Times are FILETIME ticks on the client's clock
+// (t1 send, t4 receive) and the server's clock (t2 receive, t3 transmit).
+struct NtpSample {
+    int64_t offset = 0;       // server clock minus client clock
+    int64_t delay = 0;        // round trip excluding server processing, >= 0
+    uint64_t t4 = 0;
+    uint64_t monoAtReceive = 0;
+    uint8_t stratum = 0;
+    uint32_t rootDelay = 0;
+    uint32_t rootDispersion = 0;
+};
+
+// Validates a server reply against the request it answers (mode, leap,
+// stratum, non-zero timestamps, echoed origin) and computes
+// offset = ((t2 - t1) + (t3 - t4)) / 2 and delay = (t4 - t1) - (t3 - t2).
+NtpError EvaluateNtpResponse(const NtpPacket& response, uint64_t requestTransmit, uint64_t t1, uint64_t t4, NtpSample& sample);
+
+} // namespace clockcore
@@ -0,0 +1,273 @@
+#include "ntp_client.h"
+
+#include <cstring>
+#include <random>
+
+#include "dns_cache.h"
+#include "monotonic.h"
+#include "net.h"
+
+namespace clockcore {
+
+// Client-side timestamps come from one wall-clock reading advanced by the
+// monotonic clock, so a system clock step mid-exchange cannot skew t4 - t1.
+struct LocalClock {
+    uint64_t wallAtAnchor = SystemFileTime();
+    uint64_t monoAtAnchor = MonotonicTicks();
+
+    uint64_t At(uint64_t mono) const { return wallAtAnchor + (mono - monoAtAnchor); }
+};
+
+struct PendingRequest {
+    size_t replyIndex;
+    sockaddr_storage address;
+    SockLen addressLength;
+    uint64_t transmit; // on-wire transmit timestamp we expect echoed
+    uint64_t t1;
+    bool done;
+};
+
+static bool SameEndpoint(const sockaddr_storage& a, const sockaddr_storage& b) {
+    if (a.ss_family != b.ss_family) {
+        return false;
+    }
+    if (a.ss_family == AF_INET) {
+        const auto& x = reinterpret_cast<const sockaddr_in&>(a);
+        const auto& y = reinterpret_cast<const sockaddr_in&>(b);
+        return x.sin_port == y.sin_port && std::memcmp(&x.sin_addr, &y.sin_addr, sizeof(x.sin_addr)) == 0;
+    }
+    if (a.ss_family == AF_INET6) {
+        const auto& x = reinterpret_cast<const sockaddr_in6&>(a);
+        const auto& y = reinterpret_cast<const sockaddr_in6&>(b);
+        return x.sin6_port == y.sin6_port && std::memcmp(&x.sin6_addr, &y.sin6_addr, sizeof(x.sin6_addr)) == 0;
+    }
+    return false;
+}
+
+static std::string NumericAddress(const sockaddr_storage& address) {
+    char text[64] = {};
+    if (address.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in&>(address).sin_addr, text, sizeof(text));
+    } else if (address.ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6&>(address).sin6_addr, text, sizeof(text));
+    }
+    return text;
+}
+
+std::vector<NtpServerReply> QueryNtpServers(const std::vector<std::string>& hosts, const NtpQueryOptions& options) {
+    const std::atomic<bool>* cancel = options.cancel;
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+    std::vector<NtpServerReply> replies;
+    std::vector<PendingRequest> pending;
+
+    // Names resolve to numeric addresses first (through the cache when one
+    // is given); turning those into socket addresses never touches DNS.
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_flags = AI_NUMERICHOST;
+    SystemResolver systemResolver;
+    for (const auto& host : hosts) {
+        std::vector<std::string> numeric;
+        if (options.dns) {
+            DnsLookup lookup = options.dns->Lookup(host);
+            numeric = lookup.ok ? lookup.addresses : std::vector<std::string>();
+        } else {
+            numeric = systemResolver.Resolve(host).addresses;
+        }
+        if (numeric.empty()) {
+            NtpServerReply reply;
+            reply.host = host;
+            reply.error = NtpError::Resolve;
+            replies.push_back(reply);
+            continue;
+        }
+        size_t used = 0;
+        for (const auto& address : numeric) {
+            if (used >= options.maxAddressesPerHost) {
+                break;
+            }
+            addrinfo* addr = nullptr;
+            if (getaddrinfo(address.c_str(), options.port.c_str(), &hints, &addr) != 0 || !addr) {
+                continue;
+            }
+            if ((addr->ai_family != AF_INET && addr->ai_family != AF_INET6) || addr->ai_addrlen > sizeof(sockaddr_storage)) {
+                freeaddrinfo(addr);
+                continue;
+            }
+            PendingRequest request = {};
+            request.replyIndex = replies.size();
+            std::memcpy(&request.address, addr->ai_addr, addr->ai_addrlen);
+            request.addressLength = static_cast<SockLen>(addr->ai_addrlen);
+            pending.push_back(request);
+
+            NtpServerReply reply;
+            reply.host = host;
+            reply.address = NumericAddress(request.address);
+            replies.push_back(reply);
+            ++used;
+            freeaddrinfo(addr);
+        }
+    }
+
+    // One non-blocking socket per address family carries every request.
+    SocketHandle sockets[2] = {kInvalidSocket, kInvalidSocket};
+    auto socketFor = [&](int family) -> SocketHandle& { return sockets[family == AF_INET6 ? 1 : 0]; };
+    for (const auto& request : pending) {
+        SocketHandle& sock = socketFor(request.address.ss_family);
+        if (sock == kInvalidSocket) {
+            sock = socket(request.address.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+            if (sock != kInvalidSocket && !SetNonBlocking(sock)) {
+                CloseSocket(sock);
+                sock = kInvalidSocket;
+            }
+        }
+    }
+
+    LocalClock local;
+    size_t outstanding = 0;
+    for (auto& request : pending) {
+        SocketHandle sock = socketFor(request.address.ss_family);
+        NtpServerReply& reply = replies[request.replyIndex];
+        request.done = true;
+        if (sock == kInvalidSocket) {
+            reply.error = NtpError::Socket;
+            continue;
+        }
+        NtpPacket packet;
+        request.t1 = local.At(MonotonicTicks());
+        // The server only echoes this back as the origin timestamp; offsets
+        // use t1. So the whole 32-bit fraction is random, a nonce an off-path
+        // spoofer must guess (1 in 2^32) for a forged reply to be accepted.
+        request.transmit = (NtpFromFileTime(request.t1) & ~uint64_t{0xFFFFFFFF}) | (rng() & 0xFFFFFFFFu);
+        packet.transmitTime = request.transmit;
+        unsigned char buffer[kNtpPacketSize];
+        EncodeNtpPacket(packet, buffer);
+        int sent = static_cast<int>(sendto(sock, reinterpret_cast<const char*>(buffer), static_cast<int>(kNtpPacketSize), 0,
+                                           reinterpret_cast<const sockaddr*>(&request.address), request.addressLength));
+        if (sent != static_cast<int>(kNtpPacketSize)) {
+            reply.error = NtpError::Socket;
+            continue;
+        }
+        request.done = false;
+        ++outstanding;
+    }
+
+    uint64_t deadline = local.monoAtAnchor + static_cast<uint64_t>(options.timeoutMs) * 10000ull;
+    while (outstanding > 0) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            for (const auto& request : pending) {
+                if (!request.done) {
+                    replies[request.replyIndex].error = NtpError::Canceled;
+                }
+            }
+            break;
+        }
+        uint64_t now = MonotonicTicks();
+        if (now >= deadline) {
+            break;
+        }
+        int waitMs = static_cast<int>((deadline - now + 9999) / 10000);
+        if (cancel && waitMs > kCancelPollMs) {
+            waitMs = kCancelPollMs;
+        }
+#ifdef _WIN32
+        WSAPOLLFD fds[2] = {};
+        const short readable = POLLRDNORM;
+#else
+        pollfd fds[2] = {};
+        const short readable = POLLIN;
+#endif
+        unsigned long fdCount = 0;
+        for (SocketHandle sock : sockets) {
+            if (sock != kInvalidSocket) {
+                fds[fdCount].fd = sock;
+                fds[fdCount].events = readable;
+                ++fdCount;
+            }
+        }
+#ifdef _WIN32
+        int ready = WSAPoll(fds, fdCount, waitMs);
+#else
+        int ready = poll(fds, static_cast<nfds_t>(fdCount), waitMs);
+#endif
+        if (ready < 0) {
+            if (IsInterrupted(LastSocketError())) {
+                continue;
+            }
+            break;
+        }
+
+        for (unsigned long i = 0; i < fdCount; ++i) {
+            if (!(fds[i].revents & readable)) {
+                continue;
+            }
+            // Drain everything queued on this socket.
+            for (;;) {
+                unsigned char buffer[kNtpPacketSize * 2];
+                sockaddr_storage from = {};
+                SockLen fromLength = sizeof(from);
+                int received = static_cast<int>(recvfrom(fds[i].fd, reinterpret_cast<char*>(buffer), static_cast<int>(sizeof(buffer)), 0,
+                                                         reinterpret_cast<sockaddr*>(&from), &fromLength));
+                uint64_t mono4 = MonotonicTicks();
+                if (received < 0) {
+                    break; // would block, or an ICMP error surfaced as a socket error
+                }
+                NtpPacket response;
+                bool decoded = DecodeNtpPacket(buffer, static_cast<size_t>(received), response);
+                for (auto& request : pending) {
+                    if (request.done || !SameEndpoint(request.address, from)) {
+                        continue;
+                    }
+                    NtpServerReply& reply = replies[request.replyIndex];
+                    if (!decoded) {
+                        reply.error = NtpError::Malformed;
+                        continue;
+                    }
+                    NtpSample sample;
+                    NtpError error = EvaluateNtpResponse(response, request.transmit, request.t1, local.At(mono4), sample);
+                    if (error == NtpError::OriginMismatch) {
+                        reply.error = error; // stale or forged; keep waiting for ours
+                        continue;
+                    }
+                    sample.monoAtReceive = mono4;
+                    reply.error = error;
+                    reply.sample = sample;
+                    request.done = true;
+                    --outstanding;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (SocketHandle sock : sockets) {
+        if (sock != kInvalidSocket) {
+            CloseSocket(sock);
+        }
+    }
+    return replies;
+}
+
+NtpQueryResult QueryNtpServer(const std::string& host, int timeoutMs, const char* port) {
+    NtpQueryResult result;
+    bool haveError = false;
+    NtpQueryOptions options;
+    options.timeoutMs = timeoutMs;
+    options.port = port;
+    for (const auto& reply : QueryNtpServers({host}, options)) {
+        if (reply.error == NtpError::None) {
+            if (result.error != NtpError::None || reply.sample.delay < result.sample.delay) {
+                result.error = NtpError::None;
+                result.sample = reply.sample;
+            }
+        } else if (result.error != NtpError::None && !haveError) {
+            result.error = reply.error;
+            haveError = true;
+        }
+    }
+    return result;
+}
+
+} // namespace clockcore
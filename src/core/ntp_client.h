@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ntp.h"
+
+namespace clockcore {
+
+struct NtpQueryResult {
+    NtpError error = NtpError::Timeout;
+    NtpSample sample;
+};
+
+struct NtpServerReply {
+    std::string host;
+    std::string address; // numeric address the reply came from; empty if unresolved
+    NtpError error = NtpError::Timeout;
+    NtpSample sample;
+};
+
+class DnsCache;
+
+constexpr int kCancelPollMs = 50;
+
+struct NtpQueryOptions {
+    int timeoutMs = 2000;
+    std::string port = "123";
+    size_t maxAddressesPerHost = 4;
+    // Setting *cancel ends the wait within kCancelPollMs; unanswered servers
+    // then report NtpError::Canceled. Name resolution is not interruptible.
+    const std::atomic<bool>* cancel = nullptr;
+    // Addresses come from here when set; otherwise getaddrinfo on every query.
+    DnsCache* dns = nullptr;
+};
+
+// Queries every resolved address of every host at once from non-blocking
+// sockets driven by one poll loop. Returns when all have answered or when
+// timeoutMs has elapsed, so latency tracks the slowest reply, not the sum of
+// timeouts. All samples share one client clock anchor, so their offsets are
+// directly comparable.
+std::vector<NtpServerReply> QueryNtpServers(const std::vector<std::string>& hosts,
+                                            const NtpQueryOptions& options = NtpQueryOptions());
+
+// Single-host convenience wrapper: the lowest-delay valid reply among the
+// host's addresses.
+NtpQueryResult QueryNtpServer(const std::string& host, int timeoutMs = 2000, const char* port = "123");
+
+// UTC on the host's monotonic clock implied by a sample.
+inline uint64_t SampleUtcAtReceive(const NtpSample& sample) {
+    return sample.t4 + static_cast<uint64_t>(sample.offset);
+}
+
+} // namespace clockcore
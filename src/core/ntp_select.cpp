@@ -0,0 +1,145 @@
+#include "ntp_select.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "calendar.h"
+
+namespace clockcore {
+
+static constexpr int64_t kMinDistance = kTicksPerSecond / 1000;
+static constexpr size_t kMinClusterSurvivors = 3;
+static constexpr double kMinSelectionJitter = static_cast<double>(kTicksPerSecond) / 1000.0;
+
+int64_t NtpRootDistance(const NtpSample& sample) {
+    // rootDelay/rootDispersion are 16.16 seconds.
+    int64_t rootDelay = static_cast<int64_t>((static_cast<uint64_t>(sample.rootDelay) * kTicksPerSecond) >> 16);
+    int64_t rootDispersion = static_cast<int64_t>((static_cast<uint64_t>(sample.rootDispersion) * kTicksPerSecond) >> 16);
+    return std::max(kMinDistance, sample.delay / 2 + rootDelay / 2 + rootDispersion);
+}
+
+NtpSelection SelectNtpOffset(const std::vector<NtpSample>& samples) {
+    NtpSelection selection;
+    selection.candidates = samples.size();
+    if (samples.empty()) {
+        return selection;
+    }
+
+    struct Endpoint {
+        int64_t value;
+        int type; // -1 lower edge, 0 midpoint, +1 upper edge
+    };
+    std::vector<Endpoint> endpoints;
+    endpoints.reserve(samples.size() * 3);
+    for (const auto& sample : samples) {
+        int64_t distance = NtpRootDistance(sample);
+        endpoints.push_back({sample.offset - distance, -1});
+        endpoints.push_back({sample.offset, 0});
+        endpoints.push_back({sample.offset + distance, 1});
+    }
+    std::sort(endpoints.begin(), endpoints.end(), [](const Endpoint& a, const Endpoint& b) {
+        return a.value < b.value || (a.value == b.value && a.type < b.type);
+    });
+
+    // Allow f falsetickers, f < n/2, and look for an interval n - f agree on.
+    const int n = static_cast<int>(samples.size());
+    int64_t low = 0;
+    int64_t high = 0;
+    bool found = false;
+    for (int allow = 0; 2 * allow < n; ++allow) {
+        int chime = 0;
+        int midpoints = 0;
+        bool haveLow = false;
+        for (const auto& edge : endpoints) {
+            chime -= edge.type;
+            if (chime >= n - allow) {
+                low = edge.value;
+                haveLow = true;
+                break;
+            }
+            if (edge.type == 0) {
+                ++midpoints;
+            }
+        }
+        chime = 0;
+        bool haveHigh = false;
+        for (auto it = endpoints.rbegin(); it != endpoints.rend(); ++it) {
+            chime += it->type;
+            if (chime >= n - allow) {
+                high = it->value;
+                haveHigh = true;
+                break;
+            }
+            if (it->type == 0) {
+                ++midpoints;
+            }
+        }
+        if (haveLow && haveHigh && midpoints <= allow && low <= high) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        return selection;
+    }
+    selection.low = low;
+    selection.high = high;
+
+    std::vector<const NtpSample*> survivors;
+    for (const auto& sample : samples) {
+        int64_t distance = NtpRootDistance(sample);
+        if (sample.offset + distance >= low && sample.offset - distance <= high) {
+            survivors.push_back(&sample);
+        }
+    }
+    selection.truechimers = survivors.size();
+    if (survivors.empty()) {
+        return selection;
+    }
+
+    // Cluster: drop the survivor farthest (RMS) from the others until only a
+    // few remain or they agree to within the jitter floor.
+    while (survivors.size() > kMinClusterSurvivors) {
+        size_t worst = 0;
+        double worstJitter = -1;
+        for (size_t i = 0; i < survivors.size(); ++i) {
+            double sum = 0;
+            for (size_t j = 0; j < survivors.size(); ++j) {
+                double d = static_cast<double>(survivors[i]->offset - survivors[j]->offset);
+                sum += d * d;
+            }
+            double jitter = std::sqrt(sum / static_cast<double>(survivors.size() - 1));
+            if (jitter > worstJitter) {
+                worstJitter = jitter;
+                worst = i;
+            }
+        }
+        if (worstJitter < kMinSelectionJitter) {
+            break;
+        }
+        survivors.erase(survivors.begin() + static_cast<std::ptrdiff_t>(worst));
+    }
+    selection.survivors = survivors.size();
+
+    // Combine, weighting by 1/root distance (summed relative to the first
+    // survivor to keep the doubles small); the closest survivor is the system peer.
+    const int64_t reference = survivors.front()->offset;
+    double weightSum = 0;
+    double weighted = 0;
+    const NtpSample* best = survivors.front();
+    for (const NtpSample* sample : survivors) {
+        double weight = 1.0 / static_cast<double>(NtpRootDistance(*sample));
+        weightSum += weight;
+        weighted += weight * static_cast<double>(sample->offset - reference);
+        if (NtpRootDistance(*sample) < NtpRootDistance(*best)) {
+            best = sample;
+        }
+    }
+    int64_t combinedOffset = reference + static_cast<int64_t>(std::llround(weighted / weightSum));
+    selection.combined = *best;
+    selection.combined.offset = combinedOffset;
+    selection.valid = true;
+    return selection;
+}
+
+} // namespace clockcore
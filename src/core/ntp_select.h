@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ntp.h"
+
+namespace clockcore {
+
+struct NtpSelection {
+    bool valid = false;
+    NtpSample combined;   // system peer's sample carrying the combined offset
+    size_t candidates = 0;
+    size_t truechimers = 0; // samples whose interval meets the majority intersection
+    size_t survivors = 0;   // truechimers left after clustering
+    int64_t low = 0;        // majority intersection, offset ticks
+    int64_t high = 0;
+};
+
+// Half-width of a sample's correctness interval: half the round trip plus
+// the server's own root delay/dispersion, floored at 1 ms.
+int64_t NtpRootDistance(const NtpSample& sample);
+
+// RFC 5905 style selection: Marzullo intersection over the correctness
+// intervals (requires a majority), clustering to drop the outliers with the
+// largest selection jitter, then a 1/distance weighted average of the rest.
+// All samples must share one client clock anchor (see QueryNtpServers).
+NtpSelection SelectNtpOffset(const std::vector<NtpSample>& samples);
+
+} // namespace clockcore
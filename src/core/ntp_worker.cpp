@@ -0,0 +1,242 @@
+#include "ntp_worker.h"
+
+#include "calendar.h"
+
+namespace clockcore {
+
+struct NtpWorker::Metrics {
+    explicit Metrics(MetricsRegistry& registry)
+        : syncs(registry.GetCounter("ntp_syncs_total", "NTP syncs run to completion, successful or not.")),
+          failures(registry.GetCounter("ntp_sync_failures_total", "NTP syncs where no majority of servers agreed.")),
+          canceled(registry.GetCounter("ntp_syncs_canceled_total", "NTP syncs canceled before completing.")),
+          steps(registry.GetCounter("ntp_clock_steps_total", "Syncs that stepped the clock instead of slewing it.")),
+          replies(registry.GetCounter("ntp_replies_total", "Server queries made by NTP syncs.")),
+          replyErrors(registry.GetCounter("ntp_reply_errors_total", "Server queries that timed out or returned an unusable reply.")),
+          rtt(registry.GetHistogram("ntp_rtt_us", "Round-trip delay of each usable NTP reply.")),
+          offset(registry.GetHistogram("ntp_offset_abs_us", "Magnitude of the selected offset between the servers and the host clock.")),
+          lastOffset(registry.GetGauge("ntp_offset_us", "Selected offset of the last successful sync; positive when the host clock is behind.")),
+          residual(registry.GetGauge("ntp_residual_us", "Correction the last successful sync applied to the published clock.")),
+          frequency(registry.GetGauge("ntp_frequency_ppb", "Estimated frequency error of the monotonic clock.")),
+          pollSeconds(registry.GetGauge("ntp_poll_seconds", "Interval until the next scheduled sync.")) {}
+
+    Counter& syncs;
+    Counter& failures;
+    Counter& canceled;
+    Counter& steps;
+    Counter& replies;
+    Counter& replyErrors;
+    Histogram& rtt;
+    Histogram& offset;
+    Gauge& lastOffset;
+    Gauge& residual;
+    Gauge& frequency;
+    Gauge& pollSeconds;
+};
+
+NtpWorker::NtpWorker(PublishedClock& clock, NtpSyncCallback callback, NtpWorkerOptions options)
+    : clock_(clock), callback_(std::move(callback)), options_(std::move(options)) {
+    if (!options_.dns) {
+        options_.dns = std::make_shared<DnsCache>(std::make_shared<SystemResolver>());
+    }
+    metrics_ = std::make_unique<Metrics>(options_.metrics ? *options_.metrics : DefaultMetrics());
+    if (options_.initialClock.valid) {
+        discipline_.Seed(options_.initialClock, options_.initialFrequencyKnown);
+        clock_.Publish(options_.initialClock);
+    }
+    thread_ = std::thread([this]() { Run(); });
+}
+
+NtpWorker::~NtpWorker() {
+    Shutdown();
+}
+
+void NtpWorker::SetServers(std::vector<std::string> hosts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hosts_ = std::move(hosts);
+}
+
+uint64_t NtpWorker::RequestSync(uint64_t tag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+        return 0;
+    }
+    for (const auto& request : queue_) {
+        if (request.tag == tag && !request.canceled) {
+            return request.id;
+        }
+    }
+    uint64_t id = nextId_++;
+    queue_.push_back({id, tag, false});
+    wake_.notify_one();
+    return id;
+}
+
+void NtpWorker::ScheduleSync(int delaySeconds) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nextPoll_ = std::chrono::steady_clock::now() + std::chrono::seconds(delaySeconds);
+    pollScheduled_ = true;
+    wake_.notify_one();
+}
+
+bool NtpWorker::Cancel(uint64_t requestId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& request : queue_) {
+        if (request.id == requestId) {
+            request.canceled = true;
+            return true;
+        }
+    }
+    if (runningId_ != 0 && runningId_ == requestId) {
+        cancelRunning_.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void NtpWorker::CancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& request : queue_) {
+        request.canceled = true;
+    }
+    cancelRunning_.store(true, std::memory_order_relaxed);
+}
+
+void NtpWorker::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto& request : queue_) {
+            request.canceled = true;
+        }
+        cancelRunning_.store(true, std::memory_order_relaxed);
+    }
+    wake_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void NtpWorker::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        if (queue_.empty() && !stopping_) {
+            if (pollScheduled_) {
+                wake_.wait_until(lock, nextPoll_);
+            } else {
+                wake_.wait(lock);
+            }
+        }
+
+        Request request = {0, 0, false};
+        if (!queue_.empty()) {
+            request = queue_.front();
+            queue_.pop_front();
+        } else if (stopping_) {
+            break;
+        } else if (pollScheduled_ && std::chrono::steady_clock::now() >= nextPoll_) {
+            request.id = nextId_++;
+        } else {
+            continue; // spurious wakeup
+        }
+        if (stopping_) {
+            request.canceled = true;
+        }
+        std::vector<std::string> hosts = hosts_;
+        runningId_ = request.id;
+        cancelRunning_.store(request.canceled, std::memory_order_relaxed);
+        lock.unlock();
+
+        NtpSyncResult result = Sync(request, hosts);
+        RecordMetrics(result);
+        if (callback_) {
+            callback_(result);
+        }
+
+        lock.lock();
+        runningId_ = 0;
+        auto now = std::chrono::steady_clock::now();
+        if (!result.canceled && options_.autoPoll && !stopping_) {
+            nextPoll_ = now + std::chrono::seconds(result.pollSeconds);
+            pollScheduled_ = true;
+        } else if (result.canceled && pollScheduled_ && now >= nextPoll_) {
+            // A canceled poll would otherwise still be due and start again at
+            // once; try again one current poll interval from now. A canceled
+            // on-demand sync leaves a future poll as it was.
+            nextPoll_ = now + std::chrono::seconds(discipline_.pollSeconds());
+        }
+    }
+}
+
+NtpSyncResult NtpWorker::Sync(const Request& request, const std::vector<std::string>& hosts) {
+    NtpSyncResult result;
+    result.requestId = request.id;
+    result.tag = request.tag;
+    if (request.canceled) {
+        result.canceled = true;
+        return result;
+    }
+
+    // All servers are queried at once; only time a majority agrees on is used.
+    NtpQueryOptions query;
+    query.timeoutMs = options_.timeoutMs;
+    query.port = options_.port;
+    query.cancel = &cancelRunning_;
+    query.dns = options_.dns.get();
+    result.replies = QueryNtpServers(hosts, query);
+    if (cancelRunning_.load(std::memory_order_relaxed)) {
+        result.canceled = true;
+        return result;
+    }
+    std::vector<NtpSample> samples;
+    for (const auto& reply : result.replies) {
+        if (reply.error == NtpError::None) {
+            samples.push_back(reply.sample);
+        }
+    }
+    result.selection = SelectNtpOffset(samples);
+    if (!result.selection.valid) {
+        return result;
+    }
+
+    // The discipline slews toward the new time and tracks drift, so the
+    // published clock never jumps for small corrections.
+    const NtpSample& best = result.selection.combined;
+    clock_.Publish(discipline_.Update(SampleUtcAtReceive(best), best.monoAtReceive, NtpRootDistance(best)));
+    result.ok = true;
+    result.clock = discipline_.clock();
+    result.stepped = discipline_.lastStepped();
+    result.residual = discipline_.lastResidual();
+    result.pollSeconds = discipline_.pollSeconds();
+    return result;
+}
+
+void NtpWorker::RecordMetrics(const NtpSyncResult& result) {
+    if (result.canceled) {
+        metrics_->canceled.Add();
+        return;
+    }
+    metrics_->syncs.Add();
+    metrics_->replies.Add(result.replies.size());
+    for (const auto& reply : result.replies) {
+        if (reply.error == NtpError::None) {
+            metrics_->rtt.Record(reply.sample.delay / kTicksPerMicrosecond);
+        } else {
+            metrics_->replyErrors.Add();
+        }
+    }
+    if (!result.ok) {
+        metrics_->failures.Add();
+        return;
+    }
+    int64_t offset = result.selection.combined.offset;
+    metrics_->offset.Record((offset < 0 ? -offset : offset) / kTicksPerMicrosecond);
+    metrics_->lastOffset.Set(offset / kTicksPerMicrosecond);
+    metrics_->residual.Set(result.residual / kTicksPerMicrosecond);
+    metrics_->frequency.Set(result.clock.frequencyPpb);
+    metrics_->pollSeconds.Set(result.pollSeconds);
+    if (result.stepped) {
+        metrics_->steps.Add();
+    }
+}
+
+} // namespace clockcore
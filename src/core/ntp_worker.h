@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "clock_discipline.h"
+#include "clock_state.h"
+#include "dns_cache.h"
+#include "metrics.h"
+#include "ntp_client.h"
+#include "ntp_select.h"
+
+namespace clockcore {
+
+struct NtpSyncResult {
+    uint64_t requestId = 0;
+    uint64_t tag = 0;       // caller's value from RequestSync; 0 for scheduled polls
+    bool ok = false;        // a majority agreed and the clock was published
+    bool canceled = false;
+    std::vector<NtpServerReply> replies;
+    NtpSelection selection;
+    ClockSample clock;      // disciplined clock after this sync
+    bool stepped = false;
+    int64_t residual = 0;   // ticks the clock was corrected by
+    int pollSeconds = kMinPollSeconds; // until the next scheduled sync
+};
+
+// Called on the worker thread, without worker locks held. May call back into
+// the worker except for Shutdown.
+using NtpSyncCallback = std::function<void(const NtpSyncResult&)>;
+
+struct NtpWorkerOptions {
+    int timeoutMs = 2000;
+    std::string port = "123";
+    bool autoPoll = true; // sync again after the discipline's poll interval
+    // Shared address cache; the worker makes one over SystemResolver if unset.
+    std::shared_ptr<DnsCache> dns;
+    // Sync counters and RTT/offset histograms go here; DefaultMetrics() if unset.
+    MetricsRegistry* metrics = nullptr;
+    // If valid, published before the worker starts and used as the
+    // discipline's starting point (see clock_warm_start.h).
+    ClockSample initialClock;
+    // False if initialClock's frequency is only a placeholder.
+    bool initialFrequencyKnown = true;
+};
+
+// One long-lived thread that owns NTP traffic: syncs run one at a time from a
+// request queue, are selected and disciplined, and published to the clock.
+// Nothing here depends on a window, so the engine can run headless.
+class NtpWorker {
+public:
+    NtpWorker(PublishedClock& clock, NtpSyncCallback callback, NtpWorkerOptions options = NtpWorkerOptions());
+    ~NtpWorker();
+
+    NtpWorker(const NtpWorker&) = delete;
+    NtpWorker& operator=(const NtpWorker&) = delete;
+
+    // Servers used by syncs that start after the call.
+    void SetServers(std::vector<std::string> hosts);
+
+    // Queues a sync; returns its id, or 0 once shut down. A request with the
+    // same tag that is still queued is reused rather than duplicated.
+    uint64_t RequestSync(uint64_t tag = 0);
+
+    // Runs a scheduled sync after delaySeconds, replacing the current
+    // schedule; for deferring the first sync after a warm start.
+    void ScheduleSync(int delaySeconds);
+
+    // Cancels a queued or running sync; it still completes, with canceled set.
+    bool Cancel(uint64_t requestId);
+    void CancelAll();
+
+    // Cancels everything, reports queued requests as canceled and joins the
+    // thread. Idempotent; also run by the destructor.
+    void Shutdown();
+
+private:
+    struct Request {
+        uint64_t id;
+        uint64_t tag;
+        bool canceled;
+    };
+
+    struct Metrics;
+
+    void Run();
+    NtpSyncResult Sync(const Request& request, const std::vector<std::string>& hosts);
+    void RecordMetrics(const NtpSyncResult& result);
+
+    PublishedClock& clock_;
+    NtpSyncCallback callback_;
+    NtpWorkerOptions options_;
+    ClockDiscipline discipline_; // worker thread only
+    std::unique_ptr<Metrics> metrics_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Request> queue_;
+    std::vector<std::string> hosts_;
+    uint64_t nextId_ = 1;
+    uint64_t runningId_ = 0;
+    bool stopping_ = false;
+    bool pollScheduled_ = false;
+    std::chrono::steady_clock::time_point nextPoll_;
+    std::atomic<bool> cancelRunning_{false};
+    std::thread thread_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,276 @@
+#include "offset_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CLOCKCORE_X86_64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CLOCKCORE_TARGET_AVX2
+#else
+#define CLOCKCORE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace clockcore {
+
+namespace {
+
+// A bucket is two int64 values: the transition instant (INT64_MAX if none)
+// and the offsets in minutes before it (low half) and from it on (high half).
+struct KernelArgs {
+    const int64_t* buckets;
+    uint64_t lastBucket;
+    int64_t base;
+    int shift;
+    int32_t unitsPerMinute;
+};
+
+using Kernel = void (*)(const KernelArgs& args, const int64_t* in, int64_t* out, size_t count);
+
+// Differences wrap like the vector subtract does, so every kernel maps an
+// instant to the same bucket.
+inline const int64_t* FindBucket(const KernelArgs& args, int64_t t) {
+    int64_t diff = static_cast<int64_t>(static_cast<uint64_t>(t) - static_cast<uint64_t>(args.base));
+    uint64_t index = diff < 0 ? 0 : std::min(static_cast<uint64_t>(diff) >> args.shift, args.lastBucket);
+    return args.buckets + index * 2;
+}
+
+inline int64_t AddOffset(int64_t t, int32_t offsetMinutes, int32_t unitsPerMinute) {
+    return static_cast<int64_t>(static_cast<uint64_t>(t) + static_cast<uint64_t>(int64_t{offsetMinutes} * unitsPerMinute));
+}
+
+void ToLocalScalar(const KernelArgs& args, const int64_t* in, int64_t* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        int64_t t = in[i];
+        const int64_t* bucket = FindBucket(args, t);
+        uint64_t offsets = static_cast<uint64_t>(bucket[1]);
+        out[i] = AddOffset(t, static_cast<int32_t>(t < bucket[0] ? offsets : offsets >> 32), args.unitsPerMinute);
+    }
+}
+
+#ifdef CLOCKCORE_X86_64
+
+// SSE2 has neither 64-bit compares nor gathers: buckets are found per lane
+// and the signed compare is built from 32-bit halves.
+inline __m128i CompareGreater64(__m128i a, __m128i b) {
+    const __m128i kSign = _mm_set1_epi32(INT32_MIN);
+    __m128i greater = _mm_cmpgt_epi32(a, b);
+    __m128i equal = _mm_cmpeq_epi32(a, b);
+    __m128i lowGreater = _mm_cmpgt_epi32(_mm_xor_si128(a, kSign), _mm_xor_si128(b, kSign)); // unsigned
+    __m128i result = _mm_or_si128(greater, _mm_and_si128(equal, _mm_shuffle_epi32(lowGreater, _MM_SHUFFLE(2, 2, 0, 0))));
+    return _mm_shuffle_epi32(result, _MM_SHUFFLE(3, 3, 1, 1));
+}
+
+// Signed minutes (low half of each lane) times a positive factor. SSE2 only
+// multiplies unsigned, so products of negative offsets are corrected.
+inline __m128i MultiplyMinutes(__m128i minutes, __m128i factor) {
+    __m128i product = _mm_mul_epu32(minutes, factor);
+    __m128i negative = _mm_shuffle_epi32(_mm_srai_epi32(minutes, 31), _MM_SHUFFLE(2, 2, 0, 0));
+    return _mm_sub_epi64(product, _mm_slli_epi64(_mm_and_si128(negative, factor), 32));
+}
+
+void ToLocalSse2(const KernelArgs& args, const int64_t* in, int64_t* out, size_t count) {
+    const __m128i unitsPerMinute = _mm_set1_epi32(args.unitsPerMinute);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(FindBucket(args, in[i])));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(FindBucket(args, in[i + 1])));
+        __m128i at = _mm_unpacklo_epi64(b0, b1);
+        __m128i offsets = _mm_unpackhi_epi64(b0, b1);
+        __m128i early = CompareGreater64(at, t);
+        __m128i minutes = _mm_or_si128(_mm_and_si128(early, offsets), _mm_andnot_si128(early, _mm_srli_epi64(offsets, 32)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_add_epi64(t, MultiplyMinutes(minutes, unitsPerMinute)));
+    }
+    ToLocalScalar(args, in + i, out + i, count - i);
+}
+
+CLOCKCORE_TARGET_AVX2 void ToLocalAvx2(const KernelArgs& args, const int64_t* in, int64_t* out, size_t count) {
+    const __m256i base = _mm256_set1_epi64x(args.base);
+    const __m256i lastBucket = _mm256_set1_epi64x(static_cast<int64_t>(args.lastBucket));
+    const __m128i shift = _mm_cvtsi32_si128(args.shift);
+    const __m256i unitsPerMinute = _mm256_set1_epi32(args.unitsPerMinute);
+    const __m256i zero = _mm256_setzero_si256();
+    const long long* table = reinterpret_cast<const long long*>(args.buckets);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i diff = _mm256_sub_epi64(t, base);
+        __m256i index = _mm256_srl_epi64(diff, shift);
+        index = _mm256_andnot_si256(_mm256_cmpgt_epi64(zero, diff), index);
+        index = _mm256_blendv_epi8(index, lastBucket, _mm256_cmpgt_epi64(index, lastBucket));
+        __m256i slot = _mm256_slli_epi64(index, 1);
+        __m256i at = _mm256_i64gather_epi64(table, slot, 8);
+        __m256i offsets = _mm256_i64gather_epi64(table + 1, slot, 8);
+        __m256i minutes = _mm256_blendv_epi8(_mm256_srli_epi64(offsets, 32), offsets, _mm256_cmpgt_epi64(at, t));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_add_epi64(t, _mm256_mul_epi32(minutes, unitsPerMinute)));
+    }
+    ToLocalScalar(args, in + i, out + i, count - i);
+}
+
+bool CpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2"); // checks OS support for the YMM state too
+#endif
+}
+
+#endif // CLOCKCORE_X86_64
+
+Kernel KernelFor(OffsetKernel kernel) {
+#ifdef CLOCKCORE_X86_64
+    switch (kernel) {
+    case OffsetKernel::Avx2: return ToLocalAvx2;
+    case OffsetKernel::Sse2: return ToLocalSse2;
+    default: break;
+    }
+#else
+    (void)kernel;
+#endif
+    return ToLocalScalar;
+}
+
+} // namespace
+
+bool IsOffsetKernelSupported(OffsetKernel kernel) {
+#ifdef CLOCKCORE_X86_64
+    static const bool hasAvx2 = CpuHasAvx2();
+    return kernel != OffsetKernel::Avx2 || hasAvx2;
+#else
+    return kernel == OffsetKernel::Scalar;
+#endif
+}
+
+OffsetKernel BestOffsetKernel() {
+    static const OffsetKernel best = IsOffsetKernelSupported(OffsetKernel::Avx2)   ? OffsetKernel::Avx2
+                                     : IsOffsetKernelSupported(OffsetKernel::Sse2) ? OffsetKernel::Sse2
+                                                                                   : OffsetKernel::Scalar;
+    return best;
+}
+
+const char* OffsetKernelName(OffsetKernel kernel) {
+    switch (kernel) {
+    case OffsetKernel::Avx2: return "avx2";
+    case OffsetKernel::Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+bool OffsetTable::Build(CityInfo city, TimeUnit unit, int64_t from, int64_t until) {
+    buckets_.clear();
+    transitionCount_ = 0;
+    constexpr int64_t kFirstUnixSecond = -static_cast<int64_t>(kUnixEpochFileTime / kTicksPerSecond);
+    if (until <= from || from < (unit == TimeUnit::UnixSeconds ? kFirstUnixSecond : 0)) {
+        return false;
+    }
+    auto toFileTime = [&](int64_t t) {
+        return unit == TimeUnit::UnixSeconds ? FileTimeFromUnixSeconds(t) : static_cast<uint64_t>(t);
+    };
+    auto fromFileTime = [&](uint64_t fileTime) {
+        return unit == TimeUnit::UnixSeconds ? UnixSecondsFromFileTime(fileTime) : static_cast<int64_t>(fileTime);
+    };
+
+    // Walk the city's offset intervals across the range, keeping only the
+    // instants where the total offset actually changes.
+    struct Change {
+        int64_t at;
+        int offsetMinutes;
+    };
+    const uint64_t untilFileTime = toFileTime(until);
+    uint64_t t = toFileTime(from);
+    PrimeCityCache(city, t);
+    const int initialOffset = city.offsetCache.offsetMinutes;
+    int offset = initialOffset;
+    std::vector<Change> changes;
+    for (;;) {
+        uint64_t next = city.offsetCache.validUntil;
+        if (next <= t || next >= untilFileTime) {
+            break;
+        }
+        t = next;
+        PrimeCityCache(city, t);
+        if (city.offsetCache.offsetMinutes != offset) {
+            offset = city.offsetCache.offsetMinutes;
+            changes.push_back({fromFileTime(t), offset});
+        }
+    }
+
+    // Widest power-of-two bucket that still separates every pair of changes.
+    uint64_t minGap = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 1; i < changes.size(); ++i) {
+        minGap = std::min(minGap, static_cast<uint64_t>(changes[i].at - changes[i - 1].at));
+    }
+    int shift = 62;
+    while (shift > 0 && (uint64_t{1} << shift) > minGap) {
+        --shift;
+    }
+    uint64_t bucketCount = ((static_cast<uint64_t>(until) - static_cast<uint64_t>(from) - 1) >> shift) + 1;
+    if (bucketCount > kMaxBuckets) {
+        return false;
+    }
+
+    unit_ = unit;
+    base_ = from;
+    shift_ = shift;
+    transitionCount_ = changes.size();
+    buckets_.resize(bucketCount * 2);
+    size_t next = 0;
+    offset = initialOffset;
+    for (uint64_t b = 0; b < bucketCount; ++b) {
+        int64_t* bucket = &buckets_[b * 2];
+        int before = offset;
+        bucket[0] = std::numeric_limits<int64_t>::max();
+        if (next < changes.size() &&
+            (b + 1 == bucketCount || static_cast<uint64_t>(changes[next].at - from) < ((b + 1) << shift))) {
+            bucket[0] = changes[next].at;
+            offset = changes[next++].offsetMinutes;
+        }
+        bucket[1] = static_cast<int64_t>((static_cast<uint64_t>(static_cast<uint32_t>(offset)) << 32) | static_cast<uint32_t>(before));
+    }
+    return true;
+}
+
+void OffsetTable::ToLocal(const int64_t* utc, int64_t* local, size_t count, OffsetKernel kernel) const {
+    if (buckets_.empty()) {
+        std::memmove(local, utc, count * sizeof(int64_t));
+        return;
+    }
+    if (!IsOffsetKernelSupported(kernel)) {
+        kernel = OffsetKernel::Scalar;
+    }
+    KernelArgs args;
+    args.buckets = buckets_.data();
+    args.lastBucket = bucketCount() - 1;
+    args.base = base_;
+    args.shift = shift_;
+    args.unitsPerMinute = unit_ == TimeUnit::UnixSeconds ? 60 : static_cast<int32_t>(kTicksPerMinute);
+    KernelFor(kernel)(args, utc, local, count);
+}
+
+void OffsetTable::ToLocalFields(const int64_t* utc, CivilTime* fields, size_t count) const {
+    int64_t local[256];
+    for (size_t done = 0; done < count;) {
+        size_t n = std::min(count - done, sizeof(local) / sizeof(local[0]));
+        ToLocal(utc + done, local, n);
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t fileTime = unit_ == TimeUnit::UnixSeconds ? FileTimeFromUnixSeconds(local[i]) : static_cast<uint64_t>(local[i]);
+            fields[done + i] = CivilFromFileTime(fileTime);
+        }
+        done += n;
+    }
+}
+
+} // namespace clockcore
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "calendar.h"
+#include "city.h"
+
+// Bulk UTC-to-local conversion for one city. The city's offsets over a time
+// range are flattened into fixed-width buckets (a power of two of the time
+// unit, no wider than the shortest gap between two offset changes), so each
+// bucket holds at most one transition. Converting an instant is then a
+// subtract, a shift, one 16-byte bucket load and a compare, with no branches
+// or binary search; the AVX2 kernel does four instants per step with
+// gathers, SSE2 two, and all kernels agree bit for bit with
+// GetCityOffsetMinutes.
+
+namespace clockcore {
+
+enum class TimeUnit {
+    FileTime,   // 100-ns ticks since 1601 (uint64 values passed as int64)
+    UnixSeconds // seconds since 1970
+};
+
+enum class OffsetKernel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Best kernel the CPU and OS support (x86-64 only; Scalar elsewhere).
+// Detected once.
+OffsetKernel BestOffsetKernel();
+bool IsOffsetKernelSupported(OffsetKernel kernel);
+const char* OffsetKernelName(OffsetKernel kernel);
+
+class OffsetTable {
+public:
+    static constexpr size_t kMaxBuckets = size_t{1} << 16;
+
+    // Flattens the offsets the city has for instants in [from, until), in the
+    // given unit. False for an empty range, one before 1601, or transitions
+    // so close together that the table would need more than kMaxBuckets;
+    // narrow the range or fall back to GetCityOffsetMinutes.
+    bool Build(CityInfo city, TimeUnit unit, int64_t from, int64_t until);
+
+    // local[i] = utc[i] plus the city's offset at utc[i]; local may be utc.
+    // Instants outside the built range get the offset in effect at its
+    // nearer end.
+    void ToLocal(const int64_t* utc, int64_t* local, size_t count) const { ToLocal(utc, local, count, BestOffsetKernel()); }
+    void ToLocal(const int64_t* utc, int64_t* local, size_t count, OffsetKernel kernel) const;
+    void ToLocal(const uint64_t* utcFileTimes, uint64_t* localFileTimes, size_t count) const {
+        ToLocal(reinterpret_cast<const int64_t*>(utcFileTimes), reinterpret_cast<int64_t*>(localFileTimes), count);
+    }
+
+    // Broken-down local time (second resolution) for each instant.
+    void ToLocalFields(const int64_t* utc, CivilTime* fields, size_t count) const;
+
+    TimeUnit unit() const { return unit_; }
+    size_t bucketCount() const { return buckets_.size() / 2; }
+    size_t transitionCount() const { return transitionCount_; }
+    int shift() const { return shift_; }
+
+private:
+    TimeUnit unit_ = TimeUnit::FileTime;
+    int64_t base_ = 0;
+    int shift_ = 0;
+    size_t transitionCount_ = 0;
+    std::vector<int64_t> buckets_; // per bucket: transition instant, packed offset minutes (see the .cpp)
+};
+
+} // namespace clockcore
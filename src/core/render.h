@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Minimal drawing surface the clock view is painted through. GDI implements
+// it in the Win32 front end; SoftwareRenderer rasterizes into memory so a
+// frame can be timed, diffed and saved without a window.
+
+namespace clockcore {
+
+struct Rgba {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+    uint8_t a = 255;
+};
+
+inline bool operator==(const Rgba& lhs, const Rgba& rhs) {
+    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b && lhs.a == rhs.a;
+}
+
+struct TextSize {
+    int width = 0;
+    int height = 0;
+};
+
+// Pixels rasterized once by a backend and drawn many times. Only the
+// backend that created an image can draw it.
+class RenderImage {
+public:
+    virtual ~RenderImage() = default;
+    virtual TextSize size() const = 0;
+};
+
+class Renderer {
+public:
+    virtual ~Renderer() = default;
+
+    // Fills [left, right) x [top, bottom), clipped to the surface.
+    virtual void FillRectangle(int left, int top, int right, int bottom, Rgba color) = 0;
+    virtual TextSize MeasureString(const wchar_t* text, size_t length) = 0;
+    // Draws text with its cell's top-left corner at (x, y); no background.
+    virtual void DrawString(int x, int y, const wchar_t* text, size_t length, Rgba color) = 0;
+
+    // Rasterizes text over an opaque background into a new image.
+    virtual std::unique_ptr<RenderImage> RasterizeString(const wchar_t* text, size_t length, Rgba color, Rgba background) = 0;
+    // Copies columns [sourceX, sourceX + width) of an image, full height, to (x, y).
+    virtual void DrawImage(const RenderImage& image, int sourceX, int width, int x, int y) = 0;
+};
+
+} // namespace clockcore
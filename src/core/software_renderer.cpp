@@ -0,0 +1,200 @@
+#include "software_renderer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+namespace clockcore {
+
+// Glyph rows for ' ' through '~', top to bottom; bit 4 is the leftmost
+// column and the eighth row holds descenders. Each character occupies a
+// 6x9 cell: one blank column to its right and one blank row below.
+static constexpr int kGlyphColumns = 5;
+static constexpr int kGlyphRows = 8;
+static constexpr int kCellWidth = 6;
+static constexpr int kCellHeight = 9;
+static constexpr wchar_t kFirstGlyph = L' ';
+static constexpr wchar_t kLastGlyph = L'~';
+
+static const uint8_t kGlyphs[][kGlyphRows] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04, 0x00}, // '!'
+    {0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"'
+    {0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A, 0x00}, // '#'
+    {0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04, 0x00}, // '$'
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03, 0x00}, // '%'
+    {0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D, 0x00}, // '&'
+    {0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00}, // '\''
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02, 0x00}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08, 0x00}, // ')'
+    {0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00, 0x00}, // '*'
+    {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00, 0x00}, // '+'
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08, 0x00}, // ','
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00}, // '/'
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E, 0x00}, // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00}, // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F, 0x00}, // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E, 0x00}, // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02, 0x00}, // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E, 0x00}, // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E, 0x00}, // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x00}, // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E, 0x00}, // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C, 0x00}, // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00, 0x00}, // ':'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08, 0x00}, // ';'
+    {0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02, 0x00}, // '<'
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '='
+    {0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08, 0x00}, // '>'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04, 0x00}, // '?'
+    {0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E, 0x00}, // '@'
+    {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00}, // 'A'
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x00}, // 'B'
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E, 0x00}, // 'C'
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C, 0x00}, // 'D'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x00}, // 'E'
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10, 0x00}, // 'F'
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F, 0x00}, // 'G'
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00}, // 'H'
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00}, // 'I'
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C, 0x00}, // 'J'
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x00}, // 'K'
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00}, // 'L'
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11, 0x00}, // 'M'
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x00}, // 'N'
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00}, // 'O'
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10, 0x00}, // 'P'
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D, 0x00}, // 'Q'
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11, 0x00}, // 'R'
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E, 0x00}, // 'S'
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00}, // 'T'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00}, // 'U'
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00}, // 'V'
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A, 0x00}, // 'W'
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11, 0x00}, // 'X'
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x00}, // 'Y'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F, 0x00}, // 'Z'
+    {0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E, 0x00}, // '['
+    {0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00}, // '\\'
+    {0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E, 0x00}, // ']'
+    {0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00}, // '^'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x00}, // '_'
+    {0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00}, // '`'
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00}, // 'a'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E, 0x00}, // 'b'
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00}, // 'c'
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F, 0x00}, // 'd'
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00}, // 'e'
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08, 0x00}, // 'f'
+    {0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // 'g'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00}, // 'h'
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00}, // 'i'
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'j'
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12, 0x00}, // 'k'
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00}, // 'l'
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11, 0x00}, // 'm'
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00}, // 'n'
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}, // 'o'
+    {0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10}, // 'p'
+    {0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x01}, // 'q'
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00}, // 'r'
+    {0x00, 0x00, 0x0F, 0x10, 0x0E, 0x01, 0x1E, 0x00}, // 's'
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06, 0x00}, // 't'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00}, // 'u'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00}, // 'v'
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A, 0x00}, // 'w'
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00}, // 'x'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // 'y'
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}, // 'z'
+    {0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02, 0x00}, // '{'
+    {0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00}, // '|'
+    {0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08, 0x00}, // '}'
+    {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00}, // '~'
+};
+
+// Drawn for characters outside the table.
+static const uint8_t kMissingGlyph[kGlyphRows] = {0x1F, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1F, 0x00};
+
+namespace {
+
+class SoftwareImage : public RenderImage {
+public:
+    Framebuffer pixels;
+
+    TextSize size() const override { return {pixels.width, pixels.height}; }
+};
+
+} // namespace
+
+SoftwareRenderer::SoftwareRenderer(Framebuffer& target, int fontPixelHeight) : target_(target) {
+    SetFontPixelHeight(fontPixelHeight);
+}
+
+void SoftwareRenderer::SetFontPixelHeight(int fontPixelHeight) {
+    scale_ = std::max(1, fontPixelHeight / kGlyphRows);
+}
+
+void SoftwareRenderer::FillRectangle(int left, int top, int right, int bottom, Rgba color) {
+    left = std::max(left, 0);
+    top = std::max(top, 0);
+    right = std::min(right, target_.width);
+    bottom = std::min(bottom, target_.height);
+    for (int y = top; y < bottom; ++y) {
+        Rgba* row = &target_.At(0, y);
+        std::fill(row + left, row + std::max(left, right), color);
+    }
+}
+
+TextSize SoftwareRenderer::MeasureString(const wchar_t*, size_t length) {
+    TextSize size;
+    size.width = static_cast<int>(length) * kCellWidth * scale_;
+    size.height = kCellHeight * scale_;
+    return size;
+}
+
+void SoftwareRenderer::DrawString(int x, int y, const wchar_t* text, size_t length, Rgba color) {
+    for (size_t i = 0; i < length; ++i) {
+        DrawGlyph(x, y, text[i], color);
+        x += kCellWidth * scale_;
+    }
+}
+
+std::unique_ptr<RenderImage> SoftwareRenderer::RasterizeString(const wchar_t* text, size_t length, Rgba color, Rgba background) {
+    auto image = std::make_unique<SoftwareImage>();
+    TextSize extent = MeasureString(text, length);
+    image->pixels.Resize(extent.width, extent.height);
+    std::fill(image->pixels.pixels.begin(), image->pixels.pixels.end(), background);
+    SoftwareRenderer painter(image->pixels, scale_ * kGlyphRows);
+    painter.DrawString(0, 0, text, length, color);
+    return image;
+}
+
+void SoftwareRenderer::DrawImage(const RenderImage& image, int sourceX, int width, int x, int y) {
+    const Framebuffer& source = static_cast<const SoftwareImage&>(image).pixels;
+    // Clip the copied columns to both the image and the target.
+    int left = std::max({0, sourceX, sourceX - x});
+    int right = std::min({source.width, sourceX + width, sourceX + target_.width - x});
+    int top = std::max(0, -y);
+    int bottom = std::min(source.height, target_.height - y);
+    for (int row = top; row < bottom && left < right; ++row) {
+        const Rgba* from = &source.At(left, row);
+        std::copy(from, from + (right - left), &target_.At(x + left - sourceX, y + row));
+    }
+}
+
+void SoftwareRenderer::DrawGlyph(int x, int y, wchar_t ch, Rgba color) {
+    const uint8_t* rows = ch >= kFirstGlyph && ch <= kLastGlyph ? kGlyphs[ch - kFirstGlyph] : kMissingGlyph;
+    for (int row = 0; row < kGlyphRows; ++row) {
+        for (int column = 0; column < kGlyphColumns; ++column) {
+            if (rows[row] & (0x10 >> column)) {
+                int left = x + column * scale_;
+                int top = y + row * scale_;
+                FillRectangle(left, top, left + scale_, top + scale_, color);
+            }
+        }
+    }
+}
+
+} // namespace clockcore
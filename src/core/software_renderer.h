@@ -0,0 +1,32 @@
+#pragma once
+
+#include "framebuffer.h"
+#include "render.h"
+
+namespace clockcore {
+
+// Renderer that rasterizes into a Framebuffer with a built-in 5x8 bitmap
+// font (printable ASCII; anything else draws as a box), scaled by whole
+// pixels to approximate the requested font height. Output is deterministic,
+// so frames can be compared pixel for pixel across machines.
+class SoftwareRenderer : public Renderer {
+public:
+    SoftwareRenderer(Framebuffer& target, int fontPixelHeight);
+
+    void SetFontPixelHeight(int fontPixelHeight);
+    int fontScale() const { return scale_; }
+
+    void FillRectangle(int left, int top, int right, int bottom, Rgba color) override;
+    TextSize MeasureString(const wchar_t* text, size_t length) override;
+    void DrawString(int x, int y, const wchar_t* text, size_t length, Rgba color) override;
+    std::unique_ptr<RenderImage> RasterizeString(const wchar_t* text, size_t length, Rgba color, Rgba background) override;
+    void DrawImage(const RenderImage& image, int sourceX, int width, int x, int y) override;
+
+private:
+    void DrawGlyph(int x, int y, wchar_t ch, Rgba color);
+
+    Framebuffer& target_;
+    int scale_ = 1;
+};
+
+} // namespace clockcore
@@ -0,0 +1,250 @@
+#include "tick_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "calendar.h"
+#include "monotonic.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+namespace clockcore {
+
+// One-shot wakeups on the monotonic clock that another thread can interrupt.
+#if defined(__linux__)
+class TickScheduler::Waiter {
+public:
+    Waiter() : timer_(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)), wake_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+    ~Waiter() {
+        close(timer_);
+        close(wake_);
+    }
+
+    // True once MonotonicTicks() reaches deadline; false if interrupted.
+    bool WaitUntil(uint64_t deadline) {
+        // MonotonicTicks() may count CLOCK_MONOTONIC_RAW or the TSC, so the
+        // deadline is carried over to CLOCK_MONOTONIC as an interval; the
+        // two rates differ by ppm, nothing over one period.
+        uint64_t now = MonotonicTicks();
+        timespec base;
+        clock_gettime(CLOCK_MONOTONIC, &base);
+        uint64_t target = static_cast<uint64_t>(base.tv_sec) * kTicksPerSecond + static_cast<uint64_t>(base.tv_nsec) / 100 +
+                          (deadline > now ? deadline - now : 0);
+        itimerspec spec = {};
+        spec.it_value.tv_sec = static_cast<time_t>(target / kTicksPerSecond);
+        spec.it_value.tv_nsec = static_cast<long>(target % kTicksPerSecond * 100);
+        if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+            spec.it_value.tv_nsec = 1; // zero would disarm
+        }
+        timerfd_settime(timer_, TFD_TIMER_ABSTIME, &spec, nullptr);
+        pollfd fds[2] = {{timer_, POLLIN, 0}, {wake_, POLLIN, 0}};
+        for (;;) {
+            if (poll(fds, 2, -1) < 0) {
+                continue; // EINTR
+            }
+            uint64_t value = 0;
+            if (fds[1].revents & POLLIN) {
+                ssize_t drained = read(wake_, &value, sizeof(value));
+                (void)drained;
+                return false;
+            }
+            if (fds[0].revents & POLLIN) {
+                ssize_t expirations = read(timer_, &value, sizeof(value));
+                (void)expirations;
+                return true;
+            }
+        }
+    }
+
+    void Interrupt() {
+        uint64_t one = 1;
+        ssize_t written = write(wake_, &one, sizeof(one));
+        (void)written;
+    }
+
+private:
+    int timer_;
+    int wake_;
+};
+#elif defined(_WIN32)
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+class TickScheduler::Waiter {
+public:
+    Waiter() : wake_(CreateEventW(nullptr, FALSE, FALSE, nullptr)) {
+        // High-resolution timers (Windows 10 1803+) are not rounded to the
+        // system timer interrupt; older systems get a regular one.
+        timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (!timer_) {
+            timer_ = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        }
+    }
+    ~Waiter() {
+        CloseHandle(timer_);
+        CloseHandle(wake_);
+    }
+
+    bool WaitUntil(uint64_t deadline) {
+        uint64_t now = MonotonicTicks();
+        LARGE_INTEGER due;
+        due.QuadPart = -static_cast<LONGLONG>(deadline > now ? deadline - now : 1); // relative, 100-ns units
+        SetWaitableTimer(timer_, &due, 0, nullptr, nullptr, FALSE);
+        HANDLE handles[2] = {wake_, timer_};
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (result == WAIT_OBJECT_0) {
+            CancelWaitableTimer(timer_);
+            return false;
+        }
+        return true;
+    }
+
+    void Interrupt() { SetEvent(wake_); }
+
+private:
+    HANDLE timer_ = nullptr;
+    HANDLE wake_;
+};
+#else
+class TickScheduler::Waiter {
+public:
+    bool WaitUntil(uint64_t deadline) {
+        uint64_t now = MonotonicTicks();
+        auto until = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                            std::chrono::duration<int64_t, std::ratio<1, 10000000>>(deadline > now ? deadline - now : 0));
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool interrupted = wake_.wait_until(lock, until, [this] { return interrupted_; });
+        interrupted_ = false;
+        return !interrupted;
+    }
+
+    void Interrupt() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        interrupted_ = true;
+        wake_.notify_one();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool interrupted_ = false;
+};
+#endif
+
+static MetricsRegistry& Registry(const TickSchedulerOptions& options) {
+    return options.metrics ? *options.metrics : DefaultMetrics();
+}
+
+TickScheduler::TickScheduler(const PublishedClock* clock, TickCallback callback, TickSchedulerOptions options)
+    : clock_(clock),
+      callback_(std::move(callback)),
+      options_(options),
+      waiter_(std::make_unique<Waiter>()),
+      wakeLatency_(Registry(options).GetHistogram("clock_tick_wake_latency_us", "Time from a UTC tick boundary to the scheduler waking for it.")),
+      presentLatency_(Registry(options).GetHistogram("clock_tick_present_latency_us", "Time from a UTC tick boundary to the new time being shown.")) {
+    options_.periodTicks = std::max<int64_t>(options_.periodTicks, 10000); // 1 ms floor
+    paused_ = options_.startPaused;
+    thread_ = std::thread([this]() { Run(); });
+}
+
+TickScheduler::~TickScheduler() {
+    Shutdown();
+}
+
+void TickScheduler::SetPaused(bool paused) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (paused_ == paused) {
+            return;
+        }
+        paused_ = paused;
+    }
+    resumed_.notify_one();
+    waiter_->Interrupt();
+}
+
+bool TickScheduler::paused() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return paused_;
+}
+
+void TickScheduler::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    resumed_.notify_one();
+    waiter_->Interrupt();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint64_t TickScheduler::NowUtc() const {
+    uint64_t utc = 0;
+    if (clock_ && clock_->TryNow(MonotonicTicks(), utc)) {
+        return utc;
+    }
+    return SystemFileTime();
+}
+
+void TickScheduler::RecordPresent(uint64_t boundaryUtc, uint64_t presentUtc) {
+    presentLatency_.Record(static_cast<int64_t>(presentUtc - boundaryUtc) / kTicksPerMicrosecond);
+}
+
+void TickScheduler::Run() {
+    const uint64_t period = static_cast<uint64_t>(options_.periodTicks);
+    uint64_t sequence = 0;
+    uint64_t lastBoundary = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            resumed_.wait(lock, [this] { return stopping_ || !paused_; });
+            if (stopping_) {
+                return;
+            }
+        }
+
+        // Convert the next UTC boundary to a monotonic deadline; the
+        // clock's frequency correction is negligible over one period.
+        uint64_t mono = MonotonicTicks();
+        uint64_t utc = NowUtc();
+        uint64_t boundary = (utc / period + 1) * period;
+        if (!waiter_->WaitUntil(mono + (boundary - utc))) {
+            continue; // interrupted: paused, resumed or stopping
+        }
+        uint64_t wake = NowUtc();
+        if (wake < boundary) {
+            continue; // the clock was slewed or stepped back meanwhile; re-arm
+        }
+
+        // After a suspend or a forward step only the latest boundary is announced.
+        TickEvent tick;
+        tick.boundaryUtc = wake / period * period;
+        if (tick.boundaryUtc == lastBoundary) {
+            continue;
+        }
+        tick.wakeUtc = wake;
+        tick.sequence = ++sequence;
+        lastBoundary = tick.boundaryUtc;
+        wakeLatency_.Record(static_cast<int64_t>(wake - tick.boundaryUtc) / kTicksPerMicrosecond);
+        if (callback_) {
+            callback_(tick);
+        }
+    }
+}
+
+} // namespace clockcore
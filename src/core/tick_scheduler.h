@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "clock_state.h"
+#include "metrics.h"
+
+namespace clockcore {
+
+struct TickEvent {
+    uint64_t boundaryUtc = 0; // the period boundary this tick announces (FILETIME)
+    uint64_t wakeUtc = 0;     // clock reading when the scheduler woke
+    uint64_t sequence = 0;
+};
+
+// Called on the scheduler thread, without scheduler locks held. Must not
+// call Shutdown.
+using TickCallback = std::function<void(const TickEvent&)>;
+
+struct TickSchedulerOptions {
+    int64_t periodTicks = 10000000; // boundaries are multiples of this in UTC; one second by default
+    bool startPaused = false;
+    MetricsRegistry* metrics = nullptr; // latency histograms go here; DefaultMetrics() if unset
+};
+
+// Fires once per UTC period boundary (every whole second by default) read
+// from the NTP-corrected clock, or the system clock until it is synced.
+// Each tick arms a one-shot high-resolution wakeup for the next boundary
+// (timerfd on Linux, a high-resolution waitable timer on Windows), so ticks
+// neither drift nor depend on message-queue timers. While paused nothing is
+// armed and no callbacks run.
+class TickScheduler {
+public:
+    TickScheduler(const PublishedClock* clock, TickCallback callback, TickSchedulerOptions options = TickSchedulerOptions());
+    ~TickScheduler();
+
+    TickScheduler(const TickScheduler&) = delete;
+    TickScheduler& operator=(const TickScheduler&) = delete;
+
+    // Pausing takes effect before the next tick; resuming re-aligns to the
+    // boundary after the current time.
+    void SetPaused(bool paused);
+    bool paused() const;
+
+    // Joins the thread. Idempotent; also run by the destructor.
+    void Shutdown();
+
+    // Boundary to scheduler wakeup in microseconds, recorded for every tick
+    // as clock_tick_wake_latency_us.
+    const Histogram& wakeLatency() const { return wakeLatency_; }
+    // Boundary to the moment the new second was shown, as reported by the
+    // display through RecordPresent with the tick's boundaryUtc; exported as
+    // clock_tick_present_latency_us.
+    const Histogram& presentLatency() const { return presentLatency_; }
+    void RecordPresent(uint64_t boundaryUtc, uint64_t presentUtc);
+
+    // Current UTC from the published clock, else the system clock.
+    uint64_t NowUtc() const;
+
+private:
+    class Waiter;
+
+    void Run();
+
+    const PublishedClock* clock_;
+    TickCallback callback_;
+    TickSchedulerOptions options_;
+    std::unique_ptr<Waiter> waiter_;
+    Histogram& wakeLatency_;
+    Histogram& presentLatency_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable resumed_;
+    bool paused_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+} // namespace clockcore
@@ -0,0 +1,212 @@
+#include "timestamp_text.h"
+
+#include "calendar.h"
+
+namespace clockcore {
+
+static bool IsDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+// Reads exactly count digits at text[pos].
+static bool ReadDigits(const char* text, size_t length, size_t pos, int count, int& value) {
+    if (pos + static_cast<size_t>(count) > length) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        char ch = text[pos + static_cast<size_t>(i)];
+        if (!IsDigit(ch)) {
+            return false;
+        }
+        value = value * 10 + (ch - '0');
+    }
+    return true;
+}
+
+// Sub-second digits after a '.' or ','; returns ticks and digits consumed.
+static size_t ReadFraction(const char* text, size_t length, size_t pos, uint64_t& ticks, int& digits) {
+    ticks = 0;
+    digits = 0;
+    size_t end = pos;
+    uint64_t scale = kTicksPerSecond / 10;
+    while (end < length && IsDigit(text[end])) {
+        if (digits < 7) {
+            ticks += static_cast<uint64_t>(text[end] - '0') * scale;
+            scale /= 10;
+            ++digits;
+        }
+        ++end;
+    }
+    return end - pos;
+}
+
+static size_t ParseIso(const char* text, size_t length, ParsedTimestamp& out) {
+    int year, month, day, hour, minute, second = 0;
+    if (!ReadDigits(text, length, 0, 4, year) || length < 16 || text[4] != '-' || !ReadDigits(text, length, 5, 2, month) ||
+        text[7] != '-' || !ReadDigits(text, length, 8, 2, day) || (text[10] != 'T' && text[10] != 't' && text[10] != ' ') ||
+        !ReadDigits(text, length, 11, 2, hour) || text[13] != ':' || !ReadDigits(text, length, 14, 2, minute)) {
+        return 0;
+    }
+    size_t pos = 16;
+    if (pos < length && text[pos] == ':') {
+        if (!ReadDigits(text, length, pos + 1, 2, second)) {
+            return 0;
+        }
+        pos += 3;
+    }
+    if (year < 1601 || month < 1 || month > 12 || day < 1 || day > DaysInMonth(year, month) || hour > 23 || minute > 59 || second > 60) {
+        return 0;
+    }
+
+    uint64_t fraction = 0;
+    int fractionDigits = 0;
+    if (pos + 1 < length && (text[pos] == '.' || text[pos] == ',') && IsDigit(text[pos + 1])) {
+        pos += 1 + ReadFraction(text, length, pos + 1, fraction, fractionDigits);
+    }
+
+    int64_t zoneMinutes = 0;
+    if (pos < length && (text[pos] == 'Z' || text[pos] == 'z')) {
+        ++pos;
+    } else if (pos < length && (text[pos] == '+' || text[pos] == '-')) {
+        int zoneHours = 0;
+        int zoneMins = 0;
+        if (!ReadDigits(text, length, pos + 1, 2, zoneHours) || zoneHours > 23) {
+            return 0;
+        }
+        size_t zoneEnd = pos + 3;
+        if (zoneEnd < length && text[zoneEnd] == ':') {
+            if (!ReadDigits(text, length, zoneEnd + 1, 2, zoneMins)) {
+                return 0;
+            }
+            zoneEnd += 3;
+        } else if (ReadDigits(text, length, zoneEnd, 2, zoneMins)) {
+            zoneEnd += 2;
+        }
+        if (zoneMins > 59) {
+            return 0;
+        }
+        zoneMinutes = (text[pos] == '-' ? -1 : 1) * (zoneHours * 60 + zoneMins);
+        pos = zoneEnd;
+    }
+
+    int64_t days = DaysFromCivil(year, month, day) + kUnixEpochDaysFrom1601;
+    int64_t ticks = days * kTicksPerDay + (static_cast<int64_t>(hour) * 3600 + minute * 60 + second) * kTicksPerSecond -
+                    zoneMinutes * kTicksPerMinute;
+    if (ticks < 0) {
+        return 0;
+    }
+    out.utc = static_cast<uint64_t>(ticks) + fraction;
+    out.fractionDigits = fractionDigits;
+    return pos;
+}
+
+static size_t ParseEpoch(const char* text, size_t length, ParsedTimestamp& out) {
+    size_t digits = 0;
+    uint64_t value = 0;
+    while (digits < length && IsDigit(text[digits])) {
+        if (digits == 19) {
+            return 0; // too long to be a timestamp
+        }
+        value = value * 10 + static_cast<uint64_t>(text[digits] - '0');
+        ++digits;
+    }
+    if (digits == 0) {
+        return 0;
+    }
+
+    // Digit count picks the unit: up to 11 seconds, then ms, us and ns.
+    uint64_t ticks;
+    int fractionDigits;
+    if (digits <= 11) {
+        ticks = value * kTicksPerSecond;
+        fractionDigits = 0;
+    } else if (digits <= 14) {
+        ticks = value * 10000;
+        fractionDigits = 3;
+    } else if (digits <= 17) {
+        ticks = value * 10;
+        fractionDigits = 6;
+    } else {
+        ticks = value / 100;
+        fractionDigits = 7;
+    }
+    size_t pos = digits;
+    if (digits <= 11 && pos + 1 < length && text[pos] == '.' && IsDigit(text[pos + 1])) {
+        uint64_t fraction = 0;
+        pos += 1 + ReadFraction(text, length, pos + 1, fraction, fractionDigits);
+        ticks += fraction;
+    }
+    if (ticks > UINT64_MAX - kUnixEpochFileTime) {
+        return 0;
+    }
+    out.utc = kUnixEpochFileTime + ticks;
+    out.fractionDigits = fractionDigits;
+    return pos;
+}
+
+size_t ParseTimestamp(const char* text, size_t length, ParsedTimestamp& out) {
+    if (length >= 5 && IsDigit(text[0]) && text[4] == '-') {
+        return ParseIso(text, length, out);
+    }
+    return ParseEpoch(text, length, out);
+}
+
+static void Put2(char* out, int value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+size_t IsoFormatter::Format(char* out, uint64_t utc, int offsetMinutes, int fractionDigits) {
+    int64_t local = static_cast<int64_t>(utc) + static_cast<int64_t>(offsetMinutes) * kTicksPerMinute;
+    if (local < 0) {
+        return 0;
+    }
+    int64_t day = local / kTicksPerDay;
+    int64_t inDay = local % kTicksPerDay;
+    if (day != cachedDay_) {
+        int year, month, dayOfMonth;
+        CivilFromDays(day - kUnixEpochDaysFrom1601, year, month, dayOfMonth);
+        if (year > 9999) {
+            return 0;
+        }
+        Put2(date_, year / 100);
+        Put2(date_ + 2, year % 100);
+        date_[4] = '-';
+        Put2(date_ + 5, month);
+        date_[7] = '-';
+        Put2(date_ + 8, dayOfMonth);
+        cachedDay_ = day;
+    }
+
+    char* p = out;
+    for (char ch : date_) {
+        *p++ = ch;
+    }
+    int64_t seconds = inDay / kTicksPerSecond;
+    *p++ = 'T';
+    Put2(p, static_cast<int>(seconds / 3600));
+    p[2] = ':';
+    Put2(p + 3, static_cast<int>(seconds / 60 % 60));
+    p[5] = ':';
+    Put2(p + 6, static_cast<int>(seconds % 60));
+    p += 8;
+    if (fractionDigits > 0) {
+        int64_t fraction = inDay % kTicksPerSecond;
+        *p++ = '.';
+        int64_t scale = kTicksPerSecond / 10;
+        for (int i = 0; i < fractionDigits && i < 7; ++i) {
+            *p++ = static_cast<char>('0' + fraction / scale % 10);
+            scale /= 10;
+        }
+    }
+    int absOffset = offsetMinutes < 0 ? -offsetMinutes : offsetMinutes;
+    *p++ = offsetMinutes < 0 ? '-' : '+';
+    Put2(p, absOffset / 60 % 100);
+    p[2] = ':';
+    Put2(p + 3, absOffset % 60);
+    p += 5;
+    return static_cast<size_t>(p - out);
+}
+
+} // namespace clockcore
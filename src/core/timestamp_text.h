@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Text timestamps for bulk log conversion: parsing Unix epoch and ISO 8601
+// forms, and formatting ISO 8601 local times with their UTC offset. No
+// allocation, no locale, no exceptions.
+
+namespace clockcore {
+
+struct ParsedTimestamp {
+    uint64_t utc = 0;       // FILETIME ticks
+    int fractionDigits = 0; // sub-second digits present in the input, at most 7
+};
+
+// Parses a timestamp at the start of text and returns the number of
+// characters consumed, or 0 if there is none. Accepted forms:
+//   epoch   1700000000 / 1700000000.25 / 1700000000123 (digit count picks
+//           s, ms, us or ns)
+//   ISO     2024-03-10T02:30:00[.fff][Z|+hh:mm|+hhmm|-hh]  ('T' may be a
+//           space; no zone means UTC)
+size_t ParseTimestamp(const char* text, size_t length, ParsedTimestamp& out);
+
+constexpr size_t kMaxIsoTimestampLength = 33; // 2024-03-10T02:30:00.1234567+14:00
+
+// Formats utc shifted by offsetMinutes as "YYYY-MM-DDTHH:MM:SS[.f]+hh:mm".
+// Remembers the last calendar day, so runs of timestamps from the same day
+// skip the date arithmetic. One instance per thread.
+class IsoFormatter {
+public:
+    size_t Format(char* out, uint64_t utc, int offsetMinutes, int fractionDigits);
+
+private:
+    int64_t cachedDay_ = INT64_MIN;
+    char date_[10] = {};
+};
+
+} // namespace clockcore
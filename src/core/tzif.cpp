@@ -0,0 +1,426 @@
+#include "tzif.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "calendar.h"
+#include "dst.h"
+
+namespace clockcore {
+
+static constexpr int64_t kUnboundedPast = std::numeric_limits<int64_t>::min();
+static constexpr int64_t kUnboundedFuture = std::numeric_limits<int64_t>::max();
+static constexpr size_t kHeaderSize = 44;
+
+static uint32_t ReadBe32(const unsigned char* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+static uint64_t ReadBe64(const unsigned char* p) {
+    return (static_cast<uint64_t>(ReadBe32(p)) << 32) | ReadBe32(p + 4);
+}
+
+static int64_t FloorDiv(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+// ---- POSIX TZ footer -------------------------------------------------------
+
+static bool ParseTzName(const std::string& s, size_t& pos) {
+    size_t begin = pos;
+    if (pos < s.size() && s[pos] == '<') {
+        size_t close = s.find('>', pos);
+        if (close == std::string::npos) {
+            return false;
+        }
+        pos = close + 1;
+        return close - begin > 1;
+    }
+    while (pos < s.size() && ((s[pos] >= 'A' && s[pos] <= 'Z') || (s[pos] >= 'a' && s[pos] <= 'z'))) {
+        ++pos;
+    }
+    return pos - begin >= 3;
+}
+
+static bool ParseNumber(const std::string& s, size_t& pos, int maxValue, int& out) {
+    size_t begin = pos;
+    int value = 0;
+    while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+        value = value * 10 + (s[pos] - '0');
+        if (value > maxValue) {
+            return false;
+        }
+        ++pos;
+    }
+    out = value;
+    return pos > begin;
+}
+
+// [+-]hh[:mm[:ss]] in seconds; hours up to 167 per RFC 8536.
+static bool ParseTzTime(const std::string& s, size_t& pos, int32_t& out) {
+    int sign = 1;
+    if (pos < s.size() && (s[pos] == '+' || s[pos] == '-')) {
+        sign = s[pos] == '-' ? -1 : 1;
+        ++pos;
+    }
+    int hours = 0;
+    int minutes = 0;
+    int seconds = 0;
+    if (!ParseNumber(s, pos, 167, hours)) {
+        return false;
+    }
+    if (pos < s.size() && s[pos] == ':') {
+        ++pos;
+        if (!ParseNumber(s, pos, 59, minutes)) {
+            return false;
+        }
+        if (pos < s.size() && s[pos] == ':') {
+            ++pos;
+            if (!ParseNumber(s, pos, 59, seconds)) {
+                return false;
+            }
+        }
+    }
+    out = sign * (hours * 3600 + minutes * 60 + seconds);
+    return true;
+}
+
+static bool ParseTzDate(const std::string& s, size_t& pos, PosixTzRule::Date& date) {
+    date = {};
+    date.time = 2 * 3600;
+    if (pos < s.size() && s[pos] == 'M') {
+        ++pos;
+        date.kind = 'M';
+        if (!ParseNumber(s, pos, 12, date.month) || date.month < 1 || pos >= s.size() || s[pos++] != '.' ||
+            !ParseNumber(s, pos, 5, date.week) || date.week < 1 || pos >= s.size() || s[pos++] != '.' ||
+            !ParseNumber(s, pos, 6, date.weekday)) {
+            return false;
+        }
+    } else if (pos < s.size() && s[pos] == 'J') {
+        ++pos;
+        date.kind = 'J';
+        if (!ParseNumber(s, pos, 365, date.day) || date.day < 1) {
+            return false;
+        }
+    } else {
+        date.kind = 'N';
+        if (!ParseNumber(s, pos, 365, date.day)) {
+            return false;
+        }
+    }
+    if (pos < s.size() && s[pos] == '/') {
+        ++pos;
+        return ParseTzTime(s, pos, date.time);
+    }
+    return true;
+}
+
+std::optional<PosixTzRule> ParsePosixTz(const std::string& spec) {
+    PosixTzRule rule;
+    size_t pos = 0;
+    int32_t offset = 0;
+    if (!ParseTzName(spec, pos) || !ParseTzTime(spec, pos, offset)) {
+        return std::nullopt;
+    }
+    rule.stdOffset = -offset; // POSIX offsets count west of Greenwich
+    if (pos == spec.size()) {
+        return rule;
+    }
+
+    if (!ParseTzName(spec, pos)) {
+        return std::nullopt;
+    }
+    rule.hasDst = true;
+    rule.dstOffset = rule.stdOffset + 3600;
+    if (pos < spec.size() && spec[pos] != ',') {
+        if (!ParseTzTime(spec, pos, offset)) {
+            return std::nullopt;
+        }
+        rule.dstOffset = -offset;
+    }
+    if (pos == spec.size()) {
+        // No rule given: POSIX leaves it to the implementation; use the US rule like glibc.
+        rule.start = {'M', 3, 2, 0, 0, 2 * 3600};
+        rule.end = {'M', 11, 1, 0, 0, 2 * 3600};
+        return rule;
+    }
+    if (spec[pos++] != ',' || !ParseTzDate(spec, pos, rule.start) ||
+        pos >= spec.size() || spec[pos++] != ',' || !ParseTzDate(spec, pos, rule.end) ||
+        pos != spec.size()) {
+        return std::nullopt;
+    }
+    return rule;
+}
+
+// Local midnight of the rule date, in days since 1970-01-01.
+static int64_t ResolveTzDateDays(const PosixTzRule::Date& date, int year) {
+    int64_t jan1 = DaysFromCivil(year, 1, 1);
+    switch (date.kind) {
+    case 'J':
+        return jan1 + date.day - 1 + ((IsLeapYear(year) && date.day >= 60) ? 1 : 0);
+    case 'N':
+        return jan1 + date.day;
+    default: {
+        int day = ResolveWeekdayOfMonth(year, date.month, date.week == 5 ? -1 : date.week, date.weekday);
+        return DaysFromCivil(year, date.month, day);
+    }
+    }
+}
+
+ZoneOffset EvaluatePosixTz(const PosixTzRule& rule, int64_t unixSeconds) {
+    if (!rule.hasDst) {
+        return {rule.stdOffset, false, kUnboundedPast, kUnboundedFuture};
+    }
+
+    struct Edge {
+        int64_t at;
+        bool startsDst;
+    };
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    CivilFromDays(FloorDiv(unixSeconds, 86400), year, month, day);
+
+    Edge edges[6];
+    int count = 0;
+    for (int y = year - 1; y <= year + 1; ++y) {
+        // Start time is given in standard time, end time in daylight time.
+        edges[count++] = {ResolveTzDateDays(rule.start, y) * 86400 + rule.start.time - rule.stdOffset, true};
+        edges[count++] = {ResolveTzDateDays(rule.end, y) * 86400 + rule.end.time - rule.dstOffset, false};
+    }
+    std::sort(edges, edges + count, [](const Edge& a, const Edge& b) { return a.at < b.at; });
+
+    int last = -1;
+    while (last + 1 < count && edges[last + 1].at <= unixSeconds) {
+        ++last;
+    }
+    bool isDst = last >= 0 ? edges[last].startsDst : !edges[0].startsDst;
+    ZoneOffset result{};
+    result.isDst = isDst;
+    result.utcOffsetSeconds = isDst ? rule.dstOffset : rule.stdOffset;
+    result.validFrom = last >= 0 ? edges[last].at : kUnboundedPast;
+    result.validUntil = last + 1 < count ? edges[last + 1].at : kUnboundedFuture;
+    return result;
+}
+
+// ---- TZif ------------------------------------------------------------------
+
+std::shared_ptr<const TzZone> TzZone::Open(const std::filesystem::path& path) {
+    std::shared_ptr<TzZone> zone(new TzZone());
+    if (!zone->file_.Open(path) || !zone->Parse()) {
+        return nullptr;
+    }
+    return zone;
+}
+
+bool TzZone::Parse() {
+    const unsigned char* data = file_.data();
+    size_t size = file_.size();
+    size_t pos = 0;
+
+    auto readHeader = [&](size_t at, uint32_t counts[6]) {
+        if (size < at + kHeaderSize || data[at] != 'T' || data[at + 1] != 'Z' || data[at + 2] != 'i' || data[at + 3] != 'f') {
+            return false;
+        }
+        for (int i = 0; i < 6; ++i) {
+            counts[i] = ReadBe32(data + at + 20 + i * 4);
+        }
+        return true;
+    };
+    auto blockSize = [](const uint32_t counts[6], size_t timeSize) {
+        // isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt
+        return static_cast<size_t>(counts[3]) * (timeSize + 1) + static_cast<size_t>(counts[4]) * 6 + counts[5] +
+               static_cast<size_t>(counts[2]) * (timeSize + 4) + counts[1] + counts[0];
+    };
+
+    uint32_t counts[6] = {};
+    if (!readHeader(0, counts)) {
+        return false;
+    }
+    char version = static_cast<char>(data[4]);
+    timeSize_ = 4;
+    pos = kHeaderSize;
+    if (version >= '2') {
+        // Skip the legacy 32-bit block; the second header describes 64-bit data.
+        pos += blockSize(counts, 4);
+        if (!readHeader(pos, counts)) {
+            return false;
+        }
+        pos += kHeaderSize;
+        timeSize_ = 8;
+    }
+    if (counts[4] == 0 || size < pos + blockSize(counts, timeSize_)) {
+        return false;
+    }
+
+    timeCount_ = counts[3];
+    typeCount_ = counts[4];
+    times_ = data + pos;
+    typeIndices_ = times_ + timeCount_ * timeSize_;
+    types_ = typeIndices_ + timeCount_;
+    for (size_t i = 0; i < timeCount_; ++i) {
+        if (typeIndices_[i] >= typeCount_) {
+            return false;
+        }
+    }
+    pos += blockSize(counts, timeSize_);
+
+    if (timeSize_ == 8 && pos < size && data[pos] == '\n') {
+        const char* begin = reinterpret_cast<const char*>(data + pos + 1);
+        const char* end = reinterpret_cast<const char*>(data + size);
+        const char* newline = std::find(begin, end, '\n');
+        if (newline != end && newline != begin) {
+            footer_ = ParsePosixTz(std::string(begin, newline));
+        }
+    }
+    return true;
+}
+
+int64_t TzZone::TransitionAt(size_t index) const {
+    const unsigned char* p = times_ + index * timeSize_;
+    if (timeSize_ == 8) {
+        return static_cast<int64_t>(ReadBe64(p));
+    }
+    return static_cast<int32_t>(ReadBe32(p));
+}
+
+TzZone::TypeInfo TzZone::TypeAt(size_t typeIndex) const {
+    const unsigned char* p = types_ + typeIndex * 6;
+    return {static_cast<int32_t>(ReadBe32(p)), p[4] != 0};
+}
+
+TzZone::TypeInfo TzZone::TypeOfTransition(size_t index) const {
+    return TypeAt(typeIndices_[index]);
+}
+
+ZoneOffset TzZone::Lookup(int64_t unixSeconds) const {
+    if (timeCount_ == 0) {
+        if (footer_) {
+            return EvaluatePosixTz(*footer_, unixSeconds);
+        }
+        TypeInfo type = TypeAt(0);
+        return {type.utcOffsetSeconds, type.isDst, kUnboundedPast, kUnboundedFuture};
+    }
+    if (unixSeconds < TransitionAt(0)) {
+        TypeInfo type = TypeAt(0);
+        return {type.utcOffsetSeconds, type.isDst, kUnboundedPast, TransitionAt(0)};
+    }
+
+    // Largest index whose transition is at or before the instant.
+    size_t lo = 0;
+    size_t hi = timeCount_;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (TransitionAt(mid) <= unixSeconds) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    int64_t from = TransitionAt(lo);
+    if (lo + 1 < timeCount_) {
+        TypeInfo type = TypeOfTransition(lo);
+        return {type.utcOffsetSeconds, type.isDst, from, TransitionAt(lo + 1)};
+    }
+    if (footer_) {
+        ZoneOffset offset = EvaluatePosixTz(*footer_, unixSeconds);
+        offset.validFrom = std::max(offset.validFrom, from);
+        return offset;
+    }
+    TypeInfo type = TypeOfTransition(lo);
+    return {type.utcOffsetSeconds, type.isDst, from, kUnboundedFuture};
+}
+
+// ---- Zone registry ---------------------------------------------------------
+
+static std::mutex g_zoneMutex;
+static std::filesystem::path g_zoneDir;
+static std::unordered_map<std::string, std::shared_ptr<const TzZone>> g_zones;
+
+static std::filesystem::path DefaultZoneInfoDirectory() {
+    if (const char* env = std::getenv("TZDIR")) {
+        if (*env) {
+            return env;
+        }
+    }
+#ifdef _WIN32
+    return std::filesystem::path(L"zoneinfo");
+#else
+    return "/usr/share/zoneinfo";
+#endif
+}
+
+static bool IsValidZoneId(const std::string& zoneId) {
+    if (zoneId.empty() || zoneId.front() == '/' || zoneId.find("..") != std::string::npos) {
+        return false;
+    }
+    return std::all_of(zoneId.begin(), zoneId.end(), [](char ch) {
+        return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9') ||
+               ch == '/' || ch == '_' || ch == '-' || ch == '+';
+    });
+}
+
+std::filesystem::path ZoneInfoDirectory() {
+    std::lock_guard<std::mutex> lock(g_zoneMutex);
+    if (g_zoneDir.empty()) {
+        g_zoneDir = DefaultZoneInfoDirectory();
+    }
+    return g_zoneDir;
+}
+
+void SetZoneInfoDirectory(const std::filesystem::path& dir) {
+    std::lock_guard<std::mutex> lock(g_zoneMutex);
+    g_zoneDir = dir;
+    g_zones.clear();
+}
+
+std::shared_ptr<const TzZone> LoadTimeZone(const std::string& zoneId) {
+    if (!IsValidZoneId(zoneId)) {
+        return nullptr;
+    }
+    std::filesystem::path dir = ZoneInfoDirectory();
+    std::lock_guard<std::mutex> lock(g_zoneMutex);
+    auto it = g_zones.find(zoneId);
+    if (it != g_zones.end()) {
+        return it->second;
+    }
+    // Failed loads are cached too so a bad id is not retried every refresh.
+    auto zone = TzZone::Open(dir / zoneId);
+    g_zones.emplace(zoneId, zone);
+    return zone;
+}
+
+static bool IsZoneFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    return in.read(magic, 4) && std::memcmp(magic, "TZif", 4) == 0;
+}
+
+std::vector<std::string> ListZoneIds() {
+    std::vector<std::string> zones;
+    std::filesystem::path root = ZoneInfoDirectory();
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, ec); !ec && it != std::filesystem::recursive_directory_iterator();
+         it.increment(ec)) {
+        std::string relative = it->path().lexically_relative(root).generic_string();
+        if (it->is_directory() && (relative == "posix" || relative == "right")) {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (it->is_regular_file() && relative.find('.') == std::string::npos && IsZoneFile(it->path())) {
+            zones.push_back(relative);
+        }
+    }
+    std::sort(zones.begin(), zones.end());
+    return zones;
+}
+
+} // namespace clockcore
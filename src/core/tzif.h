@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+// IANA time zones read from TZif files (RFC 8536). The file stays memory
+// mapped; lookups binary-search the big-endian transition table in place and
+// fall back to the POSIX-TZ footer for instants past the last transition.
+
+namespace clockcore {
+
+// Offset in effect for a UTC instant, constant over [validFrom, validUntil)
+// (Unix seconds; INT64_MIN/INT64_MAX when unbounded).
+struct ZoneOffset {
+    int32_t utcOffsetSeconds;
+    bool isDst;
+    int64_t validFrom;
+    int64_t validUntil;
+};
+
+// Parsed POSIX TZ string, e.g. "EST5EDT,M3.2.0,M11.1.0".
+struct PosixTzRule {
+    struct Date {
+        char kind;       // 'J' (1-365, no leap day), 'N' (0-365), 'M' (month.week.weekday)
+        int month;
+        int week;        // 1-5; 5 = last
+        int weekday;     // 0=Sunday
+        int day;
+        int32_t time;    // seconds after local midnight; may be negative or exceed 24h
+    };
+    int32_t stdOffset = 0; // seconds east of UTC
+    int32_t dstOffset = 0;
+    bool hasDst = false;
+    Date start{};
+    Date end{};
+};
+
+std::optional<PosixTzRule> ParsePosixTz(const std::string& spec);
+ZoneOffset EvaluatePosixTz(const PosixTzRule& rule, int64_t unixSeconds);
+
+class TzZone {
+public:
+    static std::shared_ptr<const TzZone> Open(const std::filesystem::path& path);
+
+    ZoneOffset Lookup(int64_t unixSeconds) const;
+    size_t transitionCount() const { return timeCount_; }
+
+private:
+    struct TypeInfo {
+        int32_t utcOffsetSeconds;
+        bool isDst;
+    };
+
+    TzZone() = default;
+    bool Parse();
+    int64_t TransitionAt(size_t index) const;
+    TypeInfo TypeAt(size_t typeIndex) const;
+    TypeInfo TypeOfTransition(size_t index) const;
+
+    MappedFile file_;
+    const unsigned char* times_ = nullptr; // timeCount_ big-endian values of timeSize_ bytes
+    const unsigned char* typeIndices_ = nullptr;
+    const unsigned char* types_ = nullptr; // typeCount_ records of 6 bytes
+    size_t timeSize_ = 8;
+    size_t timeCount_ = 0;
+    size_t typeCount_ = 0;
+    std::optional<PosixTzRule> footer_;
+};
+
+// Zone files are looked up under $TZDIR, else /usr/share/zoneinfo (POSIX) or
+// a bundled "zoneinfo" directory next to the executable's working dir (Windows).
+std::filesystem::path ZoneInfoDirectory();
+void SetZoneInfoDirectory(const std::filesystem::path& dir);
+
+// Loads and caches a zone by IANA id ("Europe/Berlin"); null if unavailable.
+std::shared_ptr<const TzZone> LoadTimeZone(const std::string& zoneId);
+
+// Ids of every TZif file under ZoneInfoDirectory(), sorted, skipping the
+// posix/ and right/ mirrors (right/ counts leap seconds) and names with a dot.
+std::vector<std::string> ListZoneIds();
+
+} // namespace clockcore
@@ -11,26 +11,38 @@
 #include <windows.h>
 #include <shellapi.h>
 #include <algorithm>
+#include <atomic>
 #include <cwctype>
 #include <filesystem>
 #include <fstream>
-#include <iomanip>
-#include <mutex>
-#include <optional>
-#include <sstream>
+#include <memory>
 #include <string>
-#include <thread>
 #include <vector>
 
+#include "core/calendar.h"
+#include "core/city.h"
+#include "core/city_file.h"
+#include "core/config_watcher.h"
+#include "core/clock_state.h"
+#include "core/clock_view.h"
+#include "core/clock_warm_start.h"
+#include "core/frame_format.h"
+#include "core/gazetteer.h"
+#include "core/metrics.h"
+#include "core/monotonic.h"
+#include "core/ntp_worker.h"
+#include "core/tick_scheduler.h"
+
 #pragma comment(lib, "ws2_32.lib")
 
-struct CityInfo {
-    std::wstring name;
-    int offsetMinutes; // minutes offset from UTC
-};
+using clockcore::CityInfo;
+using clockcore::CivilTime;
 
-constexpr UINT_PTR kTimerId = 1;
 constexpr UINT WM_APP_NTP_COMPLETE = WM_APP + 1;
+constexpr UINT WM_APP_TICK = WM_APP + 2;
+constexpr UINT WM_APP_CONFIG_CHANGED = WM_APP + 3; // wParam: kConfig*Changed bits
+constexpr WPARAM kConfigCitiesChanged = 1;
+constexpr WPARAM kConfigNtpChanged = 2;
 constexpr wchar_t kWindowClassName[] = L"FloatingClockWindow";
 
 enum MenuId {
@@ -47,20 +59,30 @@ enum MenuId {
 
 static HFONT g_font = nullptr;
 static std::vector<CityInfo> g_cities;
-static std::wstring g_ntpServer = L"pool.ntp.org";
+static clockcore::FrameText g_frameText; // reused every paint
+static clockcore::ClockGlyphCache g_glyphCache; // digits and city labels for the current font
+static clockcore::ClockLineWidths g_lineWidths; // each city's widest line in the current font
+static clockcore::ClockLayout g_layout; // columns and pages that fit the monitor
+static size_t g_page = 0; // page of g_layout on screen
+constexpr uint64_t kPageSeconds = 10; // pages rotate on multiples of this many UTC seconds
+static std::vector<std::wstring> g_ntpServers = {L"pool.ntp.org"};
 static const std::filesystem::path kConfigDir = std::filesystem::path(L"config");
 static const std::filesystem::path kCitiesPath = kConfigDir / "cities.txt";
 static const std::filesystem::path kNtpPath = kConfigDir / "ntp.txt";
-constexpr int kInnerPadding = 12;
-constexpr int kFrameThickness = 4;
-constexpr COLORREF kFrameColor = RGB(170, 170, 170);
-
-static ULONGLONG g_ntpFileTime = 0;   // 100-ns intervals since 1601 UTC
-static ULONGLONG g_ntpTickAtFetch = 0;
-static bool g_hasNtpTime = false;
-static bool g_ntpInFlight = false;
-static std::mutex g_ntpMutex;
-static bool g_lastNtpSuccess = false;
+static const std::filesystem::path kMetricsPath = kConfigDir / "metrics.prom";
+static const std::filesystem::path kGazetteerPath = kConfigDir / "gazetteer.idx"; // from tools/gazetteer_build
+static const std::filesystem::path kClockStatePath = kConfigDir / "clock_state.txt"; // warm start, saved at each sync
+
+static clockcore::PublishedClock g_clock; // NTP time pinned to the monotonic clock; lock-free reads
+static std::unique_ptr<clockcore::NtpWorker> g_ntpWorker; // owns all NTP traffic and polling
+static std::unique_ptr<clockcore::TickScheduler> g_tickScheduler; // one wakeup per UTC second
+static std::atomic<uint64_t> g_pendingTickUtc{0}; // boundary of the tick not yet painted
+static std::unique_ptr<clockcore::ConfigWatcher> g_configWatcher; // reloads config files edited outside the app
+static std::unique_ptr<clockcore::MetricsExporter> g_metricsExporter; // rewrites kMetricsPath every few seconds
+static clockcore::Histogram& g_paintDuration =
+    clockcore::DefaultMetrics().GetHistogram("clock_paint_duration_us", "Time to lay out and draw one frame in WM_PAINT.");
+constexpr uint64_t kNtpTagSilent = 1;
+constexpr uint64_t kNtpTagShowResult = 2;
 
 static void DebugTrace(const std::wstring& msg) {
     OutputDebugStringW(msg.c_str());
@@ -76,6 +98,19 @@ static void DebugTraceLastError(const std::wstring& prefix) {
     DebugTrace(full);
 }
 
+static ULONGLONG CurrentUtcFileTime() {
+    uint64_t utc = 0;
+    if (g_clock.TryNow(clockcore::MonotonicTicks(), utc)) {
+        return utc;
+    }
+    FILETIME ft = {};
+    GetSystemTimeAsFileTime(&ft);
+    ULARGE_INTEGER uli;
+    uli.LowPart = ft.dwLowDateTime;
+    uli.HighPart = ft.dwHighDateTime;
+    return uli.QuadPart;
+}
+
 static void EnsureConfigDir() {
     std::error_code ec;
     std::filesystem::create_directories(kConfigDir, ec);
@@ -90,6 +125,15 @@ static std::wstring Trim(const std::wstring& input) {
     return input.substr(start, end - start + 1);
 }
 
+static std::string Trim(const std::string& input) {
+    size_t start = input.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = input.find_last_not_of(" \t\r\n");
+    return input.substr(start, end - start + 1);
+}
+
 static std::string ToUtf8(const std::wstring& wide) {
     if (wide.empty()) {
         return {};
@@ -100,149 +144,184 @@ static std::string ToUtf8(const std::wstring& wide) {
     return result;
 }
 
-static std::wstring ToLower(const std::wstring& input) {
-    std::wstring out = input;
-    std::transform(out.begin(), out.end(), out.begin(), [](wchar_t ch) { return static_cast<wchar_t>(towlower(ch)); });
-    return out;
-}
+// Cities added, edited or deleted in the window since the list was last
+// saved to or loaded from cities.txt.
+static bool g_citiesDirty = false;
 
-static void LoadDefaultCities() {
-    g_cities = {
-        {L"Auckland", 720},
-        {L"Shanghai", 480}
-    };
+// Brings g_cities in line with cities.txt. Only added or edited cities are
+// primed; the rest keep their zone and cached offsets. False if nothing changed.
+static bool LoadCitiesFromFile() {
+    EnsureConfigDir();
+    std::vector<CityInfo> loaded;
+    if (!clockcore::LoadCityFile(kCitiesPath, loaded) || loaded.empty()) {
+        loaded = clockcore::DefaultCities();
+    }
+    clockcore::CityListChanges changes = clockcore::ApplyCityList(g_cities, std::move(loaded), CurrentUtcFileTime());
+    g_citiesDirty = false;
+    DebugTrace(L"[config] cities: " + std::to_wstring(changes.added) + L" added, " + std::to_wstring(changes.changed) + L" changed, " +
+               std::to_wstring(changes.removed) + L" removed, " + std::to_wstring(changes.kept) + L" kept");
+    return changes.any();
 }
 
-static void LoadCitiesFromFile() {
+static void SaveCitiesToFile() {
     EnsureConfigDir();
-    g_cities.clear();
-    std::ifstream in(kCitiesPath);
-    if (!in.is_open()) {
-        LoadDefaultCities();
-        return;
+    if (clockcore::SaveCityFile(kCitiesPath, g_cities)) {
+        g_citiesDirty = false;
     }
+}
 
-    std::string line;
-    while (std::getline(in, line)) {
-        if (line.empty()) {
-            continue;
-        }
-        size_t pipePos = line.find('|');
-        if (pipePos == std::string::npos) {
-            continue;
-        }
-        std::wstring name;
-        name.assign(line.begin(), line.begin() + static_cast<long long>(pipePos));
-        name = Trim(name);
-        try {
-            int offset = std::stoi(line.substr(pipePos + 1));
-            if (!name.empty()) {
-                g_cities.push_back({name, offset});
-            }
-        } catch (...) {
-            // Skip invalid lines
-        }
+// True if cities.txt may replace g_cities: nothing is unsaved, or the user
+// agrees to drop it. A change that arrives while the question is open keeps
+// the edits; the file is read again once it changes after that.
+static bool ConfirmDiscardCityEdits(HWND hwnd) {
+    static bool asking = false;
+    if (!g_citiesDirty) {
+        return true;
     }
+    if (asking) {
+        return false;
+    }
+    asking = true;
+    int answer = MessageBoxW(hwnd,
+                             L"Cities added, edited or deleted here have not been saved to cities.txt.\n\n"
+                             L"Load the file and discard them? Choose No to keep them; Save cities to config writes them out.",
+                             L"Cities", MB_ICONWARNING | MB_YESNO);
+    asking = false;
+    return answer == IDYES;
+}
 
-    if (g_cities.empty()) {
-        LoadDefaultCities();
+// Servers may be separated by newlines, commas, semicolons or spaces.
+static std::vector<std::wstring> SplitServerList(const std::wstring& text) {
+    std::vector<std::wstring> servers;
+    std::wstring current;
+    for (wchar_t ch : text + L" ") {
+        if (ch == L',' || ch == L';' || iswspace(ch)) {
+            if (!current.empty()) {
+                servers.push_back(current);
+                current.clear();
+            }
+        } else {
+            current.push_back(ch);
+        }
     }
+    return servers;
 }
 
-static void SaveCitiesToFile() {
-    EnsureConfigDir();
-    std::ofstream out(kCitiesPath, std::ios::trunc);
-    for (const auto& city : g_cities) {
-        std::string name = ToUtf8(city.name);
-        out << name << "|" << city.offsetMinutes << "\n";
+static std::wstring JoinServerList(const std::vector<std::wstring>& servers) {
+    std::wstring text;
+    for (const auto& server : servers) {
+        if (!text.empty()) {
+            text += L", ";
+        }
+        text += server;
     }
+    return text;
 }
 
-static void LoadNtpServer() {
+static void LoadNtpServers() {
     EnsureConfigDir();
     std::wifstream in(kNtpPath);
     if (in.is_open()) {
+        std::vector<std::wstring> servers;
         std::wstring line;
-        if (std::getline(in, line)) {
-            line = Trim(line);
-            if (!line.empty()) {
-                g_ntpServer = line;
+        while (std::getline(in, line)) {
+            for (auto& server : SplitServerList(line)) {
+                servers.push_back(server);
             }
         }
+        if (!servers.empty()) {
+            g_ntpServers = servers;
+        }
     }
 }
 
-static void SaveNtpServer() {
+static void SaveNtpServers() {
     EnsureConfigDir();
     std::wofstream out(kNtpPath, std::ios::trunc);
-    out << g_ntpServer;
+    for (const auto& server : g_ntpServers) {
+        out << server << L"\n";
+    }
 }
 
-static std::optional<ULONGLONG> QueryNtpFileTime(const std::string& server) {
-    const uint32_t kNtpUnixDelta = 2208988800u;
-    const uint64_t kUnixToFiletime = 11644473600ull;
+// Cached text for GdiRenderer: a memory DC holding a compatible bitmap.
+class GdiImage : public clockcore::RenderImage {
+public:
+    GdiImage(HDC reference, int width, int height)
+        : dc_(CreateCompatibleDC(reference)), bitmap_(CreateCompatibleBitmap(reference, width, height)), size_{width, height} {
+        oldBitmap_ = SelectObject(dc_, bitmap_);
+    }
+    ~GdiImage() override {
+        SelectObject(dc_, oldBitmap_);
+        DeleteObject(bitmap_);
+        DeleteDC(dc_);
+    }
+    GdiImage(const GdiImage&) = delete;
+    GdiImage& operator=(const GdiImage&) = delete;
 
-    addrinfo hints = {};
-    hints.ai_socktype = SOCK_DGRAM;
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_protocol = IPPROTO_UDP;
+    clockcore::TextSize size() const override { return size_; }
+    HDC dc() const { return dc_; }
 
-    addrinfo* result = nullptr;
-    int err = getaddrinfo(server.c_str(), "123", &hints, &result);
-    if (err != 0 || !result) {
-        return std::nullopt;
-    }
+private:
+    HDC dc_;
+    HBITMAP bitmap_;
+    HGDIOBJ oldBitmap_ = nullptr;
+    clockcore::TextSize size_;
+};
 
-    SOCKET sock = INVALID_SOCKET;
-    for (addrinfo* ptr = result; ptr != nullptr; ptr = ptr->ai_next) {
-        sock = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
-        if (sock != INVALID_SOCKET) {
-            DWORD timeoutMs = 2000;
-            setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
-            setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
-            int sent;
-            unsigned char packet[48] = {0};
-            packet[0] = 0x1B; // LI=0, VN=3, Mode=3
-            sent = sendto(sock, reinterpret_cast<const char*>(packet), sizeof(packet), 0, ptr->ai_addr, static_cast<int>(ptr->ai_addrlen));
-            if (sent == sizeof(packet)) {
-                sockaddr_storage from = {};
-                int fromLen = sizeof(from);
-                int received = recvfrom(sock, reinterpret_cast<char*>(packet), sizeof(packet), 0, reinterpret_cast<sockaddr*>(&from), &fromLen);
-                if (received >= 48) {
-                    closesocket(sock);
-                    freeaddrinfo(result);
-                    uint32_t seconds = (packet[40] << 24) | (packet[41] << 16) | (packet[42] << 8) | packet[43];
-                    uint32_t fraction = (packet[44] << 24) | (packet[45] << 16) | (packet[46] << 8) | packet[47];
-                    if (seconds <= kNtpUnixDelta) {
-                        return std::nullopt;
-                    }
-                    uint64_t unixSeconds = seconds - kNtpUnixDelta;
-                    uint64_t filetime = (unixSeconds + kUnixToFiletime) * 10000000ull;
-                    filetime += (fraction * 10000000ull) >> 32;
-                    return filetime;
-                }
-            }
-            closesocket(sock);
-        }
+// Production backend for clockcore::DrawClockView: paints straight into the
+// window DC with the selected clock font.
+class GdiRenderer : public clockcore::Renderer {
+public:
+    GdiRenderer(HDC hdc, HFONT font) : hdc_(hdc), font_(font), oldFont_(static_cast<HFONT>(SelectObject(hdc, font))) {
+        SetBkMode(hdc_, TRANSPARENT);
     }
-    freeaddrinfo(result);
-    return std::nullopt;
-}
-
-static ULONGLONG CurrentUtcFileTime() {
-    std::lock_guard<std::mutex> lock(g_ntpMutex);
-    if (g_hasNtpTime) {
-        ULONGLONG elapsedMs = GetTickCount64() - g_ntpTickAtFetch;
-        return g_ntpFileTime + (elapsedMs * 10000ull);
+    ~GdiRenderer() override { SelectObject(hdc_, oldFont_); }
+    GdiRenderer(const GdiRenderer&) = delete;
+    GdiRenderer& operator=(const GdiRenderer&) = delete;
+
+    void FillRectangle(int left, int top, int right, int bottom, clockcore::Rgba color) override {
+        // The stock DC brush takes any color without creating a GDI object per fill.
+        RECT rect = {left, top, right, bottom};
+        SetDCBrushColor(hdc_, RGB(color.r, color.g, color.b));
+        FillRect(hdc_, &rect, static_cast<HBRUSH>(GetStockObject(DC_BRUSH)));
     }
-    FILETIME ft = {};
-    GetSystemTimeAsFileTime(&ft);
-    ULARGE_INTEGER uli;
-    uli.LowPart = ft.dwLowDateTime;
-    uli.HighPart = ft.dwHighDateTime;
-    return uli.QuadPart;
-}
+    clockcore::TextSize MeasureString(const wchar_t* text, size_t length) override {
+        SIZE sz = {};
+        GetTextExtentPoint32W(hdc_, text, static_cast<int>(length), &sz);
+        return {static_cast<int>(sz.cx), static_cast<int>(sz.cy)};
+    }
+    void DrawString(int x, int y, const wchar_t* text, size_t length, clockcore::Rgba color) override {
+        SetTextColor(hdc_, RGB(color.r, color.g, color.b));
+        TextOutW(hdc_, x, y, text, static_cast<int>(length));
+    }
+    std::unique_ptr<clockcore::RenderImage> RasterizeString(const wchar_t* text, size_t length, clockcore::Rgba color,
+                                                            clockcore::Rgba background) override {
+        clockcore::TextSize extent = MeasureString(text, length);
+        auto image = std::make_unique<GdiImage>(hdc_, std::max(extent.width, 1), std::max(extent.height, 1));
+        HDC dc = image->dc();
+        RECT rect = {0, 0, extent.width, extent.height};
+        SetDCBrushColor(dc, RGB(background.r, background.g, background.b));
+        FillRect(dc, &rect, static_cast<HBRUSH>(GetStockObject(DC_BRUSH)));
+        HGDIOBJ oldFont = SelectObject(dc, font_);
+        SetBkMode(dc, TRANSPARENT);
+        SetTextColor(dc, RGB(color.r, color.g, color.b));
+        TextOutW(dc, 0, 0, text, static_cast<int>(length));
+        SelectObject(dc, oldFont);
+        return image;
+    }
+    void DrawImage(const clockcore::RenderImage& image, int sourceX, int width, int x, int y) override {
+        const GdiImage& gdiImage = static_cast<const GdiImage&>(image);
+        BitBlt(hdc_, x, y, width, gdiImage.size().height, gdiImage.dc(), sourceX, 0, SRCCOPY);
+    }
+
+private:
+    HDC hdc_;
+    HFONT font_;
+    HFONT oldFont_;
+};
 
+// Recreates the clock font for the window's DPI and re-rasterizes the glyph
+// cache with it.
 static void UpdateFont(HWND hwnd) {
     if (g_font) {
         DeleteObject(g_font);
@@ -250,298 +329,273 @@ static void UpdateFont(HWND hwnd) {
     }
     HDC hdc = GetDC(hwnd);
     int dpi = GetDeviceCaps(hdc, LOGPIXELSY);
-    ReleaseDC(hwnd, hdc);
-    int height = -MulDiv(24, dpi, 72);
+    int height = -clockcore::ClockFontPixelHeight(dpi);
     g_font = CreateFontW(height, 0, 0, 0, FW_SEMIBOLD, FALSE, FALSE, FALSE, DEFAULT_CHARSET,
                         OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_SWISS, L"Segoe UI");
+    {
+        GdiRenderer renderer(hdc, g_font);
+        g_lineWidths.Clear();
+        g_glyphCache.Build(renderer, g_cities);
+    }
+    ReleaseDC(hwnd, hdc);
 }
 
+// Lays the cities out in as many columns as the monitor's work area holds,
+// paging the rest, and sizes the window to fit. Only names not seen before
+// are measured, and only the labels of the page on screen are rasterized.
 static void ResizeToContent(HWND hwnd) {
-    HDC hdc = GetDC(hwnd);
-    HFONT old = (HFONT)SelectObject(hdc, g_font);
-    SIZE sz = {0, 0};
-    SIZE lineSize = {0, 0};
-    for (const auto& city : g_cities) {
-        std::wostringstream oss;
-        oss << city.name << L": 00:00:00";
-        std::wstring sample = oss.str();
-        GetTextExtentPoint32W(hdc, sample.c_str(), static_cast<int>(sample.size()), &lineSize);
-        sz.cx = std::max(sz.cx, lineSize.cx);
-        sz.cy = lineSize.cy;
+    MONITORINFO monitor = {};
+    monitor.cbSize = sizeof(monitor);
+    clockcore::TextSize maxClient;
+    if (GetMonitorInfoW(MonitorFromWindow(hwnd, MONITOR_DEFAULTTONEAREST), &monitor)) {
+        maxClient.width = static_cast<int>(monitor.rcWork.right - monitor.rcWork.left);
+        maxClient.height = static_cast<int>(monitor.rcWork.bottom - monitor.rcWork.top);
     }
-    if (sz.cx == 0) {
-        GetTextExtentPoint32W(hdc, L"00:00:00", 8, &sz);
+
+    HDC hdc = GetDC(hwnd);
+    {
+        GdiRenderer renderer(hdc, g_font);
+        g_lineWidths.Update(renderer, g_cities);
+        g_layout = clockcore::LayoutClockView(g_lineWidths, g_cities.size(), maxClient);
+        g_page %= g_layout.pageCount;
+        g_glyphCache.UpdateLabels(renderer, g_cities); // every city change ends up here
+        g_glyphCache.SetVisibleRange(renderer, g_layout.PageStart(g_page), g_layout.pageSize);
     }
-    SelectObject(hdc, old);
     ReleaseDC(hwnd, hdc);
 
-    int padding = kInnerPadding + kFrameThickness;
-    int width = sz.cx + padding * 2;
-    int height = static_cast<int>(g_cities.size()) * sz.cy + padding * 2;
     RECT rc = {};
     GetWindowRect(hwnd, &rc);
-    SetWindowPos(hwnd, HWND_TOPMOST, rc.left, rc.top, width, height, SWP_NOMOVE | SWP_NOACTIVATE);
+    SetWindowPos(hwnd, HWND_TOPMOST, rc.left, rc.top, g_layout.client.width, g_layout.client.height, SWP_NOMOVE | SWP_NOACTIVATE);
 }
 
-static void StartNtpSyncAsync(HWND hwnd, bool showResult) {
-    std::lock_guard<std::mutex> lock(g_ntpMutex);
-    if (g_ntpInFlight) {
+static void ShowPage(HWND hwnd, size_t page) {
+    page %= g_layout.pageCount;
+    if (page == g_page) {
         return;
     }
-    g_ntpInFlight = true;
-    std::wstring server = g_ntpServer;
-    std::thread([hwnd, server, showResult]() {
-        auto utf8Server = ToUtf8(server);
-        auto result = QueryNtpFileTime(utf8Server);
-        {
-            std::lock_guard<std::mutex> guard(g_ntpMutex);
-            if (result) {
-                g_ntpFileTime = *result;
-                g_ntpTickAtFetch = GetTickCount64();
-                g_hasNtpTime = true;
-                g_lastNtpSuccess = true;
-            }
-            g_lastNtpSuccess = result.has_value();
-            g_ntpInFlight = false;
-        }
-        PostMessage(hwnd, WM_APP_NTP_COMPLETE, static_cast<WPARAM>(showResult ? 1 : 0), result ? 1 : 0);
-    }).detach();
+    g_page = page;
+    HDC hdc = GetDC(hwnd);
+    {
+        GdiRenderer renderer(hdc, g_font);
+        g_glyphCache.SetVisibleRange(renderer, g_layout.PageStart(g_page), g_layout.pageSize);
+    }
+    ReleaseDC(hwnd, hdc);
+    InvalidateRect(hwnd, nullptr, FALSE);
 }
 
-static int GetDstAdjustmentMinutes(const CityInfo& city, ULONGLONG utcFileTime);
-
-static std::wstring FormatCityTime(const CityInfo& city) {
-    ULONGLONG utcFileTime = CurrentUtcFileTime();
-    int dstAdjustMinutes = GetDstAdjustmentMinutes(city, utcFileTime);
-    LONGLONG adjusted = static_cast<LONGLONG>(utcFileTime) + static_cast<LONGLONG>(city.offsetMinutes + dstAdjustMinutes) * 60 * 10000000ll;
-    FILETIME ft = {};
-    ft.dwLowDateTime = static_cast<DWORD>(adjusted & 0xFFFFFFFF);
-    ft.dwHighDateTime = static_cast<DWORD>((adjusted >> 32) & 0xFFFFFFFF);
-    SYSTEMTIME st = {};
-    FileTimeToSystemTime(&ft, &st);
-    std::wostringstream oss;
-    oss << city.name << L": "
-        << std::setfill<wchar_t>(L'0') << std::setw(2) << st.wHour << L":"
-        << std::setw(2) << st.wMinute << L":"
-        << std::setw(2) << st.wSecond;
-    return oss.str();
+static std::vector<std::string> NtpServersUtf8() {
+    std::vector<std::string> servers;
+    for (const auto& server : g_ntpServers) {
+        servers.push_back(ToUtf8(server));
+    }
+    return servers;
 }
 
-// Simple modal dialog for city editing (name + offset)
-struct CityDialogState {
-    CityInfo initial;
-    CityInfo result;
-    bool confirmed = false;
-};
-
-static void WriteWord(std::vector<WORD>& buf, WORD v) { buf.push_back(v); }
-static void WriteDWord(std::vector<WORD>& buf, DWORD v) { buf.push_back(static_cast<WORD>(v & 0xFFFF)); buf.push_back(static_cast<WORD>((v >> 16) & 0xFFFF)); }
-static void AlignDword(std::vector<WORD>& buf) { if (buf.size() % 2 != 0) buf.push_back(0); }
-static void WriteString(std::vector<WORD>& buf, const wchar_t* s) { while (*s) { buf.push_back(static_cast<WORD>(*s++)); } buf.push_back(0); }
-
-static constexpr WORD kNameEditId = 2001;
-static constexpr WORD kOffsetEditId = 2002;
-static constexpr WORD kSearchButtonId = 2003;
-
-enum class DstScheme {
-    None,
-    NorthAmerica, // second Sun Mar 02:00 -> first Sun Nov 02:00 (US/Canada)
-    Europe,       // last Sun Mar 01:00 UTC -> last Sun Oct 01:00 UTC
-    Australia,    // first Sun Oct 02:00 -> first Sun Apr 03:00 (AU east)
-    NewZealand    // last Sun Sep 02:00 -> first Sun Apr 03:00 (NZ)
-};
-
-struct DstRule {
-    int startMonth;
-    int startWeek;     // 1-based; -1 = last
-    int startWeekday;  // 0=Sunday
-    int startHour;     // local (or UTC if timesAreUtc)
-    bool startInDst;   // offset includes DST at start boundary
-    int endMonth;
-    int endWeek;
-    int endWeekday;
-    int endHour;
-    bool endInDst;     // offset includes DST at end boundary
-    int adjustMinutes; // minutes to add when DST is active
-    bool timesAreUtc;  // transitions expressed in UTC (EU)
-};
-
-static const DstRule kDstNorthAmerica{3, 2, 0, 2, false, 11, 1, 0, 2, true, 60, false};
-static const DstRule kDstEurope{3, -1, 0, 1, false, 10, -1, 0, 1, false, 60, true};
-static const DstRule kDstAustralia{10, 1, 0, 2, false, 4, 1, 0, 3, true, 60, false};
-static const DstRule kDstNewZealand{9, -1, 0, 2, false, 4, 1, 0, 3, true, 60, false};
-
-static bool IsLeapYear(int year) {
-    return (year % 4 == 0) && ((year % 100 != 0) || (year % 400 == 0));
+// Runs on the NTP worker thread; only traces and notifies the window.
+static void OnNtpSyncComplete(HWND hwnd, const clockcore::NtpSyncResult& result) {
+    for (const auto& reply : result.replies) {
+        std::string reason = clockcore::NtpErrorName(reply.error);
+        DebugTrace(L"[NTP] " + std::wstring(reply.host.begin(), reply.host.end()) + L" " +
+                   std::wstring(reply.address.begin(), reply.address.end()) + L": " + std::wstring(reason.begin(), reason.end()));
+    }
+    if (result.ok) {
+        const clockcore::NtpSelection& selection = result.selection;
+        DebugTrace(L"[NTP] offset " + std::to_wstring(selection.combined.offset / 10000) + L" ms from " +
+                   std::to_wstring(selection.survivors) + L" of " + std::to_wstring(selection.candidates) + L" samples, " +
+                   (result.stepped ? L"stepped" : L"slewing " + std::to_wstring(result.residual / 10000) + L" ms") +
+                   L", drift " + std::to_wstring(result.clock.frequencyPpb) + L" ppb, next poll " + std::to_wstring(result.pollSeconds) + L" s");
+    } else if (result.canceled) {
+        DebugTrace(L"[NTP] sync canceled");
+    } else {
+        DebugTrace(L"[NTP] sync failed: no majority agreement among " + std::to_wstring(result.selection.candidates) + L" samples");
+    }
+    if (result.ok) {
+        EnsureConfigDir();
+        clockcore::SaveWarmStart(kClockStatePath, clockcore::CaptureWarmStart(result.clock, clockcore::NtpRootDistance(result.selection.combined),
+                                                                              result.pollSeconds, clockcore::MonotonicTicks(),
+                                                                              clockcore::SystemFileTime()));
+    }
+    if (!result.canceled) {
+        PostMessage(hwnd, WM_APP_NTP_COMPLETE, static_cast<WPARAM>(result.tag == kNtpTagShowResult ? 1 : 0), result.ok ? 1 : 0);
+    }
 }
 
-static int DaysInMonth(int year, int month) {
-    static const int kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-    if (month == 2 && IsLeapYear(year)) {
-        return 29;
+// Logs the monotonic source in use, then publishes the clock saved by the
+// last run, if still usable, so corrected time shows before the first reply;
+// a fresh one also defers that sync.
+static void StartNtpWorker(HWND hwnd) {
+    std::string sourceName = clockcore::MonotonicSourceName(clockcore::ActiveMonotonicSource());
+    DebugTrace(L"[clock] monotonic source " + std::wstring(sourceName.begin(), sourceName.end()));
+    clockcore::NtpWorkerOptions options;
+    int syncDelaySeconds = 0;
+    if (auto state = clockcore::LoadWarmStart(kClockStatePath)) {
+        if (auto estimate = clockcore::EstimateWarmStart(*state, clockcore::MonotonicTicks(), clockcore::SystemFileTime())) {
+            options.initialClock = estimate->clock;
+            options.initialFrequencyKnown = estimate->frequencyKnown;
+            syncDelaySeconds = estimate->syncDelaySeconds;
+            DebugTrace(L"[NTP] warm start from " + std::to_wstring(estimate->ageTicks / clockcore::kTicksPerSecond) + L" s ago: offset " +
+                       std::to_wstring(state->offsetTicks / 10000) + L" ms, +/- " + std::to_wstring(estimate->uncertaintyTicks / 10000) +
+                       L" ms, first sync in " + std::to_wstring(syncDelaySeconds) + L" s");
+        }
+    }
+    g_ntpWorker = std::make_unique<clockcore::NtpWorker>(
+        g_clock, [hwnd](const clockcore::NtpSyncResult& result) { OnNtpSyncComplete(hwnd, result); }, options);
+    g_ntpWorker->SetServers(NtpServersUtf8());
+    if (syncDelaySeconds > 0) {
+        g_ntpWorker->ScheduleSync(syncDelaySeconds);
+    } else {
+        g_ntpWorker->RequestSync(kNtpTagSilent);
     }
-    return kDays[month - 1];
 }
 
-static int ResolveWeekdayOfMonth(int year, int month, int week, int weekday) {
-    SYSTEMTIME firstDay = {};
-    firstDay.wYear = static_cast<WORD>(year);
-    firstDay.wMonth = static_cast<WORD>(month);
-    firstDay.wDay = 1;
-
-    FILETIME ft = {};
-    SystemTimeToFileTime(&firstDay, &ft);
-    FileTimeToSystemTime(&ft, &firstDay); // fills wDayOfWeek
-
-    int firstDow = static_cast<int>(firstDay.wDayOfWeek);
-    int daysInMonth = DaysInMonth(year, month);
+// Ticks arrive on the scheduler thread; the repaint happens on the UI thread.
+static void StartTickScheduler(HWND hwnd) {
+    g_tickScheduler = std::make_unique<clockcore::TickScheduler>(&g_clock, [hwnd](const clockcore::TickEvent& tick) {
+        g_pendingTickUtc.store(tick.boundaryUtc, std::memory_order_relaxed);
+        PostMessage(hwnd, WM_APP_TICK, 0, 0);
+    });
+}
 
-    if (week > 0) {
-        int day = 1 + ((weekday - firstDow + 7) % 7) + (week - 1) * 7;
-        return std::min(day, daysInMonth);
+static void StopTickScheduler() {
+    if (!g_tickScheduler) {
+        return;
     }
-
-    // last occurrence
-    int lastDow = (firstDow + daysInMonth - 1) % 7;
-    int day = daysInMonth - ((lastDow - weekday + 7) % 7);
-    return day;
+    g_tickScheduler->Shutdown();
+    const clockcore::Histogram& wake = g_tickScheduler->wakeLatency();
+    const clockcore::Histogram& paint = g_tickScheduler->presentLatency();
+    auto us = [](const clockcore::Histogram& latency, double q) { return std::to_wstring(latency.ValueAtQuantile(q)); };
+    DebugTrace(L"[tick] " + std::to_wstring(wake.count()) + L" ticks, boundary to wakeup us p50 " + us(wake, 0.5) + L" p99 " + us(wake, 0.99) +
+               L", boundary to paint us p50 " + us(paint, 0.5) + L" p99 " + us(paint, 0.99) + L" max " + std::to_wstring(paint.max()));
+    g_tickScheduler.reset();
 }
 
-static ULONGLONG LocalToUtcFileTime(const SYSTEMTIME& local, int offsetMinutes) {
-    FILETIME ftLocal = {};
-    SystemTimeToFileTime(&local, &ftLocal);
-    ULARGE_INTEGER ui = {};
-    ui.LowPart = ftLocal.dwLowDateTime;
-    ui.HighPart = ftLocal.dwHighDateTime;
-    LONGLONG ticks = static_cast<LONGLONG>(ui.QuadPart) - static_cast<LONGLONG>(offsetMinutes) * 60 * 10000000ll;
-    return static_cast<ULONGLONG>(ticks);
+static void StartMetricsExporter() {
+    EnsureConfigDir();
+    clockcore::MetricsExporterOptions options;
+    options.path = kMetricsPath;
+    g_metricsExporter = std::make_unique<clockcore::MetricsExporter>(clockcore::DefaultMetrics(), options);
 }
 
-static ULONGLONG BuildTransitionUtc(const DstRule& rule, bool isStart, int year, int baseOffsetMinutes) {
-    int month = isStart ? rule.startMonth : rule.endMonth;
-    int week = isStart ? rule.startWeek : rule.endWeek;
-    int weekday = isStart ? rule.startWeekday : rule.endWeekday;
-    int hour = isStart ? rule.startHour : rule.endHour;
-    bool inDst = isStart ? rule.startInDst : rule.endInDst;
-
-    int day = ResolveWeekdayOfMonth(year, month, week, weekday);
-
-    SYSTEMTIME local = {};
-    local.wYear = static_cast<WORD>(year);
-    local.wMonth = static_cast<WORD>(month);
-    local.wDay = static_cast<WORD>(day);
-    local.wHour = static_cast<WORD>(hour);
-
-    int offset = 0;
-    if (!rule.timesAreUtc) {
-        offset = baseOffsetMinutes + (inDst ? rule.adjustMinutes : 0);
-    }
-
-    return LocalToUtcFileTime(local, offset);
+// Every background thread records into DefaultMetrics(), a function-local
+// static that is destroyed before the unique_ptr globals above, so they are
+// all stopped here, the exporter last, rather than by static destructors.
+// Safe to call more than once.
+static void StopBackgroundThreads() {
+    g_configWatcher.reset();
+    StopTickScheduler();
+    g_ntpWorker.reset(); // cancels any sync in flight and joins the worker
+    g_metricsExporter.reset(); // writes the final numbers
 }
 
-static DstScheme GetDstScheme(const CityInfo& city) {
-    std::wstring lower = ToLower(city.name);
-    if (lower == L"new york" || lower == L"los angeles" || lower == L"chicago" ||
-        lower == L"san francisco" || lower == L"toronto" || lower == L"mexico city") {
-        return DstScheme::NorthAmerica;
-    }
-    if (lower == L"london" || lower == L"berlin" || lower == L"paris") {
-        return DstScheme::Europe;
+static void RequestNtpSync(bool showResult) {
+    if (g_ntpWorker) {
+        g_ntpWorker->RequestSync(showResult ? kNtpTagShowResult : kNtpTagSilent);
     }
-    if (lower == L"sydney") {
-        return DstScheme::Australia;
-    }
-    if (lower == L"auckland") {
-        return DstScheme::NewZealand;
-    }
-    return DstScheme::None;
 }
 
-static int GetDstAdjustmentMinutes(const CityInfo& city, ULONGLONG utcFileTime) {
-    DstScheme scheme = GetDstScheme(city);
-    if (scheme == DstScheme::None) {
-        return 0;
-    }
+// Changes arrive on the watcher thread, debounced; the reload happens on the UI thread.
+static void StartConfigWatcher(HWND hwnd) {
+    EnsureConfigDir();
+    const std::string citiesName = kCitiesPath.filename().string();
+    g_configWatcher = std::make_unique<clockcore::ConfigWatcher>(
+        kConfigDir, std::vector<std::string>{citiesName, kNtpPath.filename().string()},
+        [hwnd, citiesName](const std::vector<std::string>& files) {
+            WPARAM changed = 0;
+            for (const auto& file : files) {
+                changed |= file == citiesName ? kConfigCitiesChanged : kConfigNtpChanged;
+            }
+            PostMessage(hwnd, WM_APP_CONFIG_CHANGED, changed, 0);
+        });
+}
 
-    SYSTEMTIME utc = {};
-    FILETIME ft = {};
-    ft.dwLowDateTime = static_cast<DWORD>(utcFileTime & 0xFFFFFFFF);
-    ft.dwHighDateTime = static_cast<DWORD>((utcFileTime >> 32) & 0xFFFFFFFF);
-    FileTimeToSystemTime(&ft, &utc);
-
-    const DstRule* rule = nullptr;
-    switch (scheme) {
-    case DstScheme::NorthAmerica: rule = &kDstNorthAmerica; break;
-    case DstScheme::Europe: rule = &kDstEurope; break;
-    case DstScheme::Australia: rule = &kDstAustralia; break;
-    case DstScheme::NewZealand: rule = &kDstNewZealand; break;
-    default: break;
-    }
-    if (!rule) {
-        return 0;
+static void ReloadNtpServers() {
+    std::vector<std::wstring> previous = g_ntpServers;
+    LoadNtpServers();
+    if (g_ntpServers != previous && g_ntpWorker) {
+        g_ntpWorker->SetServers(NtpServersUtf8());
+        RequestNtpSync(false);
     }
+}
 
-    ULONGLONG startUtc = 0;
-    ULONGLONG endUtc = 0;
-    if (rule->startMonth > rule->endMonth) {
-        // Southern hemisphere style, spans year boundary.
-        int startYear = (utc.wMonth <= rule->endMonth) ? utc.wYear - 1 : utc.wYear;
-        startUtc = BuildTransitionUtc(*rule, true, startYear, city.offsetMinutes);
-        endUtc = BuildTransitionUtc(*rule, false, startYear + 1, city.offsetMinutes);
-    } else {
-        startUtc = BuildTransitionUtc(*rule, true, utc.wYear, city.offsetMinutes);
-        endUtc = BuildTransitionUtc(*rule, false, utc.wYear, city.offsetMinutes);
-    }
+// Simple modal dialog for city editing (name + offset)
+struct CityDialogState {
+    CityInfo initial;
+    CityInfo result;
+    bool confirmed = false;
+};
 
-    if (startUtc == 0 || endUtc == 0) {
-        return 0;
-    }
+static void WriteWord(std::vector<WORD>& buf, WORD v) { buf.push_back(v); }
+static void WriteDWord(std::vector<WORD>& buf, DWORD v) { buf.push_back(static_cast<WORD>(v & 0xFFFF)); buf.push_back(static_cast<WORD>((v >> 16) & 0xFFFF)); }
+static void AlignDword(std::vector<WORD>& buf) { if (buf.size() % 2 != 0) buf.push_back(0); }
+static void WriteString(std::vector<WORD>& buf, const wchar_t* s) { while (*s) { buf.push_back(static_cast<WORD>(*s++)); } buf.push_back(0); }
 
-    bool active = false;
-    if (startUtc < endUtc) {
-        active = utcFileTime >= startUtc && utcFileTime < endUtc;
-    } else {
-        active = utcFileTime >= startUtc || utcFileTime < endUtc;
-    }
-    return active ? rule->adjustMinutes : 0;
-}
+static constexpr WORD kNameEditId = 2001;
+static constexpr WORD kOffsetEditId = 2002;
+static constexpr WORD kSearchButtonId = 2003;
+static constexpr WORD kZoneEditId = 2004;
+static constexpr UINT kSetCityNameMessage = WM_APP + 4; // wParam: gazetteer entry picked from the list
+static constexpr size_t kMaxCitySuggestions = 8;
 
 struct CitySuggestion {
     const wchar_t* city;
     const wchar_t* country;
     int offsetMinutes;
+    const wchar_t* zoneId;
 };
 
 static const CitySuggestion kCitySuggestions[] = {
-    {L"UTC", L"", 0},
-    {L"New York", L"USA", -300},
-    {L"Los Angeles", L"USA", -480},
-    {L"London", L"UK", 0},
-    {L"Berlin", L"Germany", 60},
-    {L"Tokyo", L"Japan", 540},
-    {L"Sydney", L"Australia", 600},
-    {L"Auckland", L"New Zealand", 720},
-    {L"Singapore", L"Singapore", 480},
-    {L"Hong Kong", L"China", 480},
-    {L"Shanghai", L"China", 480},
-    {L"Dubai", L"UAE", 240},
-    {L"Chicago", L"USA", -360},
-    {L"Mexico City", L"Mexico", -360},
-    {L"Mumbai", L"India", 330},
-    {L"Johannesburg", L"South Africa", 120},
-    {L"Paris", L"France", 60},
-    {L"Toronto", L"Canada", -300},
-    {L"San Francisco", L"USA", -480},
-    {L"Beijing", L"China", 480},
-    {L"Seoul", L"South Korea", 540}
+    {L"UTC", L"", 0, L"Etc/UTC"},
+    {L"New York", L"USA", -300, L"America/New_York"},
+    {L"Los Angeles", L"USA", -480, L"America/Los_Angeles"},
+    {L"London", L"UK", 0, L"Europe/London"},
+    {L"Berlin", L"Germany", 60, L"Europe/Berlin"},
+    {L"Tokyo", L"Japan", 540, L"Asia/Tokyo"},
+    {L"Sydney", L"Australia", 600, L"Australia/Sydney"},
+    {L"Auckland", L"New Zealand", 720, L"Pacific/Auckland"},
+    {L"Singapore", L"Singapore", 480, L"Asia/Singapore"},
+    {L"Hong Kong", L"China", 480, L"Asia/Hong_Kong"},
+    {L"Shanghai", L"China", 480, L"Asia/Shanghai"},
+    {L"Dubai", L"UAE", 240, L"Asia/Dubai"},
+    {L"Chicago", L"USA", -360, L"America/Chicago"},
+    {L"Mexico City", L"Mexico", -360, L"America/Mexico_City"},
+    {L"Mumbai", L"India", 330, L"Asia/Kolkata"},
+    {L"Johannesburg", L"South Africa", 120, L"Africa/Johannesburg"},
+    {L"Paris", L"France", 60, L"Europe/Paris"},
+    {L"Toronto", L"Canada", -300, L"America/Toronto"},
+    {L"San Francisco", L"USA", -480, L"America/Los_Angeles"},
+    {L"Beijing", L"China", 480, L"Asia/Shanghai"},
+    {L"Seoul", L"South Korea", 540, L"Asia/Seoul"}
 };
 
+// Index behind the city name box: config/gazetteer.idx when present, else the
+// built-in suggestions above, ranked in the order they are listed.
+static const clockcore::Gazetteer& CityGazetteer() {
+    static clockcore::Gazetteer gazetteer;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true;
+        if (!gazetteer.Open(kGazetteerPath)) {
+            std::vector<clockcore::GazetteerRecord> records;
+            for (const auto& suggestion : kCitySuggestions) {
+                clockcore::GazetteerRecord record;
+                record.name = ToUtf8(suggestion.city);
+                record.country = ToUtf8(suggestion.country);
+                record.zoneId = ToUtf8(suggestion.zoneId);
+                record.offsetMinutes = suggestion.offsetMinutes;
+                record.population = static_cast<uint32_t>(std::size(kCitySuggestions) - records.size());
+                records.push_back(std::move(record));
+            }
+            gazetteer.Load(clockcore::BuildGazetteerIndex(records));
+        }
+    }
+    return gazetteer;
+}
+
 static std::vector<WORD> BuildCityDialogTemplate() {
     std::vector<WORD> dlg;
     WriteDWord(dlg, WS_POPUP | WS_CAPTION | WS_SYSMENU | DS_SETFONT | DS_MODALFRAME);
     WriteDWord(dlg, 0);
-    WriteWord(dlg, 7);
+    WriteWord(dlg, 9);
     WriteWord(dlg, 0); WriteWord(dlg, 0);
     WriteWord(dlg, 280); WriteWord(dlg, 170);
     WriteWord(dlg, 0);
@@ -566,15 +620,59 @@ static std::vector<WORD> BuildCityDialogTemplate() {
     };
 
     addItem(WS_CHILD | WS_VISIBLE, 0, 8, 8, 80, 12, 1001, 0x0082, L"City name:");
-    addItem(WS_CHILD | WS_VISIBLE | WS_BORDER | WS_VSCROLL | CBS_DROPDOWN | CBS_AUTOHSCROLL, WS_EX_CLIENTEDGE, 8, 22, 180, 90, kNameEditId, 0x0085, L"");
+    addItem(WS_CHILD | WS_VISIBLE | WS_BORDER | WS_VSCROLL | CBS_DROPDOWN | CBS_AUTOHSCROLL, WS_EX_CLIENTEDGE, 8, 22, 180, 110, kNameEditId, 0x0085, L"");
     addItem(WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON, 0, 196, 22, 60, 14, kSearchButtonId, 0x0080, L"Search");
     addItem(WS_CHILD | WS_VISIBLE, 0, 8, 62, 220, 12, 1002, 0x0082, L"UTC offset (minutes, e.g. -300):");
     addItem(WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL, WS_EX_CLIENTEDGE, 8, 76, 120, 14, kOffsetEditId, 0x0081, L"");
-    addItem(WS_CHILD | WS_VISIBLE | BS_DEFPUSHBUTTON, 0, 60, 120, 60, 14, IDOK, 0x0080, L"OK");
-    addItem(WS_CHILD | WS_VISIBLE, 0, 170, 120, 60, 14, IDCANCEL, 0x0080, L"Cancel");
+    addItem(WS_CHILD | WS_VISIBLE, 0, 8, 98, 260, 12, 1003, 0x0082, L"IANA time zone (optional, e.g. Europe/Berlin):");
+    addItem(WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL, WS_EX_CLIENTEDGE, 8, 112, 180, 14, kZoneEditId, 0x0081, L"");
+    addItem(WS_CHILD | WS_VISIBLE | BS_DEFPUSHBUTTON, 0, 60, 140, 60, 14, IDOK, 0x0080, L"OK");
+    addItem(WS_CHILD | WS_VISIBLE, 0, 170, 140, 60, 14, IDCANCEL, 0x0080, L"Cancel");
     return dlg;
 }
 
+static bool g_updatingCityList = false; // our own edits to the name box are not typing
+
+static void FillCityFields(HWND hwnd, uint32_t entryIndex) {
+    clockcore::GazetteerEntry entry = CityGazetteer().entry(entryIndex);
+    SetDlgItemTextW(hwnd, kOffsetEditId, std::to_wstring(entry.offsetMinutes).c_str());
+    SetDlgItemTextW(hwnd, kZoneEditId, clockcore::WideFromUtf8(entry.zoneId).c_str());
+}
+
+static void SetCityNameText(HWND combo, const std::wstring& text, DWORD selection) {
+    g_updatingCityList = true;
+    SetWindowTextW(combo, text.c_str());
+    SendMessageW(combo, CB_SETEDITSEL, 0, static_cast<LPARAM>(selection));
+    g_updatingCityList = false;
+}
+
+// Refills the drop-down with the best matches for what is typed, keeping the
+// typed text and caret (CB_RESETCONTENT clears the edit).
+static std::vector<clockcore::GazetteerMatch> UpdateCitySuggestions(HWND combo, const std::wstring& typed) {
+    const clockcore::Gazetteer& gazetteer = CityGazetteer();
+    auto matches = gazetteer.Search(ToUtf8(typed), kMaxCitySuggestions);
+    DWORD selection = static_cast<DWORD>(SendMessageW(combo, CB_GETEDITSEL, 0, 0));
+    g_updatingCityList = true;
+    SendMessageW(combo, CB_RESETCONTENT, 0, 0);
+    for (const auto& match : matches) {
+        clockcore::GazetteerEntry entry = gazetteer.entry(match.entry);
+        std::wstring item = clockcore::WideFromUtf8(entry.name) + L" (";
+        if (*entry.country) {
+            item += clockcore::WideFromUtf8(entry.country) + L", ";
+        }
+        item += clockcore::WideFromUtf8(entry.zoneId) + L")";
+        LRESULT index = SendMessageW(combo, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(item.c_str()));
+        if (index >= 0) {
+            SendMessageW(combo, CB_SETITEMDATA, static_cast<WPARAM>(index), static_cast<LPARAM>(match.entry));
+        }
+    }
+    SendMessageW(combo, CB_SHOWDROPDOWN, matches.empty() ? FALSE : TRUE, 0);
+    g_updatingCityList = false;
+    SetCityNameText(combo, typed, selection);
+    SetCursor(LoadCursor(nullptr, IDC_ARROW)); // opening the list hides the pointer
+    return matches;
+}
+
 static INT_PTR CALLBACK CityDialogProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     CityDialogState* state = reinterpret_cast<CityDialogState*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
     switch (msg) {
@@ -584,88 +682,78 @@ static INT_PTR CALLBACK CityDialogProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
         HWND nameEdit = GetDlgItem(hwnd, kNameEditId);
         HWND offsetEdit = GetDlgItem(hwnd, kOffsetEditId);
 
-        // Populate suggestions
-        for (const auto& entry : kCitySuggestions) {
-            SendMessageW(nameEdit, CB_ADDSTRING, 0, reinterpret_cast<LPARAM>(entry.city));
-        }
-        // Preselect if match
-        LRESULT idx = SendMessageW(nameEdit, CB_FINDSTRINGEXACT, static_cast<WPARAM>(-1), reinterpret_cast<LPARAM>(state->initial.name.c_str()));
-        if (idx != CB_ERR) {
-            SendMessageW(nameEdit, CB_SETCURSEL, static_cast<WPARAM>(idx), 0);
-        } else {
-            SetWindowTextW(nameEdit, state->initial.name.c_str());
-        }
+        // The list is filled from the gazetteer as the user types
+        SetWindowTextW(nameEdit, state->initial.name.c_str());
 
         if (nameEdit) {
             SendMessage(nameEdit, EM_SETSEL, 0, -1);
         }
         if (offsetEdit) {
-            std::wstringstream ss;
-            ss << state->initial.offsetMinutes;
-            auto txt = ss.str();
-            SetWindowTextW(offsetEdit, txt.c_str());
+            SetWindowTextW(offsetEdit, std::to_wstring(state->initial.offsetMinutes).c_str());
         }
+        std::wstring zoneText(state->initial.zoneId.begin(), state->initial.zoneId.end());
+        SetDlgItemTextW(hwnd, kZoneEditId, zoneText.c_str());
         if (nameEdit) {
             SetFocus(nameEdit);
             return FALSE;
         }
         return TRUE;
     }
+    case kSetCityNameMessage: {
+        HWND combo = GetDlgItem(hwnd, kNameEditId);
+        std::wstring name = clockcore::WideFromUtf8(CityGazetteer().entry(static_cast<uint32_t>(wParam)).name);
+        SetCityNameText(combo, name, MAKELONG(name.size(), name.size()));
+        return TRUE;
+    }
     case WM_COMMAND: {
         WORD id = LOWORD(wParam);
         WORD notif = HIWORD(wParam);
 
-        auto lookupAndFill = [&](const std::wstring& name) {
-            for (const auto& entry : kCitySuggestions) {
-                if (_wcsicmp(entry.city, name.c_str()) == 0) {
-                    HWND offsetEdit = GetDlgItem(hwnd, kOffsetEditId);
-                    if (offsetEdit) {
-                        std::wstringstream ss;
-                        ss << entry.offsetMinutes;
-                        auto txt = ss.str();
-                        SetWindowTextW(offsetEdit, txt.c_str());
-                    }
-                    HWND nameEdit = GetDlgItem(hwnd, kNameEditId);
-                    if (nameEdit) {
-                        SetWindowTextW(nameEdit, entry.city);
-                    }
-                    return true;
-                }
-            }
-            return false;
-        };
-
         if (id == kSearchButtonId && notif == BN_CLICKED) {
             wchar_t buffer[256] = {};
             GetDlgItemTextW(hwnd, kNameEditId, buffer, 255);
             std::wstring name = Trim(buffer);
-            if (name.empty() || !lookupAndFill(name)) {
+            auto matches = CityGazetteer().Search(ToUtf8(name), 1); // a typo still finds the city
+            if (matches.empty()) {
                 MessageBoxW(hwnd, L"City not found. Please try another name.", L"City Search", MB_ICONWARNING | MB_OK);
+                return TRUE;
             }
+            FillCityFields(hwnd, matches[0].entry);
+            SendMessageW(hwnd, kSetCityNameMessage, matches[0].entry, 0);
             return TRUE;
         }
 
-        if (id == kNameEditId && (notif == CBN_SELCHANGE || notif == CBN_EDITUPDATE)) {
-            // When selection changes, auto-fill offset if known
+        if (id == kNameEditId && notif == CBN_SELCHANGE) {
+            HWND combo = reinterpret_cast<HWND>(lParam);
+            LRESULT sel = SendMessageW(combo, CB_GETCURSEL, 0, 0);
+            if (sel != CB_ERR) {
+                WPARAM entry = static_cast<WPARAM>(SendMessageW(combo, CB_GETITEMDATA, static_cast<WPARAM>(sel), 0));
+                FillCityFields(hwnd, static_cast<uint32_t>(entry));
+                // The combo box copies the list text into the edit after this
+                // notification; replace it with the bare name afterwards.
+                PostMessageW(hwnd, kSetCityNameMessage, entry, 0);
+            }
+        }
+
+        if (id == kNameEditId && notif == CBN_EDITUPDATE && !g_updatingCityList) {
+            HWND combo = reinterpret_cast<HWND>(lParam);
             wchar_t buffer[256] = {};
-            if (notif == CBN_SELCHANGE) {
-                LRESULT sel = SendMessageW(reinterpret_cast<HWND>(lParam), CB_GETCURSEL, 0, 0);
-                if (sel != CB_ERR) {
-                    SendMessageW(reinterpret_cast<HWND>(lParam), CB_GETLBTEXT, sel, reinterpret_cast<LPARAM>(buffer));
-                }
-            } else {
-                GetWindowTextW(reinterpret_cast<HWND>(lParam), buffer, 255);
+            GetWindowTextW(combo, buffer, 255);
+            auto matches = UpdateCitySuggestions(combo, buffer);
+            // A name typed out in full fills in its zone, as picking it would
+            if (!matches.empty() && matches[0].exact && matches[0].edits == 0) {
+                FillCityFields(hwnd, matches[0].entry);
             }
-            std::wstring name = Trim(buffer);
-            lookupAndFill(name);
         }
 
         if (id == IDOK) {
             if (!state) return TRUE;
             wchar_t nameBuf[256] = {};
             wchar_t offsetBuf[64] = {};
+            wchar_t zoneBuf[128] = {};
             GetDlgItemTextW(hwnd, kNameEditId, nameBuf, 255);
             GetDlgItemTextW(hwnd, kOffsetEditId, offsetBuf, 63);
+            GetDlgItemTextW(hwnd, kZoneEditId, zoneBuf, 127);
             std::wstring name = Trim(nameBuf);
             if (name.empty()) {
                 MessageBoxW(hwnd, L"City name cannot be empty.", L"Validation", MB_ICONWARNING | MB_OK);
@@ -677,7 +765,11 @@ static INT_PTR CALLBACK CityDialogProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
                 MessageBoxW(hwnd, L"Enter a numeric UTC offset in minutes (e.g. -300 for UTC-5) or click Search to auto-fill.", L"Validation", MB_ICONWARNING | MB_OK);
                 return TRUE;
             }
-            state->result = {name, static_cast<int>(offset)};
+            std::string zoneId = ToUtf8(Trim(zoneBuf));
+            if (!zoneId.empty() && !clockcore::LoadTimeZone(zoneId)) {
+                MessageBoxW(hwnd, L"Time zone not found in the zoneinfo directory. The fixed UTC offset will be used.", L"Validation", MB_ICONWARNING | MB_OK);
+            }
+            state->result = {name, static_cast<int>(offset), zoneId};
             state->confirmed = true;
             EndDialog(hwnd, IDOK);
             return TRUE;
@@ -774,7 +866,7 @@ static std::vector<WORD> BuildTextDialogTemplate() {
         WriteWord(dlg, 0);
     };
 
-    addItem(WS_CHILD | WS_VISIBLE, 0, 10, 10, 220, 12, kNtpPromptId, 0x0082, L"Server host or IP:");
+    addItem(WS_CHILD | WS_VISIBLE, 0, 10, 10, 220, 12, kNtpPromptId, 0x0082, L"Server hosts or IPs (comma-separated):");
     addItem(WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL, WS_EX_CLIENTEDGE, 10, 28, 240, 16, kNtpEditId, 0x0081, L"");
     // Buttons laid out evenly across the bottom
     addItem(WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_PUSHBUTTON, 0, 12, 74, 70, 16, kNtpResetId, 0x0080, L"Reset");
@@ -858,32 +950,12 @@ static bool ShowTextDialog(HWND parent, const std::wstring& title, const std::ws
 static void DrawContent(HWND hwnd, HDC hdc) {
     RECT client;
     GetClientRect(hwnd, &client);
-    HBRUSH backBrush = CreateSolidBrush(RGB(20, 20, 20));
-    FillRect(hdc, &client, backBrush);
-    DeleteObject(backBrush);
-
-    RECT frameRect = client;
-    HBRUSH frameBrush = CreateSolidBrush(kFrameColor);
-    for (int i = 0; i < kFrameThickness; ++i) {
-        FrameRect(hdc, &frameRect, frameBrush);
-        InflateRect(&frameRect, -1, -1);
-    }
-    DeleteObject(frameBrush);
 
-    SetBkMode(hdc, TRANSPARENT);
-    SetTextColor(hdc, RGB(0, 255, 128));
-    HFONT oldFont = (HFONT)SelectObject(hdc, g_font);
+    // One clock read per frame; every line on the page is formatted against it.
+    clockcore::FormatFrame(g_cities, CurrentUtcFileTime(), g_layout.PageStart(g_page), g_layout.pageSize, g_frameText);
 
-    int padding = kInnerPadding + kFrameThickness;
-    int y = padding;
-    for (const auto& city : g_cities) {
-        std::wstring line = FormatCityTime(city);
-        TextOutW(hdc, padding, y, line.c_str(), static_cast<int>(line.size()));
-        SIZE sz = {};
-        GetTextExtentPoint32W(hdc, line.c_str(), static_cast<int>(line.size()), &sz);
-        y += sz.cy;
-    }
-    SelectObject(hdc, oldFont);
+    GdiRenderer renderer(hdc, g_font);
+    clockcore::DrawClockView(renderer, client.right - client.left, client.bottom - client.top, g_frameText, g_glyphCache, g_layout);
 }
 
 static void BuildContextMenu(HWND hwnd) {
@@ -923,21 +995,44 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
     case WM_CREATE:
         UpdateFont(hwnd);
-        SetTimer(hwnd, kTimerId, 1000, nullptr);
         SetLayeredWindowAttributes(hwnd, 0, 230, LWA_ALPHA);
-        StartNtpSyncAsync(hwnd, false);
+        StartNtpWorker(hwnd);
+        StartTickScheduler(hwnd);
+        StartMetricsExporter();
+        StartConfigWatcher(hwnd);
         ResizeToContent(hwnd);
         return 0;
-    case WM_TIMER:
+    case WM_APP_TICK:
+        if (g_layout.pageCount > 1) {
+            uint64_t boundary = g_pendingTickUtc.load(std::memory_order_relaxed);
+            if (boundary != 0 && boundary / clockcore::kTicksPerSecond % kPageSeconds == 0) {
+                ShowPage(hwnd, g_page + 1);
+            }
+        }
+        // Paint now rather than when the queue is otherwise empty.
         InvalidateRect(hwnd, nullptr, FALSE);
+        UpdateWindow(hwnd);
         return 0;
+    case WM_SHOWWINDOW:
+        if (g_tickScheduler) {
+            g_tickScheduler->SetPaused(!wParam);
+        }
+        break;
     case WM_LBUTTONDOWN:
         SendMessage(hwnd, WM_NCLBUTTONDOWN, HTCAPTION, 0);
         return 0;
     case WM_RBUTTONUP:
         BuildContextMenu(hwnd);
         return 0;
+    case WM_MOUSEWHEEL:
+        if (g_layout.pageCount > 1) {
+            ShowPage(hwnd, g_page + (GET_WHEEL_DELTA_WPARAM(wParam) > 0 ? g_layout.pageCount - 1 : 1));
+        }
+        return 0;
     case WM_SIZE:
+        if (g_tickScheduler && (wParam == SIZE_MINIMIZED || wParam == SIZE_RESTORED)) {
+            g_tickScheduler->SetPaused(wParam == SIZE_MINIMIZED);
+        }
         InvalidateRect(hwnd, nullptr, TRUE);
         return 0;
     case WM_COMMAND: {
@@ -945,7 +1040,9 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         if (id == IDM_ADD_CITY) {
             CityInfo newCity{L"", 0};
             if (ShowCityDialog(hwnd, nullptr, newCity)) {
+                clockcore::PrimeCityCache(newCity, CurrentUtcFileTime());
                 g_cities.push_back(newCity);
+                g_citiesDirty = true;
                 ResizeToContent(hwnd);
                 InvalidateRect(hwnd, nullptr, TRUE);
             }
@@ -956,7 +1053,9 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             if (idx < g_cities.size()) {
                 CityInfo updated = g_cities[idx];
                 if (ShowCityDialog(hwnd, &g_cities[idx], updated)) {
+                    clockcore::PrimeCityCache(updated, CurrentUtcFileTime());
                     g_cities[idx] = updated;
+                    g_citiesDirty = true;
                     ResizeToContent(hwnd);
                     InvalidateRect(hwnd, nullptr, TRUE);
                 }
@@ -967,6 +1066,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             size_t idx = id - IDM_DELETE_CITY_BASE;
             if (idx < g_cities.size()) {
                 g_cities.erase(g_cities.begin() + static_cast<long long>(idx));
+                g_citiesDirty = true;
                 ResizeToContent(hwnd);
                 InvalidateRect(hwnd, nullptr, TRUE);
             }
@@ -976,7 +1076,10 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         case IDM_SAVE_CITIES:
             SaveCitiesToFile();
             return 0;
-        case IDM_RELOAD_CITIES:
+        case IDM_RELOAD_CITIES: // edits are picked up automatically; this forces it
+            if (!ConfirmDiscardCityEdits(hwnd)) {
+                return 0;
+            }
             LoadCitiesFromFile();
             ResizeToContent(hwnd);
             InvalidateRect(hwnd, nullptr, TRUE);
@@ -986,32 +1089,46 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             ShellExecuteW(hwnd, L"open", L"notepad.exe", kCitiesPath.wstring().c_str(), nullptr, SW_SHOWNORMAL);
             return 0;
         case IDM_REFRESH_NTP:
-            StartNtpSyncAsync(hwnd, true);
+            RequestNtpSync(true);
             return 0;
         case IDM_SET_NTP_SERVER: {
             DebugTrace(L"[NTP dialog] menu clicked");
             std::wstring newServer;
-            if (ShowTextDialog(hwnd, L"NTP Server", L"Server host or IP:", g_ntpServer, newServer)) {
-                g_ntpServer = newServer;
-                SaveNtpServer();
+            if (ShowTextDialog(hwnd, L"NTP Server", L"Server hosts or IPs (comma-separated):", JoinServerList(g_ntpServers), newServer)) {
+                g_ntpServers = SplitServerList(newServer);
+                SaveNtpServers();
                 DebugTrace(L"[NTP dialog] new server saved, triggering sync");
-    StartNtpSyncAsync(hwnd, false);
+                if (g_ntpWorker) {
+                    g_ntpWorker->SetServers(NtpServersUtf8());
+                }
+                RequestNtpSync(false);
             } else {
                 DebugTrace(L"[NTP dialog] canceled or failed");
             }
             return 0;
         }
         case IDM_EXIT_APP:
-            PostQuitMessage(0);
+            DestroyWindow(hwnd); // WM_DESTROY stops the background threads, then quits
             return 0;
         default:
             break;
         }
         return 0;
     }
+    case WM_APP_CONFIG_CHANGED:
+        // Our own saves come back here too; they diff to no change. Unsaved
+        // in-window edits are only replaced if the user agrees.
+        if ((wParam & kConfigCitiesChanged) && ConfirmDiscardCityEdits(hwnd) && LoadCitiesFromFile()) {
+            ResizeToContent(hwnd);
+            InvalidateRect(hwnd, nullptr, TRUE);
+        }
+        if (wParam & kConfigNtpChanged) {
+            ReloadNtpServers();
+        }
+        return 0;
     case WM_APP_NTP_COMPLETE:
         if (wParam) { // showResult flag
-            if (g_lastNtpSuccess) {
+            if (lParam) {
                 MessageBoxW(hwnd, L"NTP sync succeeded.", L"NTP", MB_ICONINFORMATION | MB_OK);
             } else {
                 MessageBoxW(hwnd, L"NTP sync failed. Using local system time.", L"NTP", MB_ICONWARNING | MB_OK);
@@ -1022,12 +1139,19 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     case WM_PAINT: {
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
+        uint64_t paintStart = clockcore::MonotonicTicks();
         DrawContent(hwnd, hdc);
+        g_paintDuration.Record(static_cast<int64_t>(clockcore::MonotonicTicks() - paintStart) / clockcore::kTicksPerMicrosecond);
         EndPaint(hwnd, &ps);
+        uint64_t boundary = g_pendingTickUtc.exchange(0, std::memory_order_relaxed);
+        if (boundary != 0 && g_tickScheduler) {
+            g_tickScheduler->RecordPresent(boundary, CurrentUtcFileTime());
+        }
         return 0;
     }
     case WM_DESTROY:
-        KillTimer(hwnd, kTimerId);
+        StopBackgroundThreads();
+        g_glyphCache.Clear();
         PostQuitMessage(0);
         return 0;
     }
@@ -1036,7 +1160,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow) {
     LoadCitiesFromFile();
-    LoadNtpServer();
+    LoadNtpServers();
 
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
@@ -1070,6 +1194,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE, LPWSTR, int nCmdShow) {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
+    StopBackgroundThreads(); // in case WM_QUIT came without WM_DESTROY
 
     if (g_font) {
         DeleteObject(g_font);
@@ -0,0 +1,169 @@
+// Renders the clock window headlessly through the software backend: writes
+// a screenshot, compares against a reference image and times frames.
+//
+//   clock_render [--config-dir config] [--utc 2024-07-01T12:00:00Z] [--dpi 96]
+//                [-o frame.bmp] [--compare golden.bmp] [--tolerance 0]
+//                [--frames 1000] [--no-cache] [--cities 5000]
+//                [--max-size 1920x1080] [--page 0]
+//
+// --utc pins the displayed instant (default: now) so screenshots are
+// reproducible. --frames formats and paints that many consecutive seconds
+// and reports per-frame cost. Frames are composed from the glyph cache
+// unless --no-cache draws every string directly; both must produce the same
+// pixels. With --compare the exit status is 1 when any pixel differs by
+// more than --tolerance. --cities repeats the configured list (numbering the
+// copies) up to that many cities; --max-size lays them out in columns and
+// pages as the window does on a screen of that size, and --page picks the
+// page rendered.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/city_file.h"
+#include "core/clock_view.h"
+#include "core/monotonic.h"
+#include "core/software_renderer.h"
+#include "core/timestamp_text.h"
+
+using namespace clockcore;
+
+namespace {
+
+double PercentileUs(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path configDir = "config";
+    std::string utcText;
+    int dpi = 96;
+    std::string output;
+    std::string compare;
+    int tolerance = 0;
+    int frames = 0;
+    bool useCache = true;
+    size_t cityCount = 0;
+    TextSize maxSize;
+    size_t page = 0;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--config-dir") == 0 && hasValue) {
+            configDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--utc") == 0 && hasValue) {
+            utcText = argv[++i];
+        } else if (std::strcmp(argv[i], "--dpi") == 0 && hasValue) {
+            dpi = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--compare") == 0 && hasValue) {
+            compare = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+            tolerance = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            frames = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--no-cache") == 0) {
+            useCache = false;
+        } else if (std::strcmp(argv[i], "--cities") == 0 && hasValue) {
+            cityCount = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--max-size") == 0 && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &maxSize.width, &maxSize.height) != 2) {
+                std::fprintf(stderr, "clock_render: bad --max-size %s\n", argv[i]);
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--page") == 0 && hasValue) {
+            page = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else {
+            std::fprintf(stderr, "clock_render: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    uint64_t utc = SystemFileTime();
+    if (!utcText.empty()) {
+        ParsedTimestamp stamp;
+        if (ParseTimestamp(utcText.c_str(), utcText.size(), stamp) != utcText.size()) {
+            std::fprintf(stderr, "clock_render: bad --utc %s\n", utcText.c_str());
+            return 2;
+        }
+        utc = stamp.utc;
+    }
+
+    std::vector<CityInfo> cities;
+    if (!LoadCityFile(configDir / "cities.txt", cities) || cities.empty()) {
+        cities = DefaultCities();
+    }
+    for (size_t i = cities.size(), base = cities.size(); i < cityCount; ++i) {
+        CityInfo copy = cities[i % base];
+        copy.name += L" " + std::to_wstring(i / base + 1);
+        cities.push_back(std::move(copy));
+    }
+    for (auto& city : cities) {
+        PrimeCityCache(city, utc);
+    }
+
+    Framebuffer image;
+    SoftwareRenderer renderer(image, ClockFontPixelHeight(dpi));
+    ClockLineWidths widths;
+    widths.Update(renderer, cities);
+    ClockLayout layout = LayoutClockView(widths, cities.size(), maxSize);
+    image.Resize(layout.client.width, layout.client.height);
+    const size_t first = layout.PageStart(page);
+    const size_t visible = std::min(layout.pageSize, cities.size() - first);
+    ClockGlyphCache cache;
+    if (useCache) {
+        cache.SetVisibleRange(renderer, first, visible);
+        cache.Build(renderer, cities);
+    }
+    FrameText frame;
+
+    if (frames > 0) {
+        std::vector<double> costUs;
+        costUs.reserve(static_cast<size_t>(frames));
+        for (int i = 0; i < frames; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            FormatFrame(cities, utc + static_cast<uint64_t>(i) * kTicksPerSecond, first, visible, frame);
+            DrawClockView(renderer, image.width, image.height, frame, cache, layout);
+            costUs.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(costUs.begin(), costUs.end());
+        std::printf("%d frames of %dx%d, %zu cities (%zu shown), %s: p50 %.1f us  p99 %.1f us  max %.1f us\n", frames, image.width, image.height,
+                    cities.size(), visible, useCache ? "glyph cache" : "direct text", PercentileUs(costUs, 0.5), PercentileUs(costUs, 0.99), costUs.back());
+    }
+
+    // The reported frame is always the one at --utc.
+    FormatFrame(cities, utc, first, visible, frame);
+    DrawClockView(renderer, image.width, image.height, frame, cache, layout);
+
+    if (!output.empty()) {
+        if (!SaveFramebufferBmp(output, image)) {
+            std::fprintf(stderr, "clock_render: cannot write %s\n", output.c_str());
+            return 1;
+        }
+        std::printf("wrote %s (%dx%d)\n", output.c_str(), image.width, image.height);
+    }
+    if (!compare.empty()) {
+        Framebuffer reference;
+        if (!LoadFramebufferBmp(compare, reference)) {
+            std::fprintf(stderr, "clock_render: cannot read %s\n", compare.c_str());
+            return 2;
+        }
+        size_t differences = CountPixelDifferences(image, reference, tolerance);
+        if (differences == SIZE_MAX) {
+            std::printf("size differs: %dx%d vs %dx%d\n", image.width, image.height, reference.width, reference.height);
+            return 1;
+        }
+        std::printf("%zu of %zu pixels differ from %s\n", differences, image.pixels.size(), compare.c_str());
+        return differences == 0 ? 0 : 1;
+    }
+    return 0;
+}
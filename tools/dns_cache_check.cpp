@@ -0,0 +1,251 @@
+// Checks DnsCache against a StaticResolver host table and a driven clock.
+//
+// Covers hits and misses, TTL expiry and clamping, negative caching,
+// Invalidate, serving stale addresses while the background refresh fails,
+// the refresh at three quarters of the TTL picking up new addresses, and
+// concurrent misses for one host sharing a single resolver call (the
+// resolver is held open until every lookup is waiting). Time is simulated,
+// so TTLs of minutes take no wall time; only the refresher thread and the
+// coalescing threads are waited for, each for at most --timeout-ms. Exits 1
+// on any failed check.
+//
+//   dns_cache_check [--threads 8] [--timeout-ms 2000]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/calendar.h"
+#include "core/dns_cache.h"
+
+using namespace clockcore;
+
+namespace {
+
+int g_checks = 0;
+int g_failures = 0;
+int g_timeoutMs = 2000;
+
+void Check(bool ok, const char* what) {
+    ++g_checks;
+    if (!ok) {
+        ++g_failures;
+        std::printf("FAILED: %s\n", what);
+    }
+}
+
+// Simulated monotonic time, starting well away from zero.
+struct FakeClock {
+    std::atomic<uint64_t> now{1000 * kTicksPerSecond};
+
+    void Advance(uint64_t seconds) { now += seconds * kTicksPerSecond; }
+};
+
+DnsCacheOptions Options(FakeClock& clock, bool backgroundRefresh) {
+    DnsCacheOptions options;
+    options.backgroundRefresh = backgroundRefresh;
+    options.clock = [&clock] { return clock.now.load(); };
+    return options;
+}
+
+// Polls until done() or the timeout; for work on another thread.
+template <typename F>
+bool WaitFor(F&& done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(g_timeoutMs);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Passes lookups through to a StaticResolver, optionally holding each call
+// until Release() so concurrent misses pile up.
+class GatedResolver : public Resolver {
+public:
+    explicit GatedResolver(std::shared_ptr<StaticResolver> table) : table_(std::move(table)) {}
+
+    ResolveResult Resolve(const std::string& host) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++waiting_;
+        released_.wait(lock, [this] { return open_; });
+        --waiting_;
+        lock.unlock();
+        return table_->Resolve(host);
+    }
+
+    void Hold() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_ = false;
+    }
+    void Release() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+        }
+        released_.notify_all();
+    }
+    int waiting() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return waiting_;
+    }
+
+private:
+    std::shared_ptr<StaticResolver> table_;
+    std::mutex mutex_;
+    std::condition_variable released_;
+    bool open_ = true;
+    int waiting_ = 0;
+};
+
+void CheckTtlAndNegativeCaching() {
+    FakeClock clock;
+    auto table = std::make_shared<StaticResolver>();
+    table->SetHost("a.example", {"192.0.2.1"}, 60);
+    table->SetHost("b.example", {"192.0.2.2"}, 5); // below the 30 s minimum
+    table->SetHost("c.example", {"192.0.2.3"});    // no TTL: default 300 s
+    DnsCache cache(table, Options(clock, false));
+
+    DnsLookup first = cache.Lookup("a.example");
+    Check(first.ok && !first.fromCache && first.addresses == std::vector<std::string>{"192.0.2.1"}, "a miss resolves");
+    DnsLookup second = cache.Lookup("a.example");
+    Check(second.ok && second.fromCache && !second.stale && table->resolveCount() == 1, "a hit does not resolve again");
+
+    clock.Advance(59);
+    Check(cache.Lookup("a.example").fromCache && table->resolveCount() == 1, "still cached just before the TTL");
+    clock.Advance(1);
+    table->SetHost("a.example", {"192.0.2.11"}, 60);
+    DnsLookup expired = cache.Lookup("a.example");
+    Check(!expired.fromCache && table->resolveCount() == 2 && expired.addresses == std::vector<std::string>{"192.0.2.11"},
+          "an expired entry is resolved again");
+
+    cache.Lookup("b.example");
+    clock.Advance(29);
+    Check(cache.Lookup("b.example").fromCache, "a short TTL is raised to the minimum");
+    clock.Advance(1);
+    Check(!cache.Lookup("b.example").fromCache, "the minimum TTL still expires");
+
+    cache.Lookup("c.example");
+    clock.Advance(299);
+    Check(cache.Lookup("c.example").fromCache, "a missing TTL uses the default");
+    clock.Advance(1);
+    Check(!cache.Lookup("c.example").fromCache, "the default TTL expires");
+
+    uint64_t before = table->resolveCount();
+    DnsLookup missing = cache.Lookup("missing.example");
+    Check(!missing.ok && !missing.fromCache && table->resolveCount() == before + 1, "an unknown host fails");
+    clock.Advance(29);
+    DnsLookup negative = cache.Lookup("missing.example");
+    Check(!negative.ok && negative.fromCache && table->resolveCount() == before + 1, "a failure is cached for the negative TTL");
+    table->SetHost("missing.example", {"192.0.2.4"}, 60);
+    clock.Advance(1);
+    DnsLookup recovered = cache.Lookup("missing.example");
+    Check(recovered.ok && !recovered.fromCache, "a failure is retried after the negative TTL");
+
+    cache.Invalidate("missing.example");
+    before = table->resolveCount();
+    Check(!cache.Lookup("missing.example").fromCache && table->resolveCount() == before + 1, "Invalidate forces a resolve");
+    cache.Clear();
+    before = table->resolveCount();
+    Check(!cache.Lookup("a.example").fromCache && table->resolveCount() == before + 1, "Clear forces a resolve");
+}
+
+void CheckStaleAndRefresh() {
+    FakeClock clock;
+    auto table = std::make_shared<StaticResolver>();
+    table->SetHost("ntp.example", {"192.0.2.10"}, 60);
+    DnsCache cache(table, Options(clock, true));
+
+    cache.Lookup("ntp.example");
+    Check(table->resolveCount() == 1, "background: first lookup resolves");
+
+    // At three quarters of the TTL a used entry is refreshed in the background.
+    table->SetHost("ntp.example", {"192.0.2.20"}, 60);
+    clock.Advance(45);
+    DnsLookup due = cache.Lookup("ntp.example");
+    Check(due.fromCache && due.addresses == std::vector<std::string>{"192.0.2.10"}, "a lookup due for refresh is served from cache");
+    Check(WaitFor([&] { return table->resolveCount() == 2; }), "the refresher re-resolves at 3/4 of the TTL");
+    Check(WaitFor([&] { return cache.Lookup("ntp.example").addresses == std::vector<std::string>{"192.0.2.20"}; }),
+          "the refreshed addresses are served");
+
+    // The resolver goes away: the last good addresses are served stale.
+    table->RemoveHost("ntp.example");
+    clock.Advance(45);
+    cache.Lookup("ntp.example");
+    Check(WaitFor([&] { return table->resolveCount() == 3; }), "a failing refresh is attempted");
+    clock.Advance(30);
+    DnsLookup stale = cache.Lookup("ntp.example");
+    Check(stale.ok && stale.fromCache && stale.stale && stale.addresses == std::vector<std::string>{"192.0.2.20"},
+          "expired addresses are served stale while refresh fails");
+    Check(WaitFor([&] { return table->resolveCount() == 4; }), "a failed refresh is retried after the negative TTL");
+
+    // Past maxStaleSeconds the entry is finally given up.
+    clock.Advance(86400);
+    DnsLookup gone = cache.Lookup("ntp.example");
+    Check(!gone.ok && !gone.fromCache, "stale addresses are dropped after maxStaleSeconds");
+}
+
+void CheckCoalescing(int threads) {
+    FakeClock clock;
+    auto table = std::make_shared<StaticResolver>();
+    table->SetHost("pool.example", {"192.0.2.30", "2001:db8::30"}, 60);
+    auto gated = std::make_shared<GatedResolver>(table);
+    DnsCache cache(gated, Options(clock, false));
+
+    gated->Hold();
+    std::atomic<int> started{0};
+    std::atomic<int> succeeded{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            ++started;
+            DnsLookup lookup = cache.Lookup("pool.example");
+            if (lookup.ok && lookup.addresses.size() == 2) {
+                ++succeeded;
+            }
+        });
+    }
+    Check(WaitFor([&] { return gated->waiting() == 1 && started == threads; }), "one lookup reaches the resolver");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // let the rest queue behind it
+    Check(gated->waiting() == 1, "concurrent misses do not start more resolves");
+    gated->Release();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    Check(succeeded == threads, "every waiting lookup gets the shared answer");
+    Check(table->resolveCount() == 1, "concurrent misses share one resolver call");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int threads = 8;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = std::max(2, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--timeout-ms") == 0 && hasValue) {
+            g_timeoutMs = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "dns_cache_check: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    CheckTtlAndNegativeCaching();
+    CheckStaleAndRefresh();
+    CheckCoalescing(threads);
+    std::printf("dns_cache_check: %d checks, %d failures\n", g_checks, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
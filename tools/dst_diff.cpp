@@ -0,0 +1,443 @@
+// Differential check of the DST engine against the system tz database.
+//
+// Every hour from --from to --to (UTC years, inclusive) is converted by the
+// C library (localtime_r with TZ set) and by clockcore, and the UTC offsets
+// must agree. Each transition found on the way is then pinned to the second
+// and fuzzed: the seconds either side plus --fuzz random instants within two
+// hours of it. --random adds arbitrary instants across the whole range.
+//
+//   dst_diff [--from 1970] [--to 2100] [--fuzz 32] [--random 2000]
+//            [--seed 1] [--zone America/New_York]... [--all-zones]
+//            [--threads N] [--quiet]
+//
+// Two kinds of case run:
+//   - built-in DST cities (name-based DstRule tables, no zone id), checked
+//     only over the years their current law has applied, through the direct
+//     GetDstAdjustmentMinutes path, GetDstInterval and the city offset cache;
+//   - IANA zones through TzZone::Lookup and the city offset cache, over the
+//     full range (the default set, --zone ids, or every zone with --all-zones).
+// The C library is consulted serially (TZ is process-wide); the engine
+// checks then run on --threads workers. Exits 1 on any mismatch, 2 on bad
+// usage or missing zone data.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "core/city.h"
+#include "core/city_file.h"
+#include "core/timestamp_text.h"
+#include "core/tzif.h"
+
+using namespace clockcore;
+
+namespace {
+
+struct Options {
+    int fromYear = 1970;
+    int toYear = 2100;
+    int fuzzPerTransition = 32;
+    int randomPerCase = 2000;
+    uint64_t seed = 1;
+    std::vector<std::string> zones;
+    bool allZones = false;
+    unsigned threads = 0; // 0 = one per hardware thread
+    bool quiet = false;
+};
+
+// Built-in DST cities and the zone whose history they approximate, limited
+// to the years the rule table matches the law in force.
+struct LegacyCase {
+    const wchar_t* name;
+    int baseOffsetMinutes;
+    const char* zone;
+    int firstYear;
+    int lastYear;
+};
+
+const LegacyCase kLegacyCases[] = {
+    {L"New York", -300, "America/New_York", 2007, 9999},
+    {L"Los Angeles", -480, "America/Los_Angeles", 2007, 9999},
+    {L"Chicago", -360, "America/Chicago", 2007, 9999},
+    {L"San Francisco", -480, "America/Los_Angeles", 2007, 9999},
+    {L"Toronto", -300, "America/Toronto", 2007, 9999},
+    {L"Mexico City", -360, "America/Mexico_City", 2023, 9999},
+    {L"London", 0, "Europe/London", 1996, 9999},
+    {L"Berlin", 60, "Europe/Berlin", 1996, 9999},
+    {L"Paris", 60, "Europe/Paris", 1996, 9999},
+    {L"Sydney", 600, "Australia/Sydney", 2008, 9999},
+    {L"Auckland", 720, "Pacific/Auckland", 2008, 9999},
+};
+
+// Zones with the shapes most likely to trip an engine: southern-hemisphere
+// rules, negative and half-hour DST, sub-hour base offsets, abolished DST,
+// skipped days and far-future footer rules.
+const char* const kDefaultZones[] = {
+    "America/New_York", "America/Los_Angeles", "America/Chicago", "America/Toronto", "America/Mexico_City",
+    "America/Sao_Paulo", "America/Santiago", "America/St_Johns", "Europe/London", "Europe/Berlin",
+    "Europe/Paris", "Europe/Dublin", "Europe/Moscow", "Africa/Casablanca", "Asia/Kolkata",
+    "Asia/Tehran", "Asia/Shanghai", "Australia/Sydney", "Australia/Lord_Howe", "Pacific/Auckland",
+    "Pacific/Chatham", "Pacific/Apia", "Antarctica/Troll",
+};
+
+// The C library's view of one zone. TZ is process-wide, so only one
+// reference is active at a time.
+class ReferenceZone {
+public:
+    explicit ReferenceZone(const std::string& zone) {
+        setenv("TZ", (":" + zone).c_str(), 1);
+        tzset();
+    }
+    ~ReferenceZone() {
+        unsetenv("TZ");
+        tzset();
+    }
+
+    long OffsetSeconds(int64_t unixSeconds) const {
+        time_t t = static_cast<time_t>(unixSeconds);
+        std::tm local = {};
+        localtime_r(&t, &local);
+        return local.tm_gmtoff;
+    }
+};
+
+struct CaseResult {
+    uint64_t instants = 0;
+    uint64_t transitions = 0;
+    uint64_t mismatches = 0;
+    std::vector<std::string> reports; // the first few mismatches
+};
+
+class Checker {
+public:
+    explicit Checker(std::string label) : label_(std::move(label)) {}
+    virtual ~Checker() = default;
+
+    // Compares every path at one instant; utc carries the sub-second part.
+    void Check(uint64_t utc, long expected, CaseResult& result) {
+        ++result.instants;
+        const char* path = nullptr;
+        long got = 0;
+        if (!Compare(utc, expected, path, got)) {
+            ++result.mismatches;
+            if (result.reports.size() < kMaxReported) {
+                char text[kMaxIsoTimestampLength + 1] = {};
+                IsoFormatter formatter;
+                formatter.Format(text, utc, 0, 0);
+                char line[256];
+                std::snprintf(line, sizeof(line), "  MISMATCH %s at %s: system %+ld s, %s %+ld s", label_.c_str(), text, expected, path, got);
+                result.reports.push_back(line);
+            }
+        }
+    }
+
+    const std::string& label() const { return label_; }
+
+protected:
+    // Returns false and names the failing path on the first disagreement.
+    virtual bool Compare(uint64_t utc, long expectedSeconds, const char*& path, long& gotSeconds) = 0;
+
+private:
+    static constexpr size_t kMaxReported = 5;
+    std::string label_;
+};
+
+class LegacyChecker : public Checker {
+public:
+    explicit LegacyChecker(const LegacyCase& entry)
+        : Checker(Utf8FromWide(entry.name) + " (rule table vs " + entry.zone + ")"), entry_(entry) {
+        city_.name = entry.name;
+        city_.offsetMinutes = entry.baseOffsetMinutes;
+        PrimeCityCache(city_, FileTimeFromUnixSeconds(0));
+        rule_ = GetDstRule(city_.dstScheme);
+    }
+
+protected:
+    bool Compare(uint64_t utc, long expectedSeconds, const char*& path, long& gotSeconds) override {
+        int base = entry_.baseOffsetMinutes;
+        int direct = base + (rule_ ? GetDstAdjustmentMinutes(*rule_, base, utc) : 0);
+        if (direct * 60L != expectedSeconds) {
+            path = "GetDstAdjustmentMinutes";
+            gotSeconds = direct * 60L;
+            return false;
+        }
+        if (rule_) {
+            DstInterval interval = GetDstInterval(*rule_, base, utc);
+            bool inside = utc >= interval.validFrom && utc < interval.validUntil;
+            if (!inside || (base + interval.adjustMinutes) * 60L != expectedSeconds) {
+                path = inside ? "GetDstInterval" : "GetDstInterval bounds";
+                gotSeconds = (base + interval.adjustMinutes) * 60L;
+                return false;
+            }
+        }
+        int cached = GetCityOffsetMinutes(city_, utc);
+        if (cached * 60L != expectedSeconds) {
+            path = "GetCityOffsetMinutes";
+            gotSeconds = cached * 60L;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    const LegacyCase& entry_;
+    CityInfo city_;
+    const DstRule* rule_ = nullptr;
+};
+
+class ZoneChecker : public Checker {
+public:
+    ZoneChecker(const std::string& zoneId, std::shared_ptr<const TzZone> zone) : Checker(zoneId), zone_(std::move(zone)) {
+        city_.name = WideFromUtf8(zoneId);
+        city_.offsetMinutes = 0;
+        city_.zoneId = zoneId;
+        PrimeCityCache(city_, FileTimeFromUnixSeconds(0));
+    }
+
+protected:
+    bool Compare(uint64_t utc, long expectedSeconds, const char*& path, long& gotSeconds) override {
+        int64_t unixSeconds = UnixSecondsFromFileTime(utc);
+        ZoneOffset offset = zone_->Lookup(unixSeconds);
+        bool inside = unixSeconds >= offset.validFrom && unixSeconds < offset.validUntil;
+        if (!inside || offset.utcOffsetSeconds != expectedSeconds) {
+            path = inside ? "TzZone::Lookup" : "TzZone::Lookup bounds";
+            gotSeconds = offset.utcOffsetSeconds;
+            return false;
+        }
+        // The city cache keeps whole minutes, truncated like the lookup path.
+        int cached = GetCityOffsetMinutes(city_, utc);
+        if (cached != static_cast<int>(expectedSeconds / 60)) {
+            path = "GetCityOffsetMinutes";
+            gotSeconds = cached * 60L;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::shared_ptr<const TzZone> zone_;
+    CityInfo city_;
+};
+
+int64_t UnixSecondsOfYear(int year) {
+    return DaysFromCivil(year, 1, 1) * 86400;
+}
+
+// Finds the exact second of every offset change in [begin, end). The C
+// library is sampled once a day and bisected where the offset moved; no zone
+// changes offset twice within one day, and the fuzz pass would catch a pair
+// that cancelled out.
+struct ReferenceTransition {
+    int64_t at;
+    long offsetSeconds; // in effect from at onwards
+};
+
+std::vector<ReferenceTransition> FindTransitions(const ReferenceZone& reference, int64_t begin, int64_t end, long& initialOffset) {
+    std::vector<ReferenceTransition> transitions;
+    initialOffset = reference.OffsetSeconds(begin);
+    long previous = initialOffset;
+    for (int64_t t = begin; t < end + 86400; t += 86400) {
+        int64_t sample = std::min(t, end - 1);
+        long current = reference.OffsetSeconds(sample);
+        if (current == previous) {
+            continue;
+        }
+        int64_t lo = std::max(begin, t - 86400);
+        int64_t hi = sample;
+        while (hi - lo > 1) {
+            int64_t mid = lo + (hi - lo) / 2;
+            (reference.OffsetSeconds(mid) == current ? hi : lo) = mid;
+        }
+        transitions.push_back({hi, current});
+        previous = current;
+    }
+    return transitions;
+}
+
+// One case: the reference data gathered up front, then checked by a worker.
+struct CasePlan {
+    std::unique_ptr<Checker> checker;
+    int firstYear;
+    int lastYear;
+    int64_t begin; // Unix seconds, [begin, end)
+    int64_t end;
+    long initialOffset = 0;
+    std::vector<ReferenceTransition> transitions;
+    std::vector<std::pair<uint64_t, long>> samples; // fuzzed instants and the C library's offset
+    CaseResult result;
+};
+
+// Gathers the transitions of [firstYear, lastYear] and the fuzz instants:
+// the ticks either side of each transition, random instants within two
+// hours of it, and random instants anywhere in the range.
+CasePlan PlanCase(std::unique_ptr<Checker> checker, const ReferenceZone& reference, int firstYear, int lastYear, const Options& options,
+                  std::mt19937_64& random) {
+    CasePlan plan;
+    plan.checker = std::move(checker);
+    plan.firstYear = firstYear;
+    plan.lastYear = lastYear;
+    plan.begin = UnixSecondsOfYear(firstYear);
+    plan.end = UnixSecondsOfYear(lastYear + 1);
+    plan.transitions = FindTransitions(reference, plan.begin, plan.end, plan.initialOffset);
+
+    uint64_t first = FileTimeFromUnixSeconds(plan.begin);
+    uint64_t last = FileTimeFromUnixSeconds(plan.end) - 1;
+    auto sample = [&](uint64_t utc) {
+        if (utc >= first && utc <= last) {
+            plan.samples.emplace_back(utc, reference.OffsetSeconds(UnixSecondsFromFileTime(utc)));
+        }
+    };
+    std::uniform_int_distribution<int64_t> nearby(-2 * 3600 * kTicksPerSecond, 2 * 3600 * kTicksPerSecond);
+    for (const auto& transition : plan.transitions) {
+        uint64_t edge = FileTimeFromUnixSeconds(transition.at);
+        for (int64_t delta : {-kTicksPerSecond, int64_t{-1}, int64_t{0}, int64_t{1}, kTicksPerSecond}) {
+            sample(edge + static_cast<uint64_t>(delta));
+        }
+        for (int i = 0; i < options.fuzzPerTransition; ++i) {
+            sample(edge + static_cast<uint64_t>(nearby(random)));
+        }
+    }
+    std::uniform_int_distribution<uint64_t> anywhere(first, last);
+    for (int i = 0; i < options.randomPerCase; ++i) {
+        sample(anywhere(random));
+    }
+    return plan;
+}
+
+// Checks every hour of the range against the reference transitions, then
+// the fuzzed instants. Touches only the plan, so plans run in parallel.
+void RunCase(CasePlan& plan) {
+    CaseResult& result = plan.result;
+    result.transitions = plan.transitions.size();
+    long current = plan.initialOffset;
+    size_t next = 0;
+    for (int64_t t = plan.begin; t < plan.end; t += 3600) {
+        while (next < plan.transitions.size() && plan.transitions[next].at <= t) {
+            current = plan.transitions[next++].offsetSeconds;
+        }
+        plan.checker->Check(FileTimeFromUnixSeconds(t), current, result);
+    }
+    for (const auto& sample : plan.samples) {
+        plan.checker->Check(sample.first, sample.second, result);
+    }
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--from") == 0 && hasValue) {
+            options.fromYear = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--to") == 0 && hasValue) {
+            options.toYear = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fuzz") == 0 && hasValue) {
+            options.fuzzPerTransition = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--random") == 0 && hasValue) {
+            options.randomPerCase = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--zone") == 0 && hasValue) {
+            options.zones.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--all-zones") == 0) {
+            options.allZones = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+            options.threads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--quiet") == 0) {
+            options.quiet = true;
+        } else {
+            std::fprintf(stderr, "dst_diff: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    if (options.fromYear < 1970 || options.toYear < options.fromYear || options.toYear > 9999) {
+        std::fprintf(stderr, "dst_diff: bad year range %d-%d\n", options.fromYear, options.toYear);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (options.allZones) {
+        options.zones = ListZoneIds();
+    } else if (options.zones.empty()) {
+        options.zones.assign(std::begin(kDefaultZones), std::end(kDefaultZones));
+    }
+
+    std::mt19937_64 random(options.seed);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CasePlan> plans;
+    for (const auto& entry : kLegacyCases) {
+        if (!std::filesystem::exists(ZoneInfoDirectory() / entry.zone)) {
+            std::fprintf(stderr, "dst_diff: no zone data for %s under %s\n", entry.zone, ZoneInfoDirectory().string().c_str());
+            return 2;
+        }
+        int firstYear = std::max(options.fromYear, entry.firstYear);
+        int lastYear = std::min(options.toYear, entry.lastYear);
+        if (firstYear > lastYear) {
+            continue;
+        }
+        ReferenceZone reference(entry.zone);
+        plans.push_back(PlanCase(std::make_unique<LegacyChecker>(entry), reference, firstYear, lastYear, options, random));
+    }
+    for (const auto& zoneId : options.zones) {
+        auto zone = LoadTimeZone(zoneId);
+        if (!zone) {
+            std::fprintf(stderr, "dst_diff: cannot load zone %s from %s\n", zoneId.c_str(), ZoneInfoDirectory().string().c_str());
+            return 2;
+        }
+        ReferenceZone reference(zoneId);
+        plans.push_back(PlanCase(std::make_unique<ZoneChecker>(zoneId, zone), reference, options.fromYear, options.toYear, options, random));
+    }
+
+    unsigned threadCount = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<size_t> nextPlan{0};
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back([&] {
+            for (size_t index; (index = nextPlan.fetch_add(1)) < plans.size();) {
+                RunCase(plans[index]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    CaseResult total;
+    for (const auto& plan : plans) {
+        const CaseResult& result = plan.result;
+        total.instants += result.instants;
+        total.transitions += result.transitions;
+        total.mismatches += result.mismatches;
+        for (const auto& line : result.reports) {
+            std::printf("%s\n", line.c_str());
+        }
+        if (!options.quiet || result.mismatches > 0) {
+            std::printf("%-48s %d-%d: %llu instants, %llu transitions, %llu mismatches\n", plan.checker->label().c_str(), plan.firstYear,
+                        plan.lastYear, static_cast<unsigned long long>(result.instants), static_cast<unsigned long long>(result.transitions),
+                        static_cast<unsigned long long>(result.mismatches));
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("dst_diff: %zu cases, %llu instants, %llu transitions, %llu mismatches in %.2f s on %u threads (seed %llu)\n",
+                plans.size(), static_cast<unsigned long long>(total.instants), static_cast<unsigned long long>(total.transitions),
+                static_cast<unsigned long long>(total.mismatches), seconds, threadCount, static_cast<unsigned long long>(options.seed));
+    return total.mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+// Builds the city search index (gazetteer.idx) the Add City dialog maps.
+//
+//   gazetteer_build [--min-population N] [--alternates] [-o gazetteer.idx]
+//                   input...
+//
+// Inputs are GeoNames dumps (cities500.txt, cities15000.txt, allCountries.txt:
+// tab-separated, 19 columns) or pipe-separated lines of the form
+//
+//   Name|Country|Zone|Population[|Alternate;Alternate...]
+//
+// '#' starts a comment line in the pipe format. --alternates also indexes the
+// GeoNames alternate names (exonyms such as "Munich" for "München"); they are
+// searchable but never displayed. Each entry's fallback offset is its zone's
+// standard offset this year, read from the zoneinfo database ($TZDIR).
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/calendar.h"
+#include "core/gazetteer.h"
+#include "core/tzif.h"
+
+using namespace clockcore;
+
+namespace {
+
+struct Options {
+    uint32_t minPopulation = 0;
+    bool alternates = false;
+    std::string output = "gazetteer.idx";
+    std::vector<std::string> inputs;
+};
+
+std::vector<std::string> Split(const std::string& line, char delimiter) {
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    for (;;) {
+        size_t end = line.find(delimiter, begin);
+        fields.push_back(line.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        if (end == std::string::npos) {
+            return fields;
+        }
+        begin = end + 1;
+    }
+}
+
+// Standard (non-DST) offset in minutes; false if the zone is not in the
+// database.
+bool StandardOffset(const std::string& zoneId, int& offsetMinutes) {
+    static std::unordered_map<std::string, int> cache;
+    auto it = cache.find(zoneId);
+    if (it != cache.end()) {
+        offsetMinutes = it->second;
+        return it->second != INT32_MIN;
+    }
+    int result = INT32_MIN;
+    if (auto zone = LoadTimeZone(zoneId)) {
+        // Mid-January and mid-July: one of them is standard time in either hemisphere.
+        int year = 0, month = 0, day = 0;
+        CivilFromDays(static_cast<int64_t>(std::time(nullptr)) / 86400, year, month, day);
+        ZoneOffset winter = zone->Lookup(DaysFromCivil(year, 1, 15) * 86400);
+        ZoneOffset summer = zone->Lookup(DaysFromCivil(year, 7, 15) * 86400);
+        result = (winter.isDst ? summer : winter).utcOffsetSeconds / 60;
+    }
+    cache.emplace(zoneId, result);
+    offsetMinutes = result;
+    return result != INT32_MIN;
+}
+
+bool ParseLine(const std::string& line, const Options& options, GazetteerRecord& record) {
+    std::vector<std::string> fields = Split(line, '\t');
+    if (fields.size() >= 19) {
+        if (fields[6] != "P") { // populated places only
+            return false;
+        }
+        record.name = fields[1];
+        record.country = fields[8];
+        record.population = static_cast<uint32_t>(std::strtoul(fields[14].c_str(), nullptr, 10));
+        record.zoneId = fields[17];
+        record.alternateNames.clear();
+        if (fields[2] != fields[1]) {
+            record.alternateNames.push_back(fields[2]); // ASCII spelling
+        }
+        if (options.alternates && !fields[3].empty()) {
+            for (auto& alternate : Split(fields[3], ',')) {
+                record.alternateNames.push_back(std::move(alternate));
+            }
+        }
+    } else {
+        if (line.empty() || line[0] == '#') {
+            return false;
+        }
+        fields = Split(line, '|');
+        if (fields.size() < 4) {
+            return false;
+        }
+        record.name = fields[0];
+        record.country = fields[1];
+        record.zoneId = fields[2];
+        record.population = static_cast<uint32_t>(std::strtoul(fields[3].c_str(), nullptr, 10));
+        record.alternateNames = fields.size() > 4 ? Split(fields[4], ';') : std::vector<std::string>();
+    }
+    return !record.name.empty() && !record.zoneId.empty() && record.population >= options.minPopulation;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--min-population") == 0 && hasValue) {
+            options.minPopulation = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--alternates") == 0) {
+            options.alternates = true;
+        } else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            options.output = argv[++i];
+        } else if (argv[i][0] != '-') {
+            options.inputs.push_back(argv[i]);
+        } else {
+            std::fprintf(stderr, "gazetteer_build: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    if (options.inputs.empty()) {
+        std::fprintf(stderr, "usage: gazetteer_build [--min-population N] [--alternates] [-o gazetteer.idx] input...\n");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    auto begin = std::chrono::steady_clock::now();
+
+    std::vector<GazetteerRecord> records;
+    size_t unknownZones = 0;
+    size_t alternates = 0;
+    for (const auto& input : options.inputs) {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            std::fprintf(stderr, "gazetteer_build: cannot open %s\n", input.c_str());
+            return 1;
+        }
+        std::string line;
+        GazetteerRecord record;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!ParseLine(line, options, record)) {
+                continue;
+            }
+            if (!StandardOffset(record.zoneId, record.offsetMinutes)) {
+                ++unknownZones;
+                continue;
+            }
+            alternates += record.alternateNames.size();
+            records.push_back(record);
+        }
+    }
+    auto parsed = std::chrono::steady_clock::now();
+
+    std::vector<unsigned char> index = BuildGazetteerIndex(records);
+    auto built = std::chrono::steady_clock::now();
+
+    Gazetteer check;
+    if (!check.Load(index)) {
+        std::fprintf(stderr, "gazetteer_build: built index fails validation\n");
+        return 1;
+    }
+    std::ofstream out(options.output, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+    if (!out) {
+        std::fprintf(stderr, "gazetteer_build: cannot write %s\n", options.output.c_str());
+        return 1;
+    }
+
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::fprintf(stderr, "gazetteer_build: %zu cities, %zu alternate names (%zu skipped for unknown zones)\n", records.size(),
+                 alternates, unknownZones);
+    std::fprintf(stderr, "gazetteer_build: %s is %.1f MB (%.1f bytes/city); parse %.0f ms, build %.0f ms\n", options.output.c_str(),
+                 static_cast<double>(index.size()) / (1 << 20),
+                 records.empty() ? 0.0 : static_cast<double>(index.size()) / static_cast<double>(records.size()), ms(begin, parsed),
+                 ms(parsed, built));
+    return 0;
+}
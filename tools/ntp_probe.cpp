@@ -0,0 +1,95 @@
+// Queries NTP servers repeatedly and reports offset, delay and, when the
+// true offset is known (e.g. against ntp_responder), the measurement error.
+// --server may be repeated; each round then queries all servers concurrently
+// and reports the offset chosen by SelectNtpOffset.
+//
+//   ntp_probe [--server 127.0.0.1]... [--port 12300] [--count 10]
+//             [--timeout-ms 2000] [--expect-offset-ms x]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "core/net.h"
+#include "core/ntp_client.h"
+#include "core/ntp_select.h"
+
+using namespace clockcore;
+
+int main(int argc, char** argv) {
+    std::vector<std::string> servers;
+    std::string port = "12300";
+    int count = 10;
+    int timeoutMs = 2000;
+    bool haveExpected = false;
+    double expectedMs = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--server") == 0) {
+            servers.push_back(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--port") == 0) {
+            port = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--count") == 0) {
+            count = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--timeout-ms") == 0) {
+            timeoutMs = std::atoi(argv[i + 1]);
+        } else if (std::strcmp(argv[i], "--expect-offset-ms") == 0) {
+            haveExpected = true;
+            expectedMs = std::atof(argv[i + 1]);
+        } else {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (servers.empty()) {
+        servers.push_back("127.0.0.1");
+    }
+    InitializeNetworking();
+    NtpQueryOptions options;
+    options.timeoutMs = timeoutMs;
+    options.port = port;
+
+    std::vector<double> errors;
+    int failures = 0;
+    for (int i = 0; i < count; ++i) {
+        std::vector<NtpSample> samples;
+        for (const auto& reply : QueryNtpServers(servers, options)) {
+            if (reply.error != NtpError::None) {
+                std::printf("#%d %s %s\n", i, reply.host.c_str(), NtpErrorName(reply.error));
+                continue;
+            }
+            std::printf("#%d %s offset %+.3f ms delay %.3f ms stratum %u\n", i, reply.address.c_str(),
+                        static_cast<double>(reply.sample.offset) / 10000.0, static_cast<double>(reply.sample.delay) / 10000.0,
+                        reply.sample.stratum);
+            samples.push_back(reply.sample);
+        }
+        NtpSelection selection = SelectNtpOffset(samples);
+        if (!selection.valid) {
+            std::printf("#%d no majority among %zu samples\n", i, samples.size());
+            ++failures;
+            continue;
+        }
+        double offsetMs = static_cast<double>(selection.combined.offset) / 10000.0;
+        std::printf("#%d selected offset %+.3f ms survivors %zu/%zu", i, offsetMs, selection.survivors, selection.candidates);
+        if (haveExpected) {
+            errors.push_back(offsetMs - expectedMs);
+            std::printf(" error %+.3f ms", errors.back());
+        }
+        std::printf("\n");
+    }
+
+    if (!errors.empty()) {
+        double sum = 0;
+        double maxAbs = 0;
+        for (double e : errors) {
+            sum += e;
+            maxAbs = std::max(maxAbs, std::fabs(e));
+        }
+        std::printf("samples %zu failures %d mean error %+.3f ms max |error| %.3f ms\n", errors.size(), failures, sum / static_cast<double>(errors.size()), maxAbs);
+    }
+    ShutdownNetworking();
+    return failures == count ? 1 : 0;
+}
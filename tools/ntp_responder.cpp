@@ -0,0 +1,151 @@
+// Loopback NTP server for measuring client accuracy without a network.
+//
+// Answers NTPv4 client requests from the host clock plus a configurable
+// offset, and can inject path delay, asymmetry and bad replies:
+//
+//   ntp_responder [--bind 127.0.0.1] [--port 12300] [--offset-ms 0]
+//                 [--delay-ms 0] [--asymmetry-ms 0] [--stratum 2] [--leap 0]
+//                 [--mode 4] [--bad-origin] [--count 0]
+//
+// --delay-ms is applied on both paths; --asymmetry-ms is added to the request
+// path only, which a client cannot see and shows up as offset error / 2.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "core/monotonic.h"
+#include "core/net.h"
+#include "core/ntp.h"
+
+using namespace clockcore;
+
+namespace {
+
+struct Options {
+    std::string bind = "127.0.0.1";
+    std::string port = "12300";
+    double offsetMs = 0;
+    double delayMs = 0;
+    double asymmetryMs = 0;
+    int stratum = 2;
+    int leap = 0;
+    int mode = kNtpModeServer;
+    bool badOrigin = false;
+    long count = 0;
+};
+
+void SleepMs(double ms) {
+    if (ms > 0) {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(ms));
+    }
+}
+
+bool ParseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--bad-origin") == 0) {
+            options.badOrigin = true;
+            continue;
+        }
+        if (!value) {
+            return false;
+        }
+        if (std::strcmp(arg, "--bind") == 0) {
+            options.bind = value;
+        } else if (std::strcmp(arg, "--port") == 0) {
+            options.port = value;
+        } else if (std::strcmp(arg, "--offset-ms") == 0) {
+            options.offsetMs = std::atof(value);
+        } else if (std::strcmp(arg, "--delay-ms") == 0) {
+            options.delayMs = std::atof(value);
+        } else if (std::strcmp(arg, "--asymmetry-ms") == 0) {
+            options.asymmetryMs = std::atof(value);
+        } else if (std::strcmp(arg, "--stratum") == 0) {
+            options.stratum = std::atoi(value);
+        } else if (std::strcmp(arg, "--leap") == 0) {
+            options.leap = std::atoi(value);
+        } else if (std::strcmp(arg, "--mode") == 0) {
+            options.mode = std::atoi(value);
+        } else if (std::strcmp(arg, "--count") == 0) {
+            options.count = std::atol(value);
+        } else {
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, options)) {
+        std::fprintf(stderr, "usage: ntp_responder [--bind addr] [--port n] [--offset-ms x] [--delay-ms x] "
+                             "[--asymmetry-ms x] [--stratum n] [--leap n] [--mode n] [--bad-origin] [--count n]\n");
+        return 2;
+    }
+    InitializeNetworking();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* local = nullptr;
+    if (getaddrinfo(options.bind.c_str(), options.port.c_str(), &hints, &local) != 0 || !local) {
+        std::fprintf(stderr, "cannot resolve %s\n", options.bind.c_str());
+        return 1;
+    }
+    SocketHandle sock = socket(local->ai_family, local->ai_socktype, local->ai_protocol);
+    if (sock == kInvalidSocket || bind(sock, local->ai_addr, static_cast<SockLen>(local->ai_addrlen)) != 0) {
+        std::fprintf(stderr, "cannot bind %s:%s\n", options.bind.c_str(), options.port.c_str());
+        freeaddrinfo(local);
+        return 1;
+    }
+    freeaddrinfo(local);
+    std::printf("ntp_responder on %s:%s offset=%.3fms delay=%.3fms asymmetry=%.3fms\n",
+                options.bind.c_str(), options.port.c_str(), options.offsetMs, options.delayMs, options.asymmetryMs);
+    std::fflush(stdout);
+
+    const int64_t offsetTicks = static_cast<int64_t>(options.offsetMs * 10000.0);
+    auto serverNow = [&]() { return SystemFileTime() + static_cast<uint64_t>(offsetTicks); };
+
+    for (long served = 0; options.count == 0 || served < options.count;) {
+        unsigned char buffer[512];
+        sockaddr_storage from = {};
+        SockLen fromLen = sizeof(from);
+        int received = static_cast<int>(recvfrom(sock, reinterpret_cast<char*>(buffer), static_cast<int>(sizeof(buffer)), 0,
+                                                 reinterpret_cast<sockaddr*>(&from), &fromLen));
+        NtpPacket request;
+        if (received < 0 || !DecodeNtpPacket(buffer, static_cast<size_t>(received), request) || request.mode != kNtpModeClient) {
+            continue;
+        }
+
+        SleepMs(options.delayMs + options.asymmetryMs); // request path
+        NtpPacket reply;
+        reply.receiveTime = NtpFromFileTime(serverNow());
+        reply.leap = static_cast<uint8_t>(options.leap);
+        reply.version = 4;
+        reply.mode = static_cast<uint8_t>(options.mode);
+        reply.stratum = static_cast<uint8_t>(options.stratum);
+        reply.precision = -20;
+        reply.referenceId = 0x4C4F434Cu; // "LOCL"
+        reply.originTime = options.badOrigin ? request.transmitTime + 1 : request.transmitTime;
+        reply.referenceTime = reply.receiveTime;
+        reply.transmitTime = NtpFromFileTime(serverNow());
+        EncodeNtpPacket(reply, buffer);
+        SleepMs(options.delayMs); // reply path
+        sendto(sock, reinterpret_cast<const char*>(buffer), static_cast<int>(kNtpPacketSize), 0,
+               reinterpret_cast<const sockaddr*>(&from), fromLen);
+        ++served;
+    }
+
+    CloseSocket(sock);
+    ShutdownNetworking();
+    return 0;
+}
@@ -0,0 +1,226 @@
+// Checks the bulk offset kernels against the per-instant city lookup.
+//
+// For each case (built-in DST cities, a fixed-offset city and IANA zones) an
+// OffsetTable is built over --from..--to (UTC years), in FILETIME ticks and
+// in Unix seconds, and every kernel this CPU supports converts the same
+// arrays: --random arbitrary instants plus the instants either side of every
+// transition, in an odd-sized batch so the vector tails run too. Each local
+// time and broken-down field must equal what GetCityOffsetMinutes and
+// CivilFromFileTime give. Exits 1 on any mismatch, 2 on bad usage or
+// missing zone data.
+//
+//   offset_kernel_check [--from 1970] [--to 2100] [--random 20000]
+//                       [--seed 1] [--zone Europe/Berlin]... [--all-zones]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/calendar.h"
+#include "core/city.h"
+#include "core/offset_table.h"
+#include "core/tzif.h"
+
+using namespace clockcore;
+
+namespace {
+
+struct Options {
+    int fromYear = 1970;
+    int toYear = 2100;
+    size_t randomPerCase = 20000;
+    uint64_t seed = 1;
+    std::vector<std::string> zones;
+    bool allZones = false;
+};
+
+constexpr const char* kDefaultZones[] = {"America/New_York", "America/Sao_Paulo", "Europe/Berlin", "Europe/London",
+                                         "Asia/Kolkata", "Asia/Tokyo", "Australia/Lord_Howe", "Australia/Sydney",
+                                         "Pacific/Auckland", "Pacific/Chatham", "Africa/Casablanca", "America/St_Johns"};
+
+constexpr OffsetKernel kKernels[] = {OffsetKernel::Scalar, OffsetKernel::Sse2, OffsetKernel::Avx2};
+
+struct Totals {
+    uint64_t cases = 0;
+    uint64_t instants = 0;
+    uint64_t mismatches = 0;
+    uint64_t skipped = 0;
+};
+
+uint64_t Utc(int year) {
+    CivilTime civil;
+    civil.year = year;
+    return FileTimeFromCivil(civil);
+}
+
+bool SameFields(const CivilTime& a, const CivilTime& b) {
+    return a.year == b.year && a.month == b.month && a.day == b.day && a.hour == b.hour && a.minute == b.minute &&
+           a.second == b.second && a.weekday == b.weekday;
+}
+
+void CheckCase(const std::string& label, const CityInfo& prototype, const Options& options, std::mt19937_64& random, Totals& totals) {
+    const uint64_t from = Utc(options.fromYear);
+    const uint64_t until = Utc(options.toYear + 1);
+
+    // Instants to convert, as FILETIME ticks on whole seconds so the same
+    // instants can be checked in Unix seconds.
+    CityInfo city = prototype;
+    PrimeCityCache(city, from);
+    std::vector<uint64_t> instants;
+    for (uint64_t t = from; city.offsetCache.validUntil > t && city.offsetCache.validUntil < until;) {
+        t = city.offsetCache.validUntil;
+        instants.insert(instants.end(), {t - kTicksPerSecond, t, t + kTicksPerSecond});
+        PrimeCityCache(city, t);
+    }
+    std::uniform_int_distribution<uint64_t> pick(0, (until - from) / kTicksPerSecond - 1);
+    for (size_t i = 0; i < options.randomPerCase; ++i) {
+        instants.push_back(from + pick(random) * kTicksPerSecond);
+    }
+    instants.push_back(from);
+    instants.push_back(until - kTicksPerSecond);
+    if (instants.size() % 4 == 0) {
+        instants.push_back(from + kTicksPerSecond); // leave a tail for the vector kernels
+    }
+    std::shuffle(instants.begin(), instants.end(), random);
+
+    std::vector<int64_t> expectedFileTime(instants.size());
+    std::vector<int64_t> expectedUnix(instants.size());
+    std::vector<int64_t> utcUnix(instants.size());
+    for (size_t i = 0; i < instants.size(); ++i) {
+        int offset = GetCityOffsetMinutes(city, instants[i]);
+        expectedFileTime[i] = static_cast<int64_t>(instants[i]) + offset * kTicksPerMinute;
+        utcUnix[i] = UnixSecondsFromFileTime(instants[i]);
+        expectedUnix[i] = utcUnix[i] + offset * 60;
+    }
+
+    ++totals.cases;
+    const struct {
+        TimeUnit unit;
+        const int64_t* utc;
+        const std::vector<int64_t>& expected;
+        int64_t from;
+        int64_t until;
+    } kUnits[] = {
+        {TimeUnit::FileTime, reinterpret_cast<const int64_t*>(instants.data()), expectedFileTime, static_cast<int64_t>(from),
+         static_cast<int64_t>(until)},
+        {TimeUnit::UnixSeconds, utcUnix.data(), expectedUnix, UnixSecondsFromFileTime(from), UnixSecondsFromFileTime(until)},
+    };
+    std::vector<int64_t> local(instants.size());
+    std::vector<CivilTime> fields(instants.size());
+    for (const auto& unit : kUnits) {
+        const char* unitName = unit.unit == TimeUnit::FileTime ? "filetime" : "unix";
+        OffsetTable table;
+        if (!table.Build(prototype, unit.unit, unit.from, unit.until)) {
+            std::printf("%s (%s): transitions too dense for a table, skipped\n", label.c_str(), unitName);
+            ++totals.skipped;
+            continue;
+        }
+        for (OffsetKernel kernel : kKernels) {
+            if (!IsOffsetKernelSupported(kernel)) {
+                continue;
+            }
+            table.ToLocal(unit.utc, local.data(), instants.size(), kernel);
+            totals.instants += instants.size();
+            for (size_t i = 0; i < instants.size(); ++i) {
+                if (local[i] != unit.expected[i]) {
+                    if (++totals.mismatches <= 20) {
+                        std::printf("%s (%s, %s): instant %lld: local %lld, expected %lld\n", label.c_str(), unitName,
+                                    OffsetKernelName(kernel), static_cast<long long>(unit.utc[i]), static_cast<long long>(local[i]),
+                                    static_cast<long long>(unit.expected[i]));
+                    }
+                }
+            }
+        }
+        table.ToLocalFields(unit.utc, fields.data(), instants.size());
+        for (size_t i = 0; i < instants.size(); ++i) {
+            if (!SameFields(fields[i], CivilFromFileTime(static_cast<uint64_t>(expectedFileTime[i])))) {
+                if (++totals.mismatches <= 20) {
+                    std::printf("%s (%s): fields of instant %lld differ\n", label.c_str(), unitName, static_cast<long long>(unit.utc[i]));
+                }
+            }
+        }
+    }
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--from") == 0 && hasValue) {
+            options.fromYear = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--to") == 0 && hasValue) {
+            options.toYear = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--random") == 0 && hasValue) {
+            options.randomPerCase = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--seed") == 0 && hasValue) {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--zone") == 0 && hasValue) {
+            options.zones.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--all-zones") == 0) {
+            options.allZones = true;
+        } else {
+            std::fprintf(stderr, "offset_kernel_check: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    if (options.fromYear < 1601 || options.toYear < options.fromYear || options.toYear > 9999) {
+        std::fprintf(stderr, "offset_kernel_check: bad year range %d-%d\n", options.fromYear, options.toYear);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+    if (options.allZones) {
+        options.zones = ListZoneIds();
+    } else if (options.zones.empty()) {
+        options.zones.assign(std::begin(kDefaultZones), std::end(kDefaultZones));
+    }
+
+    std::mt19937_64 random(options.seed);
+    Totals totals;
+    const struct {
+        const wchar_t* name;
+        int offsetMinutes;
+    } kRuleCities[] = {{L"New York", -300}, {L"Los Angeles", -480}, {L"London", 0}, {L"Berlin", 60},
+                       {L"Sydney", 600},    {L"Auckland", 720},     {L"Tokyo", 540}, {L"Kathmandu", 345}};
+    for (const auto& entry : kRuleCities) {
+        CityInfo city;
+        city.name = entry.name;
+        city.offsetMinutes = entry.offsetMinutes;
+        std::string label(entry.name, entry.name + std::wcslen(entry.name));
+        CheckCase(label + " (rules)", city, options, random, totals);
+    }
+    for (const auto& zoneId : options.zones) {
+        CityInfo city;
+        city.name = L"Zone";
+        city.offsetMinutes = 0;
+        city.zoneId = zoneId;
+        if (!LoadTimeZone(zoneId)) {
+            std::fprintf(stderr, "offset_kernel_check: cannot load zone %s from %s\n", zoneId.c_str(), ZoneInfoDirectory().string().c_str());
+            return 2;
+        }
+        CheckCase(zoneId, city, options, random, totals);
+    }
+
+    std::printf("offset_kernel_check: %llu cases (%llu tables skipped), %llu conversions, %llu mismatches; kernels:",
+                static_cast<unsigned long long>(totals.cases), static_cast<unsigned long long>(totals.skipped),
+                static_cast<unsigned long long>(totals.instants), static_cast<unsigned long long>(totals.mismatches));
+    for (OffsetKernel kernel : kKernels) {
+        if (IsOffsetKernelSupported(kernel)) {
+            std::printf(" %s", OffsetKernelName(kernel));
+        }
+    }
+    std::printf("\n");
+    return totals.mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+// Checks that the steady-state tick path performs no heap allocations.
+//
+// Replaces the global operator new with a counting one, sets up what the
+// window does once its city list is loaded (primed offset caches, line
+// widths, a paged layout and glyph cache on the software renderer), then
+// arms the counter and runs simulated ticks exactly as WM_APP_TICK and
+// WM_PAINT do: read the published clock, flip the page every kPageSeconds,
+// format the visible lines, draw them and record the paint time. Two runs
+// cross DST transitions (one-second steps over a US spring-forward, then
+// three-hour steps over a year) so offset cache refreshes are covered too,
+// and a live TickScheduler with a 1 ms period covers the scheduler thread.
+// Exits 1 if any allocation was counted; --abort stops at the first one so
+// a debugger shows where it came from.
+//
+//   tick_alloc_check [--cities 200] [--max-size 800x600] [--ticks 3000]
+//                    [--scheduler-ticks 2000] [--abort]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/calendar.h"
+#include "core/city_file.h"
+#include "core/clock_state.h"
+#include "core/clock_view.h"
+#include "core/metrics.h"
+#include "core/monotonic.h"
+#include "core/software_renderer.h"
+#include "core/tick_scheduler.h"
+
+using namespace clockcore;
+
+namespace {
+
+std::atomic<bool> g_counting{false};
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<size_t> g_firstAllocationSize{0};
+bool g_abortOnAllocation = false;
+
+void* CountedAllocate(size_t size, size_t alignment) {
+    if (g_counting.load(std::memory_order_relaxed)) {
+        if (g_allocations.fetch_add(1, std::memory_order_relaxed) == 0) {
+            g_firstAllocationSize.store(size, std::memory_order_relaxed);
+        }
+        if (g_abortOnAllocation) {
+            std::abort();
+        }
+    }
+    size = std::max<size_t>(size, 1);
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* block = nullptr;
+    return posix_memalign(&block, alignment, size) == 0 ? block : nullptr;
+#endif
+}
+
+void CountedFree(void* block, size_t alignment) {
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(block);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(block);
+}
+
+void* AllocateOrThrow(size_t size, size_t alignment) {
+    void* block = CountedAllocate(size, alignment);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+} // namespace
+
+void* operator new(size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new[](size_t size) { return AllocateOrThrow(size, 0); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return AllocateOrThrow(size, static_cast<size_t>(alignment)); }
+void operator delete(void* block) noexcept { CountedFree(block, 0); }
+void operator delete[](void* block) noexcept { CountedFree(block, 0); }
+void operator delete(void* block, size_t) noexcept { CountedFree(block, 0); }
+void operator delete[](void* block, size_t) noexcept { CountedFree(block, 0); }
+void operator delete(void* block, std::align_val_t alignment) noexcept { CountedFree(block, static_cast<size_t>(alignment)); }
+void operator delete[](void* block, std::align_val_t alignment) noexcept { CountedFree(block, static_cast<size_t>(alignment)); }
+void operator delete(void* block, size_t, std::align_val_t alignment) noexcept { CountedFree(block, static_cast<size_t>(alignment)); }
+void operator delete[](void* block, size_t, std::align_val_t alignment) noexcept { CountedFree(block, static_cast<size_t>(alignment)); }
+
+namespace {
+
+constexpr uint64_t kPageSeconds = 10; // as in the window
+
+struct Display {
+    std::vector<CityInfo> cities;
+    Framebuffer image;
+    SoftwareRenderer renderer;
+    ClockLineWidths widths;
+    ClockLayout layout;
+    ClockGlyphCache cache;
+    FrameText frame;
+    size_t page = 0;
+    Histogram paintDuration;
+
+    Display() : renderer(image, ClockFontPixelHeight(96)) {}
+
+    void Tick(uint64_t utc) {
+        if (layout.pageCount > 1 && utc / kTicksPerSecond % kPageSeconds == 0) {
+            page = (page + 1) % layout.pageCount;
+            cache.SetVisibleRange(renderer, layout.PageStart(page), layout.pageSize);
+        }
+        uint64_t start = MonotonicTicks();
+        FormatFrame(cities, utc, layout.PageStart(page), layout.pageSize, frame);
+        DrawClockView(renderer, image.width, image.height, frame, cache, layout);
+        paintDuration.Record(static_cast<int64_t>(MonotonicTicks() - start) / kTicksPerMicrosecond);
+    }
+};
+
+uint64_t Utc(int year, int month, int day, int hour) {
+    CivilTime civil;
+    civil.year = year;
+    civil.month = month;
+    civil.day = day;
+    civil.hour = hour;
+    return FileTimeFromCivil(civil);
+}
+
+bool Report(const char* phase, uint64_t ticks) {
+    g_counting = false;
+    uint64_t allocations = g_allocations.exchange(0);
+    if (allocations == 0) {
+        std::printf("%-34s %6llu ticks, no allocations\n", phase, static_cast<unsigned long long>(ticks));
+        return true;
+    }
+    std::printf("%-34s %6llu ticks, %llu allocations (first of %zu bytes)\n", phase, static_cast<unsigned long long>(ticks),
+                static_cast<unsigned long long>(allocations), g_firstAllocationSize.load());
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t cityCount = 200;
+    TextSize maxSize{800, 600};
+    uint64_t ticks = 3000;
+    uint64_t schedulerTicks = 2000;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--cities") == 0 && hasValue) {
+            cityCount = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--max-size") == 0 && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &maxSize.width, &maxSize.height) != 2) {
+                std::fprintf(stderr, "tick_alloc_check: bad --max-size %s\n", argv[i]);
+                return 2;
+            }
+        } else if (std::strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            ticks = static_cast<uint64_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--scheduler-ticks") == 0 && hasValue) {
+            schedulerTicks = static_cast<uint64_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--abort") == 0) {
+            g_abortOnAllocation = true;
+        } else {
+            std::fprintf(stderr, "tick_alloc_check: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // Rule-based cities from the defaults plus zone-based ones, repeated.
+    Display display;
+    std::vector<CityInfo> base = DefaultCities();
+    auto addCity = [&](const wchar_t* name, int offsetMinutes, const char* zoneId) {
+        CityInfo city;
+        city.name = name;
+        city.offsetMinutes = offsetMinutes;
+        city.zoneId = zoneId;
+        base.push_back(std::move(city));
+    };
+    addCity(L"New York", -300, "America/New_York");
+    addCity(L"Berlin", 60, "Europe/Berlin");
+    addCity(L"Sydney", 600, "Australia/Sydney");
+    addCity(L"Auckland", 720, "Pacific/Auckland");
+    addCity(L"London", 0, ""); // DST from the built-in rules
+    addCity(L"Chicago", -360, "");
+    const uint64_t springForward = Utc(2024, 3, 10, 6); // an hour before New York's change
+    for (size_t i = 0; i < cityCount; ++i) {
+        CityInfo city = base[i % base.size()];
+        if (i >= base.size()) {
+            city.name += L" " + std::to_wstring(i / base.size() + 1);
+        }
+        PrimeCityCache(city, springForward);
+        display.cities.push_back(std::move(city));
+    }
+    display.widths.Update(display.renderer, display.cities);
+    display.layout = LayoutClockView(display.widths, display.cities.size(), maxSize);
+    display.image.Resize(display.layout.client.width, display.layout.client.height);
+    display.cache.SetVisibleRange(display.renderer, 0, display.layout.pageSize);
+    display.cache.Build(display.renderer, display.cities);
+    std::printf("%zu cities in %d columns x %d rows, %zu pages, %dx%d\n", display.cities.size(), display.layout.columns,
+                display.layout.rows, display.layout.pageCount, display.image.width, display.image.height);
+
+    PublishedClock clock;
+    ClockSample sample;
+    sample.valid = true;
+    sample.baseUtc = springForward;
+    sample.baseMono = MonotonicTicks();
+    clock.Publish(sample);
+
+    // Warm-up: one rotation through every page rasterizes all labels.
+    for (size_t page = 0; page <= display.layout.pageCount; ++page) {
+        display.Tick(springForward - (display.layout.pageCount - page) * kPageSeconds * kTicksPerSecond);
+    }
+
+    bool ok = true;
+    g_counting = true;
+    for (uint64_t i = 0; i < ticks; ++i) {
+        uint64_t now = 0;
+        clock.TryNow(MonotonicTicks(), now);
+        display.Tick(springForward + i * kTicksPerSecond);
+    }
+    ok &= Report("1 s ticks over a DST change", ticks);
+
+    g_counting = true;
+    for (uint64_t i = 0; i < ticks; ++i) {
+        display.Tick(springForward + i * 3 * 3600 * kTicksPerSecond);
+    }
+    ok &= Report("3 h ticks over a year", ticks);
+
+    if (schedulerTicks > 0) {
+        std::atomic<uint64_t> fired{0};
+        std::atomic<uint64_t> pending{0};
+        TickSchedulerOptions options;
+        options.periodTicks = kTicksPerSecond / 1000;
+        MetricsRegistry registry;
+        options.metrics = &registry;
+        TickScheduler scheduler(&clock, [&](const TickEvent& tick) {
+            pending.store(tick.boundaryUtc, std::memory_order_relaxed);
+            fired.fetch_add(1, std::memory_order_relaxed);
+        }, options);
+        while (fired.load() < 10) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        g_counting = true;
+        uint64_t begin = fired.load();
+        while (fired.load() - begin < schedulerTicks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ok &= Report("TickScheduler at 1 ms", fired.load() - begin);
+        scheduler.Shutdown();
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,326 @@
+// Streams log records and rewrites their UTC timestamp into city-local ISO
+// 8601 times using the cities (offsets, DST rules, IANA zones) from
+// cities.txt. Memory use is bounded by the block size, however large the
+// input; --mmap maps a file instead of reading it.
+//
+//   tzconvert [--config-dir config] [--cities Berlin,Tokyo] [--field 0]
+//             [--delimiter ' '] [--keep-utc] [--mmap] [--block-mb 4]
+//             [-o output] [input | -]
+//
+// The timestamp is read at the start of field --field (0-based, split on
+// --delimiter) and replaced by one local time per city, joined by the
+// delimiter; --keep-utc keeps the original in front. Lines without a
+// timestamp pass through unchanged. Throughput goes to stderr.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "core/city_file.h"
+#include "core/mapped_file.h"
+#include "core/monotonic.h"
+#include "core/timestamp_text.h"
+
+using namespace clockcore;
+
+namespace {
+
+struct Options {
+    std::filesystem::path configDir = "config";
+    std::string cityNames; // comma-separated; empty selects every city
+    size_t field = 0;
+    char delimiter = ' ';
+    bool keepUtc = false;
+    bool useMmap = false;
+    size_t blockBytes = 4u << 20;
+    std::string output;
+    std::string input = "-";
+};
+
+struct Stats {
+    uint64_t bytes = 0;
+    uint64_t records = 0;
+    uint64_t converted = 0;
+};
+
+// Output is staged in one buffer and written once it passes the block size.
+class OutputBuffer {
+public:
+    OutputBuffer(FILE* file, size_t flushBytes) : file_(file), flushBytes_(flushBytes) { data_.resize(flushBytes * 2); }
+
+    char* Reserve(size_t n) {
+        if (used_ + n > data_.size()) {
+            Flush();
+            if (n > data_.size()) {
+                data_.resize(n);
+            }
+        }
+        return data_.data() + used_;
+    }
+    void Commit(size_t n) {
+        used_ += n;
+        if (used_ >= flushBytes_) {
+            Flush();
+        }
+    }
+    void Append(const char* text, size_t n) {
+        std::memcpy(Reserve(n), text, n);
+        Commit(n);
+    }
+    void Flush() {
+        if (used_ > 0) {
+            std::fwrite(data_.data(), 1, used_, file_);
+            used_ = 0;
+        }
+    }
+    bool failed() const { return std::ferror(file_) != 0; }
+
+private:
+    FILE* file_;
+    size_t flushBytes_;
+    std::vector<char> data_;
+    size_t used_ = 0;
+};
+
+class LineConverter {
+public:
+    LineConverter(std::vector<CityInfo> cities, const Options& options)
+        : cities_(std::move(cities)), formatters_(cities_.size()), options_(options) {}
+
+    // Converts one line, without its '\n'.
+    void Convert(const char* line, size_t length, OutputBuffer& out, Stats& stats) {
+        ++stats.records;
+        size_t fieldStart = 0;
+        for (size_t skipped = 0; skipped < options_.field; ++skipped) {
+            const void* next = std::memchr(line + fieldStart, options_.delimiter, length - fieldStart);
+            if (!next) {
+                out.Append(line, length);
+                out.Append("\n", 1);
+                return;
+            }
+            fieldStart = static_cast<size_t>(static_cast<const char*>(next) - line) + 1;
+        }
+
+        ParsedTimestamp stamp;
+        size_t consumed = ParseTimestamp(line + fieldStart, length - fieldStart, stamp);
+        size_t stampEnd = fieldStart + consumed;
+        bool boundary = stampEnd == length || !std::isalnum(static_cast<unsigned char>(line[stampEnd]));
+        if (consumed == 0 || !boundary) {
+            out.Append(line, length);
+            out.Append("\n", 1);
+            return;
+        }
+        ++stats.converted;
+
+        size_t worst = length + 1 + cities_.size() * (kMaxIsoTimestampLength + 1);
+        char* p = out.Reserve(worst);
+        char* start = p;
+        std::memcpy(p, line, options_.keepUtc ? stampEnd : fieldStart);
+        p += options_.keepUtc ? stampEnd : fieldStart;
+        for (size_t i = 0; i < cities_.size(); ++i) {
+            if (i > 0 || options_.keepUtc) {
+                *p++ = options_.delimiter;
+            }
+            int offset = GetCityOffsetMinutes(cities_[i], stamp.utc);
+            p += formatters_[i].Format(p, stamp.utc, offset, stamp.fractionDigits);
+        }
+        std::memcpy(p, line + stampEnd, length - stampEnd);
+        p += length - stampEnd;
+        *p++ = '\n';
+        out.Commit(static_cast<size_t>(p - start));
+    }
+
+    // Converts every complete line in [data, data + size); with final set the
+    // unterminated tail is converted too. Returns the bytes consumed.
+    size_t ConvertBlock(const char* data, size_t size, bool final, OutputBuffer& out, Stats& stats) {
+        size_t pos = 0;
+        while (pos < size) {
+            const void* newline = std::memchr(data + pos, '\n', size - pos);
+            if (!newline) {
+                if (!final) {
+                    break;
+                }
+                Convert(data + pos, size - pos, out, stats);
+                return size;
+            }
+            size_t end = static_cast<size_t>(static_cast<const char*>(newline) - data);
+            Convert(data + pos, end - pos, out, stats);
+            pos = end + 1;
+        }
+        return pos;
+    }
+
+private:
+    std::vector<CityInfo> cities_;
+    std::vector<IsoFormatter> formatters_;
+    const Options& options_;
+};
+
+bool SelectCities(const std::vector<CityInfo>& all, const std::string& names, std::vector<CityInfo>& selected) {
+    if (names.empty()) {
+        selected = all;
+        return true;
+    }
+    size_t start = 0;
+    while (start <= names.size()) {
+        size_t comma = names.find(',', start);
+        std::wstring name = WideFromUtf8(names.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+        auto it = std::find_if(all.begin(), all.end(), [&](const CityInfo& city) { return city.name == name; });
+        if (it == all.end()) {
+            std::fprintf(stderr, "tzconvert: unknown city %s\n", Utf8FromWide(name).c_str());
+            return false;
+        }
+        selected.push_back(*it);
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--config-dir") == 0 && hasValue) {
+            options.configDir = argv[++i];
+        } else if (std::strcmp(argv[i], "--cities") == 0 && hasValue) {
+            options.cityNames = argv[++i];
+        } else if (std::strcmp(argv[i], "--field") == 0 && hasValue) {
+            options.field = static_cast<size_t>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--delimiter") == 0 && hasValue) {
+            ++i;
+            options.delimiter = std::strcmp(argv[i], "\\t") == 0 ? '\t' : argv[i][0];
+        } else if (std::strcmp(argv[i], "--keep-utc") == 0) {
+            options.keepUtc = true;
+        } else if (std::strcmp(argv[i], "--mmap") == 0) {
+            options.useMmap = true;
+        } else if (std::strcmp(argv[i], "--block-mb") == 0 && hasValue) {
+            options.blockBytes = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) << 20;
+        } else if (std::strcmp(argv[i], "-o") == 0 && hasValue) {
+            options.output = argv[++i];
+        } else if (argv[i][0] != '-' || std::strcmp(argv[i], "-") == 0) {
+            options.input = argv[i];
+        } else {
+            std::fprintf(stderr, "tzconvert: unknown option %s\n", argv[i]);
+            return false;
+        }
+    }
+    if (options.delimiter == '\0' || options.delimiter == '\n') {
+        std::fprintf(stderr, "tzconvert: bad delimiter\n");
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::vector<CityInfo> all;
+    if (!LoadCityFile(options.configDir / "cities.txt", all) || all.empty()) {
+        all = DefaultCities();
+    }
+    std::vector<CityInfo> cities;
+    if (!SelectCities(all, options.cityNames, cities)) {
+        return 2;
+    }
+    uint64_t now = SystemFileTime();
+    for (auto& city : cities) {
+        PrimeCityCache(city, now);
+    }
+    LineConverter converter(std::move(cities), options);
+
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    FILE* outFile = options.output.empty() ? stdout : std::fopen(options.output.c_str(), "wb");
+    if (!outFile) {
+        std::fprintf(stderr, "tzconvert: cannot open %s\n", options.output.c_str());
+        return 1;
+    }
+    OutputBuffer out(outFile, options.blockBytes);
+    Stats stats;
+    auto start = std::chrono::steady_clock::now();
+
+    if (options.useMmap && options.input != "-") {
+        MappedFile mapped;
+        if (!mapped.Open(options.input)) {
+            std::fprintf(stderr, "tzconvert: cannot map %s\n", options.input.c_str());
+            return 1;
+        }
+        const char* data = reinterpret_cast<const char*>(mapped.data());
+        converter.ConvertBlock(data, mapped.size(), true, out, stats);
+        stats.bytes = mapped.size();
+    } else {
+        FILE* inFile = options.input == "-" ? stdin : std::fopen(options.input.c_str(), "rb");
+        if (!inFile) {
+            std::fprintf(stderr, "tzconvert: cannot open %s\n", options.input.c_str());
+            return 1;
+        }
+        std::vector<char> block(options.blockBytes);
+        size_t have = 0;
+        bool overlong = false; // inside a line longer than the block: copy it through
+        for (;;) {
+            size_t n = std::fread(block.data() + have, 1, block.size() - have, inFile);
+            stats.bytes += n;
+            have += n;
+            bool eof = n == 0;
+            size_t pos = 0;
+            if (overlong) {
+                const void* newline = std::memchr(block.data(), '\n', have);
+                pos = newline ? static_cast<size_t>(static_cast<const char*>(newline) - block.data()) + 1 : have;
+                out.Append(block.data(), pos);
+                overlong = newline == nullptr;
+            }
+            pos += converter.ConvertBlock(block.data() + pos, have - pos, eof, out, stats);
+            if (eof) {
+                break;
+            }
+            if (pos == 0 && have == block.size()) {
+                out.Append(block.data(), have);
+                ++stats.records;
+                overlong = true;
+                pos = have;
+            }
+            std::memmove(block.data(), block.data() + pos, have - pos);
+            have -= pos;
+        }
+        if (inFile != stdin) {
+            std::fclose(inFile);
+        }
+    }
+    out.Flush();
+    bool failed = out.failed();
+    if (outFile != stdout) {
+        failed = std::fclose(outFile) != 0 || failed;
+    } else {
+        std::fflush(stdout);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "tzconvert: %llu records (%llu converted), %.1f MB in %.3f s: %.3f GB/s, %.2f M records/s\n",
+                 static_cast<unsigned long long>(stats.records), static_cast<unsigned long long>(stats.converted),
+                 static_cast<double>(stats.bytes) / 1e6, seconds, static_cast<double>(stats.bytes) / 1e9 / seconds,
+                 static_cast<double>(stats.records) / 1e6 / seconds);
+    if (failed) {
+        std::fprintf(stderr, "tzconvert: write failed\n");
+        return 1;
+    }
+    return 0;
+}
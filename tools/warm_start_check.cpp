@@ -0,0 +1,192 @@
+// Checks the warm-start math and the clock_state.txt format.
+//
+// Builds saved states by hand and checks EstimateWarmStart() against the
+// values worked out from clock_warm_start.h: drift and error bound growth
+// with age, rejection when the host clock went backwards or the bound
+// passes 1 s, the startup sync delay (limited by the saved poll interval or
+// by the bound going stale), and dropping the frequency when the state was
+// saved against another monotonic source. Then round-trips a state through
+// SaveWarmStart / LoadWarmStart and loads missing, truncated and malformed
+// files. Exits 1 on any failed check.
+//
+//   warm_start_check [--dir /tmp]
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "core/calendar.h"
+#include "core/clock_discipline.h"
+#include "core/clock_state.h"
+#include "core/clock_warm_start.h"
+#include "core/monotonic.h"
+
+using namespace clockcore;
+
+namespace {
+
+int g_checks = 0;
+int g_failures = 0;
+
+void Check(bool ok, const char* what) {
+    ++g_checks;
+    if (!ok) {
+        ++g_failures;
+        std::printf("FAILED: %s\n", what);
+    }
+}
+
+constexpr uint64_t kSavedAt = 133500000000000000ull; // some FILETIME in 2024
+constexpr uint64_t kMonoNow = 5000 * kTicksPerSecond;
+
+WarmStartState BaseState() {
+    WarmStartState state;
+    state.systemUtc = kSavedAt;
+    state.offsetTicks = 2500000;    // 250 ms
+    state.frequencyPpb = 10000;     // 10 ppm
+    state.uncertaintyTicks = 10000; // 1 ms
+    state.pollSeconds = 64;
+    state.monotonicSource = MonotonicSourceName(ActiveMonotonicSource());
+    return state;
+}
+
+void CheckEstimates() {
+    WarmStartState state = BaseState();
+
+    // Right after saving: the saved offset, fresh, sync at the next poll.
+    auto now = EstimateWarmStart(state, kMonoNow, kSavedAt);
+    Check(now.has_value(), "a just-saved state is usable");
+    if (now) {
+        Check(now->clock.valid && now->clock.baseMono == kMonoNow && now->clock.baseUtc == kSavedAt + 2500000,
+              "a just-saved state gives the saved offset");
+        Check(now->uncertaintyTicks == 10000 && now->ageTicks == 0, "no age, no growth");
+        Check(now->frequencyKnown && now->clock.frequencyPpb == 10000, "same source keeps the frequency");
+        Check(now->syncDelaySeconds == 64, "a fresh state waits the saved poll interval");
+    }
+
+    // 100 s later: 10 ppm of drift (1 ms), bound grown at 15 + 10 ppm (2.5 ms).
+    uint64_t later = kSavedAt + 100 * kTicksPerSecond;
+    auto aged = EstimateWarmStart(state, kMonoNow, later);
+    Check(aged.has_value(), "a 100 s old state is usable");
+    if (aged) {
+        Check(aged->clock.baseUtc == later + 2500000 + 10000, "drift is age times the saved frequency");
+        Check(aged->uncertaintyTicks == 10000 + 25000, "the bound grows at PHI plus |frequency|");
+        Check(aged->syncDelaySeconds == 0, "past the poll interval the sync runs now");
+    }
+    state.frequencyPpb = -10000;
+    aged = EstimateWarmStart(state, kMonoNow, later);
+    Check(aged && aged->clock.baseUtc == later + 2500000 - 10000 && aged->uncertaintyTicks == 35000,
+          "a negative frequency drifts back and still widens the bound");
+    state.frequencyPpb = 10000;
+
+    // Sync delay limited by the bound going stale: 49 ms saved, 1 ms to go
+    // at 25 ppm is 40 s, well inside a 1024 s poll.
+    state.uncertaintyTicks = kWarmStartFreshTicks - 10000;
+    state.pollSeconds = 1024;
+    auto nearlyStale = EstimateWarmStart(state, kMonoNow, kSavedAt);
+    Check(nearlyStale && nearlyStale->syncDelaySeconds == 40, "the delay ends when the bound reaches the fresh limit");
+    state.uncertaintyTicks = kWarmStartFreshTicks;
+    auto stale = EstimateWarmStart(state, kMonoNow, kSavedAt);
+    Check(stale && stale->syncDelaySeconds == 0, "a bound at the fresh limit syncs now");
+    state = BaseState();
+
+    // The host clock set back below the save time.
+    Check(!EstimateWarmStart(state, kMonoNow, kSavedAt - 1), "a host clock earlier than the save is rejected");
+
+    // The bound passing 1 s: 999 ms of growth at 25 ppm takes 39960 s.
+    uint64_t lastUsable = kSavedAt + 39960 * kTicksPerSecond;
+    auto edge = EstimateWarmStart(state, kMonoNow, lastUsable);
+    Check(edge && edge->uncertaintyTicks == kWarmStartMaxUncertaintyTicks, "a bound of exactly 1 s is still usable");
+    Check(!EstimateWarmStart(state, kMonoNow, lastUsable + kTicksPerSecond), "a bound past 1 s is rejected");
+    state.uncertaintyTicks = kWarmStartMaxUncertaintyTicks + 1;
+    Check(!EstimateWarmStart(state, kMonoNow, kSavedAt), "a saved bound past 1 s is rejected");
+    state = BaseState();
+
+    // Saved against another monotonic source, or one not recorded.
+    for (const char* other : {"some-other-source", ""}) {
+        state.monotonicSource = other;
+        auto foreign = EstimateWarmStart(state, kMonoNow, later);
+        Check(foreign.has_value(), "another source's state is still usable");
+        if (foreign) {
+            Check(!foreign->frequencyKnown && foreign->clock.frequencyPpb == 0, "another source's frequency is dropped");
+            Check(foreign->clock.baseUtc == later + 2500000, "no drift without a frequency");
+            Check(foreign->uncertaintyTicks == 35000, "the bound still allows for the saved frequency");
+            Check(foreign->syncDelaySeconds == 0, "another source's state never defers the sync");
+        }
+    }
+
+    // Capturing and estimating at the same instant reproduces the clock.
+    ClockSample clock;
+    clock.baseUtc = kSavedAt + 2500000;
+    clock.baseMono = kMonoNow;
+    clock.frequencyPpb = 20000;
+    clock.valid = true;
+    uint64_t monoThen = kMonoNow + 30 * kTicksPerSecond;
+    WarmStartState captured = CaptureWarmStart(clock, 7000, 128, monoThen, kSavedAt + 30 * kTicksPerSecond);
+    auto replay = EstimateWarmStart(captured, monoThen, kSavedAt + 30 * kTicksPerSecond);
+    Check(replay && ExtrapolateUtc(replay->clock, monoThen) == ExtrapolateUtc(clock, monoThen), "capture then estimate is the identity");
+    Check(captured.uncertaintyTicks == 7000 && captured.pollSeconds == 128 && captured.frequencyPpb == 20000,
+          "capture keeps bound, poll and frequency");
+}
+
+bool WriteText(const std::filesystem::path& path, const char* text) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    return static_cast<bool>(out << text);
+}
+
+void CheckFiles(const std::filesystem::path& dir) {
+    std::filesystem::path path = dir / "warm_start_check_state.txt";
+
+    WarmStartState state = BaseState();
+    state.offsetTicks = -123456789;
+    Check(SaveWarmStart(path, state), "save succeeds");
+    auto loaded = LoadWarmStart(path);
+    Check(loaded && loaded->systemUtc == state.systemUtc && loaded->offsetTicks == state.offsetTicks &&
+              loaded->frequencyPpb == state.frequencyPpb && loaded->uncertaintyTicks == state.uncertaintyTicks &&
+              loaded->pollSeconds == state.pollSeconds && loaded->monotonicSource == state.monotonicSource,
+          "save then load round-trips every field");
+    std::error_code error;
+    Check(!std::filesystem::exists(dir / "warm_start_check_state.txt.tmp", error), "the temporary file is renamed away");
+
+    Check(WriteText(path, "system_utc 1\noffset_ticks 2\nfrequency_ppb 3\nuncertainty_ticks 4\n"), "write an old-format file");
+    loaded = LoadWarmStart(path);
+    Check(loaded && loaded->pollSeconds == 0 && loaded->monotonicSource.empty(), "poll and source are optional");
+
+    Check(WriteText(path, "system_utc 1\noffset_ticks 2\nfrequency_ppb 3\nuncertainty_t"), "write a truncated file");
+    Check(!LoadWarmStart(path), "a truncated file is rejected");
+    Check(WriteText(path, "system_utc 1\noffset_ticks two\nfrequency_ppb 3\nuncertainty_ticks 4\n"), "write a malformed file");
+    Check(!LoadWarmStart(path), "a malformed value is rejected");
+    Check(WriteText(path, "system_utc 1\noffset_ticks 2\nfrequency_ppb 3\nuncertainty_ticks -4\n"), "write a negative bound");
+    Check(!LoadWarmStart(path), "a negative bound is rejected");
+    Check(WriteText(path, "system_utc 1\noffset_ticks 2\nfrequency_ppb 900000000\nuncertainty_ticks 4\n"), "write a wild frequency");
+    loaded = LoadWarmStart(path);
+    Check(loaded && loaded->frequencyPpb == kMaxFrequencyPpb, "the frequency is clamped");
+    Check(WriteText(path, ""), "write an empty file");
+    Check(!LoadWarmStart(path), "an empty file is rejected");
+
+    std::filesystem::remove(path, error);
+    Check(!LoadWarmStart(path), "a missing file is rejected");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::error_code error;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(error);
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--dir") == 0 && hasValue) {
+            dir = argv[++i];
+        } else {
+            std::fprintf(stderr, "warm_start_check: unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    CheckEstimates();
+    CheckFiles(dir);
+    std::printf("warm_start_check: %d checks, %d failures\n", g_checks, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}